@@ -0,0 +1,264 @@
+/*------------------------------------------------------------------------------
+Copyright 2024 Munich Quantum Software Stack Project
+
+Licensed under the Apache License, Version 2.0 with LLVM Exceptions (the
+"License"); you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+https://github.com/Munich-Quantum-Software-Stack/QDMI/blob/develop/LICENSE
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+License for the specific language governing permissions and limitations under
+the License.
+
+SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+------------------------------------------------------------------------------*/
+
+/** @file
+ * @brief Throughput benchmarks of retrieving the results of jobs.
+ * @details For every kind of result and both example devices, a job is run
+ * once and its result is then retrieved repeatedly into a buffer of sufficient
+ * size. The results depending on the shots are measured from 10^3 to 10^7
+ * shots; the state vector and probabilities do not depend on them. The C++
+ * example device is loaded with 5 to 28 qubits from a device description,
+ * while the C example device always has 5 qubits. The program of every job
+ * entangles all qubits of the device. Besides the time per call, the
+ * throughput in bytes of returned data per second and the number of heap
+ * allocations per call are reported.
+ *
+ * Additionally, the time to run a job from its creation until it is done is
+ * measured for both example devices, which is dominated by simulating the
+ * program and sampling the shots, as well as the time of the first histogram
+ * request of a job, which includes computing the histogram.
+ */
+
+#include "bench_utils.hpp"
+#include "qdmi/client.h"
+
+#include <array>
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+/**
+ * @brief Generate a program preparing a GHZ state on all qubits of a device.
+ * @param device the device.
+ * @return the program in OpenQASM 2.
+ */
+std::string Spanning_program(QDMI_Device device) {
+  size_t num_qubits = 0;
+  QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_QUBITSNUM,
+                             sizeof(size_t), &num_qubits, nullptr);
+  std::string input = "OPENQASM 2.0;\n"
+                      "include \"qelib1.inc\";\n"
+                      "qreg q[" +
+                      std::to_string(num_qubits) + "];\nh q[0];\n";
+  for (size_t i = 1; i < num_qubits; ++i) {
+    input += "cx q[" + std::to_string(i - 1) + "], q[" + std::to_string(i) +
+             "];\n";
+  }
+  return input;
+}
+
+/**
+ * @brief Run a job with a number of shots to completion.
+ * @param device the device.
+ * @param input the program of the job.
+ * @param shots the number of shots.
+ * @return the finished job, or `nullptr` if the job failed.
+ */
+QDMI_Job Run_job(QDMI_Device device, const std::string &input,
+                 const size_t shots) {
+  QDMI_Job job = nullptr;
+  if (QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                              input.length() + 1, input.c_str(),
+                              &job) != QDMI_SUCCESS) {
+    return nullptr;
+  }
+  if (QDMI_control_set_parameter(device, job, QDMI_JOB_PARAMETER_SHOTS_NUM,
+                                 sizeof(size_t), &shots) != QDMI_SUCCESS ||
+      QDMI_control_submit_job(device, job) != QDMI_SUCCESS ||
+      QDMI_control_wait(device, job) != QDMI_SUCCESS) {
+    QDMI_control_free_job(device, job);
+    return nullptr;
+  }
+  return job;
+}
+
+void BM_Get_data(benchmark::State &state, const Device_library &library,
+                 const QDMI_Job_Result result) {
+  const auto shots = static_cast<size_t>(state.range(0));
+  const DriverSession driver(library, 1, static_cast<size_t>(state.range(1)));
+  auto *device = driver.ok() ? driver.devices[0] : nullptr;
+  auto *job = device != nullptr
+                  ? Run_job(device, Spanning_program(device), shots)
+                  : nullptr;
+  size_t size = 0;
+  if (job == nullptr || QDMI_control_get_data(device, job, result, 0, nullptr,
+                                              &size) != QDMI_SUCCESS) {
+    if (job != nullptr) {
+      QDMI_control_free_job(device, job);
+    }
+    state.SkipWithError("Failed to run the job");
+    return;
+  }
+  size_t num_qubits = 0;
+  QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_QUBITSNUM,
+                             sizeof(size_t), &num_qubits, nullptr);
+  std::vector<char> buffer(size);
+  const auto allocations_before = Num_allocations();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(QDMI_control_get_data(
+        device, job, result, buffer.size(), buffer.data(), nullptr));
+    benchmark::ClobberMemory();
+  }
+  const auto allocations = Num_allocations() - allocations_before;
+  QDMI_control_free_job(device, job);
+
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+  state.counters["qubits"] = static_cast<double>(num_qubits);
+  state.counters["shots"] = static_cast<double>(shots);
+  if (Allocations_counted()) {
+    state.counters["allocs_per_call"] = benchmark::Counter(
+        static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+  }
+}
+
+void BM_Run_job(benchmark::State &state, const Device_library &library) {
+  const DriverSession driver(library, 1, static_cast<size_t>(state.range(1)));
+  if (!driver.ok()) {
+    state.SkipWithError("Failed to initialize the driver");
+    return;
+  }
+  auto *device = driver.devices[0];
+  const auto shots = static_cast<size_t>(state.range(0));
+  const auto input = Spanning_program(device);
+  for (auto _ : state) {
+    auto *job = Run_job(device, input, shots);
+    if (job == nullptr) {
+      state.SkipWithError("Failed to run the job");
+      return;
+    }
+    QDMI_control_free_job(device, job);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(shots));
+  state.counters["qubits"] = static_cast<double>(state.range(1));
+  state.counters["shots"] = static_cast<double>(shots);
+}
+
+void BM_Get_histogram_first(benchmark::State &state,
+                            const Device_library &library) {
+  const DriverSession driver(library, 1, static_cast<size_t>(state.range(1)));
+  if (!driver.ok()) {
+    state.SkipWithError("Failed to initialize the driver");
+    return;
+  }
+  auto *device = driver.devices[0];
+  const auto shots = static_cast<size_t>(state.range(0));
+  const auto input = Spanning_program(device);
+  std::vector<char> keys;
+  std::vector<size_t> values;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto *job = Run_job(device, input, shots);
+    if (job == nullptr) {
+      state.SkipWithError("Failed to run the job");
+      return;
+    }
+    state.ResumeTiming();
+    size_t size = 0;
+    QDMI_control_get_data(device, job, QDMI_JOB_RESULT_HIST_KEYS, 0, nullptr,
+                          &size);
+    keys.resize(size);
+    QDMI_control_get_data(device, job, QDMI_JOB_RESULT_HIST_KEYS, size,
+                          keys.data(), nullptr);
+    QDMI_control_get_data(device, job, QDMI_JOB_RESULT_HIST_VALUES, 0, nullptr,
+                          &size);
+    values.resize(size / sizeof(size_t));
+    QDMI_control_get_data(device, job, QDMI_JOB_RESULT_HIST_VALUES, size,
+                          values.data(), nullptr);
+    benchmark::ClobberMemory();
+    state.PauseTiming();
+    QDMI_control_free_job(device, job);
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(shots));
+  state.counters["qubits"] = static_cast<double>(state.range(1));
+  state.counters["shots"] = static_cast<double>(shots);
+}
+
+/**
+ * @brief Register the benchmarks for all kinds of results and devices.
+ * @return true.
+ */
+bool Register_get_data_benchmarks() {
+  // the libraries and the numbers of qubits their devices are loaded with,
+  // where the C example device always has 5 qubits
+  const std::array<
+      std::tuple<const char *, Device_library, std::vector<int64_t>>, 2>
+      libraries{{{"c", C_DEVICE, {5}},
+                 {"cxx", CXX_DEVICE, {5, 10, 15, 20, 24, 28}}}};
+  // the kinds of results and whether they depend on the number of shots
+  constexpr std::array<std::pair<QDMI_Job_Result, bool>, 9> results{
+      {{QDMI_JOB_RESULT_SHOTS, true},
+       {QDMI_JOB_RESULT_HIST_KEYS, true},
+       {QDMI_JOB_RESULT_HIST_VALUES, true},
+       {QDMI_JOB_RESULT_STATEVECTOR_DENSE, false},
+       {QDMI_JOB_RESULT_PROBABILITIES_DENSE, false},
+       {QDMI_JOB_RESULT_STATEVECTOR_SPARSE_KEYS, false},
+       {QDMI_JOB_RESULT_STATEVECTOR_SPARSE_VALUES, false},
+       {QDMI_JOB_RESULT_PROBABILITIES_SPARSE_KEYS, false},
+       {QDMI_JOB_RESULT_PROBABILITIES_SPARSE_VALUES, false}}};
+  constexpr std::array<const char *, 9> result_names{
+      "shots",
+      "hist_keys",
+      "hist_values",
+      "statevec_dense",
+      "probs_dense",
+      "statevec_sparse_keys",
+      "statevec_sparse_values",
+      "probs_sparse_keys",
+      "probs_sparse_values"};
+  for (const auto &[library_name, library, qubits] : libraries) {
+    // the job is executed by the worker thread of the device
+    const auto run_name = std::string("BM_Run_job/") + library_name;
+    benchmark::RegisterBenchmark(run_name.c_str(), BM_Run_job, library)
+        ->Unit(benchmark::kMicrosecond)
+        ->UseRealTime()
+        ->ArgNames({"shots", "qubits"})
+        ->ArgsProduct({benchmark::CreateRange(1000, 1000000, 10), qubits});
+    const auto hist_name =
+        std::string("BM_Get_histogram_first/") + library_name;
+    benchmark::RegisterBenchmark(hist_name.c_str(), BM_Get_histogram_first,
+                                 library)
+        ->Unit(benchmark::kMicrosecond)
+        ->ArgNames({"shots", "qubits"})
+        ->ArgsProduct({benchmark::CreateRange(1000, 1000000, 10), qubits});
+    for (size_t i = 0; i < results.size(); ++i) {
+      const auto [result, depends_on_shots] = results[i];
+      const auto name = std::string("BM_Get_data/") + library_name + "/" +
+                        result_names[i];
+      auto *benchmark = benchmark::RegisterBenchmark(
+          name.c_str(), BM_Get_data, library, result);
+      benchmark->Unit(benchmark::kMicrosecond)->ArgNames({"shots", "qubits"});
+      if (depends_on_shots) {
+        benchmark->ArgsProduct(
+            {benchmark::CreateRange(1000, 10000000, 10), qubits});
+      } else {
+        benchmark->ArgsProduct({{1000}, qubits});
+      }
+    }
+  }
+  return true;
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp)
+const bool GET_DATA_BENCHMARKS_REGISTERED = Register_get_data_benchmarks();
+} // namespace
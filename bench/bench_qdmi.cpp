@@ -0,0 +1,293 @@
+/*------------------------------------------------------------------------------
+Copyright 2024 Munich Quantum Software Stack Project
+
+Licensed under the Apache License, Version 2.0 with LLVM Exceptions (the
+"License"); you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+https://github.com/Munich-Quantum-Software-Stack/QDMI/blob/develop/LICENSE
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+License for the specific language governing permissions and limitations under
+the License.
+
+SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+------------------------------------------------------------------------------*/
+
+/** @file
+ * @brief Benchmarks of the dispatch and query overhead of the example driver.
+ * @details Every benchmark is run for both example devices. The devices are
+ * loaded through the driver, so the measured times include the dispatch of the
+ * driver, e.g., its permission checks, property cache, and call statistics.
+ */
+
+#include "bench_utils.hpp"
+#include "qdmi/client.h"
+#include "qdmi_example_driver.h"
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+/// A property of fixed size that is cached by the driver.
+void BM_Query_device_property_cached(benchmark::State &state,
+                                     const Device_library &library) {
+  const DriverSession driver(library, 1);
+  if (!driver.ok()) {
+    state.SkipWithError("Failed to initialize the driver");
+    return;
+  }
+  for (auto _ : state) {
+    size_t num_qubits = 0;
+    benchmark::DoNotOptimize(QDMI_query_device_property(
+        driver.devices[0], QDMI_DEVICE_PROPERTY_QUBITSNUM, sizeof(size_t),
+        &num_qubits, nullptr));
+    benchmark::DoNotOptimize(num_qubits);
+  }
+}
+
+/// A property of fixed size that is always forwarded to the device.
+void BM_Query_device_property_uncached(benchmark::State &state,
+                                       const Device_library &library) {
+  const DriverSession driver(library, 1);
+  if (!driver.ok()) {
+    state.SkipWithError("Failed to initialize the driver");
+    return;
+  }
+  for (auto _ : state) {
+    QDMI_Device_Status status{};
+    benchmark::DoNotOptimize(QDMI_query_device_property(
+        driver.devices[0], QDMI_DEVICE_PROPERTY_STATUS,
+        sizeof(QDMI_Device_Status), &status, nullptr));
+    benchmark::DoNotOptimize(status);
+  }
+}
+
+void BM_Query_site_property(benchmark::State &state,
+                            const Device_library &library) {
+  const DriverSession driver(library, 1);
+  QDMI_Site site = nullptr;
+  if (!driver.ok() || QDMI_query_get_sites(driver.devices[0], 1, &site,
+                                           nullptr) != QDMI_SUCCESS) {
+    state.SkipWithError("Failed to obtain a site");
+    return;
+  }
+  for (auto _ : state) {
+    double t1 = 0;
+    benchmark::DoNotOptimize(
+        QDMI_query_site_property(driver.devices[0], site,
+                                 QDMI_SITE_PROPERTY_TIME_T1, sizeof(double),
+                                 &t1, nullptr));
+    benchmark::DoNotOptimize(t1);
+  }
+}
+
+void BM_Query_operation_property(benchmark::State &state,
+                                 const Device_library &library) {
+  const DriverSession driver(library, 1);
+  std::vector<QDMI_Site> sites(2);
+  auto *operation =
+      driver.ok() ? Find_operation(driver.devices[0], "cx") : nullptr;
+  if (operation == nullptr ||
+      QDMI_query_get_sites(driver.devices[0], sites.size(), sites.data(),
+                           nullptr) != QDMI_SUCCESS) {
+    state.SkipWithError("Failed to obtain the operation");
+    return;
+  }
+  for (auto _ : state) {
+    double fidelity = 0;
+    benchmark::DoNotOptimize(QDMI_query_operation_property(
+        driver.devices[0], operation, sites.size(), sites.data(),
+        QDMI_OPERATION_PROPERTY_FIDELITY, sizeof(double), &fidelity,
+        nullptr));
+    benchmark::DoNotOptimize(fidelity);
+  }
+}
+
+/**
+ * @brief Query the fidelity of every edge of a growing grid of qubits.
+ * @param batched whether all edges are queried in a single call, which
+ * isolates the lookup of the device from the dispatch of the driver.
+ */
+void BM_Query_edge_fidelities(benchmark::State &state, const bool batched) {
+  const auto num_qubits = static_cast<size_t>(state.range(0));
+  const DriverSession driver(CXX_DEVICE, 1, num_qubits);
+  auto *operation =
+      driver.ok() ? Find_operation(driver.devices[0], "cx") : nullptr;
+  size_t size = 0;
+  if (operation == nullptr ||
+      QDMI_query_device_property(driver.devices[0],
+                                 QDMI_DEVICE_PROPERTY_COUPLINGMAP, 0, nullptr,
+                                 &size) != QDMI_SUCCESS) {
+    state.SkipWithError("Failed to obtain the coupling map");
+    return;
+  }
+  std::vector<QDMI_Site> coupling_map(size / sizeof(QDMI_Site));
+  QDMI_query_device_property(driver.devices[0],
+                             QDMI_DEVICE_PROPERTY_COUPLINGMAP, size,
+                             coupling_map.data(), nullptr);
+  const size_t num_edges = coupling_map.size() / 2;
+  std::vector<double> fidelities(num_edges);
+  std::vector<int> status(num_edges);
+  for (auto _ : state) {
+    if (batched) {
+      benchmark::DoNotOptimize(QDMI_query_operation_properties(
+          driver.devices[0], operation, num_edges, 2, coupling_map.data(),
+          QDMI_OPERATION_PROPERTY_FIDELITY, sizeof(double), fidelities.data(),
+          status.data()));
+      benchmark::DoNotOptimize(fidelities.data());
+      continue;
+    }
+    for (size_t i = 0; i < coupling_map.size(); i += 2) {
+      double fidelity = 0;
+      benchmark::DoNotOptimize(QDMI_query_operation_property(
+          driver.devices[0], operation, 2, &coupling_map[i],
+          QDMI_OPERATION_PROPERTY_FIDELITY, sizeof(double), &fidelity,
+          nullptr));
+      benchmark::DoNotOptimize(fidelity);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(num_edges));
+}
+
+/// Query the size of a string property first and then its value.
+void BM_Query_two_call_string(benchmark::State &state,
+                              const Device_library &library) {
+  const DriverSession driver(library, 1);
+  if (!driver.ok()) {
+    state.SkipWithError("Failed to initialize the driver");
+    return;
+  }
+  for (auto _ : state) {
+    size_t size = 0;
+    QDMI_query_device_property(driver.devices[0], QDMI_DEVICE_PROPERTY_NAME,
+                               0, nullptr, &size);
+    std::string name(size, '\0');
+    benchmark::DoNotOptimize(QDMI_query_device_property(
+        driver.devices[0], QDMI_DEVICE_PROPERTY_NAME, size, name.data(),
+        nullptr));
+    benchmark::DoNotOptimize(name.data());
+  }
+}
+
+/// Query a string property into a buffer that is known to be large enough.
+void BM_Query_one_call_string(benchmark::State &state,
+                              const Device_library &library) {
+  const DriverSession driver(library, 1);
+  if (!driver.ok()) {
+    state.SkipWithError("Failed to initialize the driver");
+    return;
+  }
+  std::string name(256, '\0');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(QDMI_query_device_property(
+        driver.devices[0], QDMI_DEVICE_PROPERTY_NAME, name.size(),
+        name.data(), nullptr));
+    benchmark::DoNotOptimize(name.data());
+  }
+}
+
+/// Query the number of sites first and then the sites.
+void BM_Query_two_call_sites(benchmark::State &state,
+                             const Device_library &library) {
+  const DriverSession driver(library, 1);
+  if (!driver.ok()) {
+    state.SkipWithError("Failed to initialize the driver");
+    return;
+  }
+  for (auto _ : state) {
+    size_t num_sites = 0;
+    QDMI_query_get_sites(driver.devices[0], 0, nullptr, &num_sites);
+    std::vector<QDMI_Site> sites(num_sites);
+    benchmark::DoNotOptimize(QDMI_query_get_sites(
+        driver.devices[0], num_sites, sites.data(), nullptr));
+    benchmark::DoNotOptimize(sites.data());
+  }
+}
+
+/// Obtain the devices of a session for a growing number of devices.
+void BM_Session_get_devices(benchmark::State &state,
+                            const Device_library &library) {
+  const auto num_devices = static_cast<size_t>(state.range(0));
+  const DriverSession driver(library, num_devices);
+  if (!driver.ok()) {
+    state.SkipWithError("Failed to initialize the driver");
+    return;
+  }
+  std::vector<QDMI_Device> devices(num_devices);
+  for (auto _ : state) {
+    size_t num_returned = 0;
+    QDMI_session_get_devices(driver.session, 0, nullptr, &num_returned);
+    benchmark::DoNotOptimize(QDMI_session_get_devices(
+        driver.session, num_returned, devices.data(), nullptr));
+    benchmark::DoNotOptimize(devices.data());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+/// Initialize the driver for a growing number of configured libraries.
+void BM_Driver_init(benchmark::State &state, const Device_library &library) {
+  const auto num_devices = static_cast<size_t>(state.range(0));
+  Write_config(library, num_devices);
+  for (auto _ : state) {
+    if (QDMI_Driver_init() != QDMI_SUCCESS) {
+      state.SkipWithError("Failed to initialize the driver");
+      break;
+    }
+    state.PauseTiming();
+    QDMI_Driver_shutdown();
+    state.ResumeTiming();
+  }
+  Remove_config();
+  state.SetComplexityN(state.range(0));
+}
+} // namespace
+
+// NOLINTBEGIN(cert-err58-cpp, cppcoreguidelines-owning-memory)
+BENCHMARK_CAPTURE(BM_Query_device_property_cached, c, C_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_device_property_cached, cxx, CXX_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_device_property_uncached, c, C_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_device_property_uncached, cxx, CXX_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_site_property, c, C_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_site_property, cxx, CXX_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_operation_property, c, C_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_operation_property, cxx, CXX_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_edge_fidelities, single, false)
+    ->RangeMultiplier(4)
+    ->Range(4, 4096);
+BENCHMARK_CAPTURE(BM_Query_edge_fidelities, batched, true)
+    ->RangeMultiplier(4)
+    ->Range(4, 4096);
+BENCHMARK_CAPTURE(BM_Query_two_call_string, c, C_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_two_call_string, cxx, CXX_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_one_call_string, c, C_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_one_call_string, cxx, CXX_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_two_call_sites, c, C_DEVICE);
+BENCHMARK_CAPTURE(BM_Query_two_call_sites, cxx, CXX_DEVICE);
+BENCHMARK_CAPTURE(BM_Session_get_devices, c, C_DEVICE)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->Complexity();
+BENCHMARK_CAPTURE(BM_Session_get_devices, cxx, CXX_DEVICE)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->Complexity();
+BENCHMARK_CAPTURE(BM_Driver_init, c, C_DEVICE)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->Unit(benchmark::kMicrosecond)
+    ->Complexity();
+BENCHMARK_CAPTURE(BM_Driver_init, cxx, CXX_DEVICE)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->Unit(benchmark::kMicrosecond)
+    ->Complexity();
+// NOLINTEND(cert-err58-cpp, cppcoreguidelines-owning-memory)
+
+BENCHMARK_MAIN();
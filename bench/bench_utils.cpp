@@ -0,0 +1,190 @@
+/*------------------------------------------------------------------------------
+Copyright 2024 Munich Quantum Software Stack Project
+
+Licensed under the Apache License, Version 2.0 with LLVM Exceptions (the
+"License"); you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+https://github.com/Munich-Quantum-Software-Stack/QDMI/blob/develop/LICENSE
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+License for the specific language governing permissions and limitations under
+the License.
+
+SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+------------------------------------------------------------------------------*/
+
+#include "bench_utils.hpp"
+
+#include "qdmi/client.h"
+#include "qdmi_example_driver.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) &&                    \
+    !defined(__SANITIZE_THREAD__)
+#define QDMI_BENCH_COUNT_ALLOCATIONS
+#endif
+
+namespace {
+/// The configuration file written for the benchmarks.
+constexpr const char *CONFIG_FILE = "qdmi_bench.conf";
+/// The description of the C++ example device written for the benchmarks.
+constexpr const char *DESCRIPTION_FILE = "qdmi_bench_device.txt";
+
+/**
+ * @brief Write the description of a device whose qubits form a square grid.
+ * @details The description is read by the C++ example device, see
+ * `CXX_QDMI_DEVICE_FILE`.
+ * @param file_name the name of the description file.
+ * @param num_qubits the number of qubits.
+ */
+void Write_grid_description(const std::string &file_name,
+                            const size_t num_qubits) {
+  const auto width = static_cast<size_t>(
+      std::ceil(std::sqrt(static_cast<double>(num_qubits))));
+  std::ofstream file(file_name);
+  file << "qubits " << num_qubits << "\n";
+  for (size_t i = 0; i < num_qubits; ++i) {
+    if ((i + 1) % width != 0 && i + 1 < num_qubits) {
+      file << "edge " << i << " " << (i + 1) << " 0.99\n";
+    }
+    if (i + width < num_qubits) {
+      file << "edge " << i << " " << (i + width) << " 0.98\n";
+    }
+  }
+}
+
+std::atomic<uint64_t> &Allocation_counter() {
+  static std::atomic<uint64_t> counter{0};
+  return counter;
+}
+} // namespace
+
+#ifdef QDMI_BENCH_COUNT_ALLOCATIONS
+// Interpose the allocation functions of glibc. The definitions in the
+// executable take precedence over the ones of the C library for all shared
+// libraries of the process, including the example devices.
+// NOLINTBEGIN(readability-identifier-naming, bugprone-reserved-identifier)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t num, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+  Allocation_counter().fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t num, size_t size) {
+  Allocation_counter().fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(num, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  Allocation_counter().fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+} // extern "C"
+// NOLINTEND(readability-identifier-naming, bugprone-reserved-identifier)
+#endif
+
+bool Allocations_counted() {
+#ifdef QDMI_BENCH_COUNT_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t Num_allocations() {
+  return Allocation_counter().load(std::memory_order_relaxed);
+}
+
+void Write_config(const Device_library &library, const size_t num_devices) {
+  std::ofstream file(CONFIG_FILE);
+  for (size_t i = 0; i < num_devices; ++i) {
+    file << library.path << " " << library.prefix << " read_write\n";
+  }
+  file.close();
+  // NOLINTNEXTLINE(misc-include-cleaner) already included from `<cstdlib>`
+  setenv("QDMI_CONF", CONFIG_FILE, 1);
+}
+
+void Remove_config() { std::filesystem::remove(CONFIG_FILE); }
+
+DriverSession::DriverSession(const Device_library &library,
+                             const size_t num_devices,
+                             const size_t num_qubits) {
+  Write_config(library, num_devices);
+  const bool described =
+      num_qubits > 0 && std::string(library.prefix) == CXX_DEVICE.prefix;
+  if (described) {
+    Write_grid_description(DESCRIPTION_FILE, num_qubits);
+    // NOLINTNEXTLINE(concurrency-mt-unsafe) the benchmarks are single-threaded
+    setenv("CXX_QDMI_DEVICE_FILE", DESCRIPTION_FILE, 1);
+  }
+  initialized = QDMI_Driver_init() == QDMI_SUCCESS;
+  if (described) {
+    // NOLINTNEXTLINE(concurrency-mt-unsafe) the benchmarks are single-threaded
+    unsetenv("CXX_QDMI_DEVICE_FILE");
+    std::filesystem::remove(DESCRIPTION_FILE);
+  }
+  if (!initialized) {
+    return;
+  }
+  const std::string token = "bench_token";
+  if (QDMI_session_alloc(&session) != QDMI_SUCCESS ||
+      QDMI_session_set_parameter(session, QDMI_SESSION_PARAMETER_TOKEN,
+                                 token.length() + 1,
+                                 token.c_str()) != QDMI_SUCCESS) {
+    return;
+  }
+  devices.resize(num_devices);
+  size_t num_returned = 0;
+  if (QDMI_session_get_devices(session, num_devices, devices.data(),
+                               &num_returned) != QDMI_SUCCESS ||
+      num_returned != num_devices) {
+    devices.clear();
+  }
+}
+
+DriverSession::~DriverSession() {
+  QDMI_session_free(session);
+  if (initialized) {
+    QDMI_Driver_shutdown();
+  }
+  Remove_config();
+}
+
+QDMI_Operation Find_operation(QDMI_Device device, const std::string &name) {
+  size_t num_operations = 0;
+  QDMI_query_get_operations(device, 0, nullptr, &num_operations);
+  std::vector<QDMI_Operation> operations(num_operations);
+  QDMI_query_get_operations(device, num_operations, operations.data(),
+                            nullptr);
+  for (auto *operation : operations) {
+    size_t size = 0;
+    QDMI_query_operation_property(device, operation, 0, nullptr,
+                                  QDMI_OPERATION_PROPERTY_NAME, 0, nullptr,
+                                  &size);
+    std::string value(size, '\0');
+    QDMI_query_operation_property(device, operation, 0, nullptr,
+                                  QDMI_OPERATION_PROPERTY_NAME, size,
+                                  value.data(), nullptr);
+    if (value.c_str() == name) {
+      return operation;
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,109 @@
+/*------------------------------------------------------------------------------
+Copyright 2024 Munich Quantum Software Stack Project
+
+Licensed under the Apache License, Version 2.0 with LLVM Exceptions (the
+"License"); you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+https://github.com/Munich-Quantum-Software-Stack/QDMI/blob/develop/LICENSE
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+License for the specific language governing permissions and limitations under
+the License.
+
+SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+------------------------------------------------------------------------------*/
+
+/** @file
+ * @brief Utilities shared by the benchmarks.
+ */
+
+#pragma once
+
+#include "qdmi/client.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief An example device library the benchmarks are run for.
+ */
+struct Device_library {
+  /// The path of the shared library.
+  const char *path;
+  /// The prefix of the symbols exported by the library.
+  const char *prefix;
+};
+
+constexpr Device_library C_DEVICE{QDMI_BENCH_C_DEVICE, "C"};
+constexpr Device_library CXX_DEVICE{QDMI_BENCH_CXX_DEVICE, "CXX"};
+
+/**
+ * @brief Write a configuration file listing the same library several times
+ * and point the driver to it.
+ * @details Every entry is opened as a separate device by the driver.
+ * @param library the device library.
+ * @param num_devices the number of entries.
+ */
+void Write_config(const Device_library &library, size_t num_devices);
+
+/**
+ * @brief Remove the configuration file written by @ref Write_config.
+ */
+void Remove_config();
+
+/**
+ * @brief Initializes the driver and provides a session with its devices.
+ * @details The driver is shut down and the configuration file is removed when
+ * the object goes out of scope. If a number of qubits is given, the devices of
+ * the C++ example device library are loaded from the description of a square
+ * grid of that many qubits, see `CXX_QDMI_DEVICE_FILE`. The C example device
+ * always has its fixed number of qubits.
+ */
+class DriverSession {
+public:
+  DriverSession(const Device_library &library, size_t num_devices,
+                size_t num_qubits = 0);
+
+  DriverSession(const DriverSession &) = delete;
+  DriverSession &operator=(const DriverSession &) = delete;
+  DriverSession(DriverSession &&) = delete;
+  DriverSession &operator=(DriverSession &&) = delete;
+
+  ~DriverSession();
+
+  /// Whether the driver was initialized and all devices were obtained.
+  [[nodiscard]] bool ok() const { return !devices.empty(); }
+
+  QDMI_Session session = nullptr;
+  std::vector<QDMI_Device> devices;
+
+private:
+  bool initialized = false;
+};
+
+/**
+ * @brief Find an operation of a device by its name.
+ * @param device the device.
+ * @param name the name of the operation.
+ * @return the operation, or `nullptr` if the device has no such operation.
+ */
+QDMI_Operation Find_operation(QDMI_Device device, const std::string &name);
+
+/**
+ * @brief Whether the heap allocations of the process are counted.
+ * @details Counting is supported with glibc, unless a sanitizer replaces the
+ * allocator.
+ */
+bool Allocations_counted();
+
+/**
+ * @brief The number of heap allocations made by all threads so far.
+ * @return the number of calls to `malloc`, `calloc`, and `realloc`, which
+ * includes the allocations made by `operator new`.
+ */
+uint64_t Num_allocations();
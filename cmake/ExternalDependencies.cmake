@@ -96,6 +96,32 @@ if(BUILD_QDMI_TESTS)
   endif()
 endif()
 
+if(BUILD_QDMI_BENCHMARKS)
+  set(BENCHMARK_VERSION
+      1.7.1
+      CACHE STRING "Google Benchmark version")
+  set(BENCHMARK_URL
+      https://github.com/google/benchmark/archive/refs/tags/v${BENCHMARK_VERSION}.tar.gz
+  )
+  set(BENCHMARK_ENABLE_TESTING
+      OFF
+      CACHE BOOL "Disable the tests of Google Benchmark")
+  set(BENCHMARK_ENABLE_INSTALL
+      OFF
+      CACHE BOOL "Disable Google Benchmark installation")
+  if(CMAKE_VERSION VERSION_GREATER_EQUAL 3.24)
+    FetchContent_Declare(benchmark URL ${BENCHMARK_URL} FIND_PACKAGE_ARGS
+                                       ${BENCHMARK_VERSION})
+    list(APPEND FETCH_PACKAGES benchmark)
+  else()
+    find_package(benchmark ${BENCHMARK_VERSION} QUIET)
+    if(NOT benchmark_FOUND)
+      FetchContent_Declare(benchmark URL ${BENCHMARK_URL})
+      list(APPEND FETCH_PACKAGES benchmark)
+    endif()
+  endif()
+endif()
+
 # Make all declared dependencies available.
 FetchContent_MakeAvailable(${FETCH_PACKAGES})
 
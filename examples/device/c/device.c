@@ -23,19 +23,41 @@ SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include "c_qdmi/device.h"
 
+#include <errno.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+/**
+ * @brief The histogram of the shots of a job.
+ */
+typedef struct C_QDMI_Histogram_d {
+  size_t num_entries;
+  char *keys;         // distinct bitstrings in ascending order, comma-separated
+  size_t keys_length; // includes null terminator, zero without entries
+  size_t *values;     // number of occurrences of each bitstring in keys
+} C_QDMI_Histogram_t;
 
 typedef struct C_QDMI_Job_impl_d {
   int id;
-  QDMI_Job_Status status;
+  QDMI_Job_Status status; // guarded by the mutex of the device state
   size_t num_shots;
+  size_t num_qubits; // number of qubits measured in every shot
   char *results;
   size_t results_length; // includes null terminator
+  _Atomic(C_QDMI_Histogram_t *) histogram; // computed on the first request
   double *state_vec;
   size_t state_vec_length;
+  bool executing; // whether the worker thread currently holds the job
+  C_QDMI_Job_Callback callback;
+  void *user_data;
+  struct C_QDMI_Job_impl_d *next; // next job in the queue of the device
 } C_QDMI_Job_impl_t;
 
 typedef struct C_QDMI_Site_impl_d {
@@ -52,11 +74,27 @@ typedef struct C_QDMI_Operation_impl_d {
  * @note This function is considered private and should not be used outside of
  * this file. Hence, it is not part of any header file.
  */
-static QDMI_Device_Status *C_QDMI_get_device_status(void) {
-  static QDMI_Device_Status device_status = QDMI_DEVICE_STATUS_OFFLINE;
+static _Atomic QDMI_Device_Status *C_QDMI_get_device_status(void) {
+  static _Atomic QDMI_Device_Status device_status = QDMI_DEVICE_STATUS_OFFLINE;
   return &device_status;
 }
 
+/**
+ * @brief Static function to maintain the number of active jobs.
+ * @details A job is active from its submission until it has finished, has been
+ * cancelled, or has been freed. The device reports
+ * @ref QDMI_DEVICE_STATUS_BUSY while this number is positive. Counting the jobs
+ * instead of toggling a single flag keeps the status correct when several
+ * clients submit and cancel jobs concurrently.
+ * @return a pointer to the number of active jobs.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static _Atomic size_t *C_QDMI_get_num_active_jobs(void) {
+  static _Atomic size_t num_active_jobs = 0;
+  return &num_active_jobs;
+}
+
 /**
  * @brief Local function to set the device status.
  * @param status the new device status.
@@ -64,7 +102,7 @@ static QDMI_Device_Status *C_QDMI_get_device_status(void) {
  * this file. Hence, it is not part of any header file.
  */
 void C_QDMI_set_device_status(QDMI_Device_Status status) {
-  *C_QDMI_get_device_status() = status;
+  atomic_store(C_QDMI_get_device_status(), status);
 }
 
 /**
@@ -74,7 +112,194 @@ void C_QDMI_set_device_status(QDMI_Device_Status status) {
  * this file. Hence, it is not part of any header file.
  */
 QDMI_Device_Status C_QDMI_read_device_status(void) {
-  return *C_QDMI_get_device_status();
+  const QDMI_Device_Status status = atomic_load(C_QDMI_get_device_status());
+  // the device is busy as long as any submitted job has not finished yet
+  if (status == QDMI_DEVICE_STATUS_IDLE &&
+      atomic_load(C_QDMI_get_num_active_jobs()) > 0) {
+    return QDMI_DEVICE_STATUS_BUSY;
+  }
+  return status;
+}
+
+/**
+ * @brief The number of independent streams of the random number generator.
+ */
+#define C_QDMI_RNG_LANES 4
+
+/**
+ * @brief The state of the xoshiro256** pseudo random number generator, see
+ * https://prng.di.unimi.it.
+ * @details The generator runs @ref C_QDMI_RNG_LANES independent streams. A
+ * single draw uses the first stream only, whereas @ref C_QDMI_fill_random
+ * advances all streams in lockstep. Since the state is laid out stream-minor,
+ * the compiler vectorizes the bulk generation of random bits.
+ */
+typedef struct C_QDMI_Rng_d {
+  uint64_t state[4][C_QDMI_RNG_LANES]; // word k of stream l is state[k][l]
+  bool seeded;
+} C_QDMI_Rng_t;
+
+/**
+ * @brief Static function to maintain the random number generator of the
+ * calling thread.
+ * @details Every thread uses its own generator such that concurrent callers
+ * do not contend on a shared state.
+ * @return a pointer to the random number generator.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static C_QDMI_Rng_t *C_QDMI_get_rng(void) {
+  static _Thread_local C_QDMI_Rng_t rng;
+  if (!rng.seeded) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    uint64_t seed = ((uint64_t)ts.tv_sec * 1000000000U) +
+                    (uint64_t)ts.tv_nsec + (uint64_t)(uintptr_t)&rng;
+    // expand the seed with splitmix64 as recommended by the authors
+    for (size_t k = 0; k < 4; ++k) {
+      for (size_t l = 0; l < C_QDMI_RNG_LANES; ++l) {
+        seed += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+        rng.state[k][l] = z ^ (z >> 31U);
+      }
+    }
+    rng.seeded = true;
+  }
+  return &rng;
+}
+
+/**
+ * @brief Local function to rotate a word to the left.
+ * @param x the word to rotate.
+ * @param k the number of bits to rotate by, in the range [1, 63].
+ * @return the rotated word.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static inline uint64_t C_QDMI_rotl(const uint64_t x, const unsigned int k) {
+  return (x << k) | (x >> (64U - k));
+}
+
+/**
+ * @brief Local function to advance one stream of the random number generator.
+ * @param state the state of the generator.
+ * @param l the stream to advance.
+ * @return the next 64 random bits of the stream.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static inline uint64_t C_QDMI_rng_step(uint64_t state[4][C_QDMI_RNG_LANES],
+                                       const size_t l) {
+  const uint64_t result = C_QDMI_rotl(state[1][l] * 5, 7) * 9;
+  const uint64_t t = state[1][l] << 17U;
+  state[2][l] ^= state[0][l];
+  state[3][l] ^= state[1][l];
+  state[1][l] ^= state[2][l];
+  state[0][l] ^= state[3][l];
+  state[2][l] ^= t;
+  state[3][l] = C_QDMI_rotl(state[3][l], 45);
+  return result;
+}
+
+/**
+ * @brief Local function to generate 64 random bits.
+ * @return the generated bits.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static uint64_t C_QDMI_random(void) {
+  return C_QDMI_rng_step(C_QDMI_get_rng()->state, 0);
+}
+
+/**
+ * @brief Local function to fill a buffer with random bits.
+ * @param out the buffer to fill.
+ * @param num_words the number of 64-bit words to write.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static void C_QDMI_fill_random(uint64_t *out, const size_t num_words) {
+  C_QDMI_Rng_t *rng = C_QDMI_get_rng();
+  // work on a local copy, which the compiler knows not to alias the output
+  uint64_t state[4][C_QDMI_RNG_LANES];
+  memcpy(state, rng->state, sizeof(state));
+  const size_t num_blocks = num_words / C_QDMI_RNG_LANES;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    for (size_t l = 0; l < C_QDMI_RNG_LANES; ++l) {
+      out[(i * C_QDMI_RNG_LANES) + l] = C_QDMI_rng_step(state, l);
+    }
+  }
+  for (size_t i = num_blocks * C_QDMI_RNG_LANES; i < num_words; ++i) {
+    out[i] = C_QDMI_rng_step(state, 0);
+  }
+  memcpy(rng->state, state, sizeof(state));
+}
+
+/**
+ * @brief Local function to generate a random real number in [-1, 1).
+ * @return the generated number.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static double C_QDMI_random_real(void) {
+  // the upper 53 bits fill the mantissa of a double in [0, 1)
+  return ((double)(C_QDMI_random() >> 11U) * 0x1.0p-53 * 2.0) - 1.0;
+}
+
+/**
+ * @brief The state of the worker thread executing the submitted jobs.
+ */
+typedef struct C_QDMI_Worker_State_d {
+  pthread_mutex_t mutex; // protects the members and the status of all jobs
+  pthread_cond_t cond;   // signalled when a job is queued or changes status
+  C_QDMI_Job head;       // first submitted job waiting for execution
+  C_QDMI_Job tail;       // last submitted job waiting for execution
+  C_QDMI_Job current;    // job currently executed by the worker, if any
+  pthread_t thread;
+  bool started;
+  bool stop;
+  size_t num_initialized; // number of initializations not yet finalized
+} C_QDMI_Worker_State_t;
+
+/**
+ * @brief Static function to maintain the state of the worker thread.
+ * @return a pointer to the state of the worker thread.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static C_QDMI_Worker_State_t *C_QDMI_get_worker_state(void) {
+  static C_QDMI_Worker_State_t worker_state = {
+      PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, NULL,
+      0, false, false, 0};
+  return &worker_state;
+}
+
+/**
+ * @brief Remove a job from the queue of submitted jobs.
+ * @details The caller must hold the lock of the worker state.
+ * @param job the job to remove.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static void C_QDMI_dequeue_job(C_QDMI_Job job) {
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  C_QDMI_Job prev = NULL;
+  for (C_QDMI_Job it = state->head; it != NULL; prev = it, it = it->next) {
+    if (it == job) {
+      if (prev == NULL) {
+        state->head = job->next;
+      } else {
+        prev->next = job->next;
+      }
+      if (state->tail == job) {
+        state->tail = prev;
+      }
+      job->next = NULL;
+      return;
+    }
+  }
 }
 
 const C_QDMI_Site DEVICE_SITES[] = {
@@ -139,6 +364,29 @@ const C_QDMI_Operation DEVICE_OPERATIONS[] = {
     }                                                                          \
   } /// [DOXYGEN MACRO END]
 
+/**
+ * @brief Local function to look up the fidelity of a cx gate.
+ * @param first the first site the gate acts on.
+ * @param second the second site the gate acts on.
+ * @return the fidelity of the gate, or a negative value if the sites are not
+ * coupled.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static double C_QDMI_get_cx_fidelity(const C_QDMI_Site first,
+                                     const C_QDMI_Site second) {
+  static const double FIDELITIES[] = {0.99, 0.98, 0.97, 0.96};
+  const size_t low = first->id < second->id ? first->id : second->id;
+  const size_t high = first->id < second->id ? second->id : first->id;
+  if (low == 0 && high == 4) {
+    return 0.95;
+  }
+  if (high == low + 1) {
+    return FIDELITIES[low];
+  }
+  return -1.0;
+}
+
 int C_QDMI_query_get_sites_dev(const size_t num_entries, C_QDMI_Site *sites,
                                size_t *num_sites) {
   if ((sites != NULL && num_entries == 0) ||
@@ -198,6 +446,9 @@ int C_QDMI_query_device_property_dev(const QDMI_Device_Property prop,
   ADD_SINGLE_VALUE_PROPERTY(QDMI_DEVICE_PROPERTY_STATUS, QDMI_Device_Status,
                             C_QDMI_read_device_status(), prop, size, value,
                             size_ret)
+  // the calibration data of this device never changes
+  ADD_SINGLE_VALUE_PROPERTY(QDMI_DEVICE_PROPERTY_CALIBRATIONEPOCH, size_t, 0,
+                            prop, size, value, size_ret)
   ADD_LIST_PROPERTY(
       QDMI_DEVICE_PROPERTY_COUPLINGMAP, C_QDMI_Site,
       ((C_QDMI_Site[]){
@@ -254,30 +505,10 @@ int C_QDMI_query_operation_property_dev(C_QDMI_Operation operation,
     if (sites[0] == sites[1]) {
       return QDMI_ERROR_INVALIDARGUMENT;
     }
-    if ((sites[0]->id == 0 && sites[1]->id == 1) ||
-        (sites[0]->id == 1 && sites[1]->id == 0)) {
-      ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_FIDELITY, double, 0.99,
-                                prop, size, value, size_ret)
-    }
-    if ((sites[0]->id == 1 && sites[1]->id == 2) ||
-        (sites[0]->id == 2 && sites[1]->id == 1)) {
-      ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_FIDELITY, double, 0.98,
-                                prop, size, value, size_ret)
-    }
-    if ((sites[0]->id == 2 && sites[1]->id == 3) ||
-        (sites[0]->id == 3 && sites[1]->id == 2)) {
-      ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_FIDELITY, double, 0.97,
-                                prop, size, value, size_ret)
-    }
-    if ((sites[0]->id == 3 && sites[1]->id == 4) ||
-        (sites[0]->id == 4 && sites[1]->id == 3)) {
-      ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_FIDELITY, double, 0.96,
-                                prop, size, value, size_ret)
-    }
-    if ((sites[0]->id == 4 && sites[1]->id == 0) ||
-        (sites[0]->id == 0 && sites[1]->id == 4)) {
-      ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_FIDELITY, double, 0.95,
-                                prop, size, value, size_ret)
+    const double fidelity = C_QDMI_get_cx_fidelity(sites[0], sites[1]);
+    if (fidelity > 0) {
+      ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_FIDELITY, double,
+                                fidelity, prop, size, value, size_ret)
     }
     if (prop == QDMI_OPERATION_PROPERTY_FIDELITY) {
       return QDMI_ERROR_INVALIDARGUMENT;
@@ -300,65 +531,86 @@ int C_QDMI_query_operation_property_dev(C_QDMI_Operation operation,
   return QDMI_ERROR_NOTSUPPORTED;
 } /// [DOXYGEN FUNCTION END]
 
-int C_QDMI_control_create_job_dev(const QDMI_Program_Format format,
-                                  const size_t size, const void *prog,
-                                  C_QDMI_Job *job) {
-  if (C_QDMI_read_device_status() != QDMI_DEVICE_STATUS_IDLE) {
-    return QDMI_ERROR_FATAL;
-  }
-  if (size == 0 || prog == NULL || job == NULL) {
+int C_QDMI_query_device_properties_dev(const size_t num_queries,
+                                       QDMI_Device_Property_Query *queries) {
+  if (queries == NULL && num_queries > 0) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
-  if (format != QDMI_PROGRAM_FORMAT_QASM2 &&
-      format != QDMI_PROGRAM_FORMAT_QIRSTRING &&
-      format != QDMI_PROGRAM_FORMAT_QIRMODULE) {
-    return QDMI_ERROR_NOTSUPPORTED;
+  for (size_t i = 0; i < num_queries; ++i) {
+    QDMI_Device_Property_Query *query = &queries[i];
+    query->size_ret = 0;
+    query->status = C_QDMI_query_device_property_dev(
+        query->prop, query->size, query->value, &query->size_ret);
   }
-
-  *job = (C_QDMI_Job)malloc(sizeof(C_QDMI_Job_impl_t));
-  // set job id to random number for demonstration purposes
-  (*job)->id = rand();
-  (*job)->status = QDMI_JOB_STATUS_CREATED;
-  (*job)->num_shots = 0;
-  (*job)->results = NULL;
-  (*job)->state_vec = NULL;
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
-int C_QDMI_control_set_parameter_dev(C_QDMI_Job job,
-                                     const QDMI_Job_Parameter param,
-                                     const size_t size, const void *value) {
-  if (job == NULL || param >= QDMI_JOB_PARAMETER_MAX || size == 0 ||
-      job->status != QDMI_JOB_STATUS_CREATED) {
+int C_QDMI_query_operation_properties_dev(
+    C_QDMI_Operation operation, const size_t num_tuples,
+    const size_t tuple_size, const C_QDMI_Site *sites,
+    const QDMI_Operation_Property prop, const size_t size, void *values,
+    int *status) {
+  if (prop >= QDMI_OPERATION_PROPERTY_MAX || operation == NULL ||
+      (num_tuples > 0 && (tuple_size == 0 || sites == NULL || values == NULL ||
+                          status == NULL))) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
-  if (param == QDMI_JOB_PARAMETER_SHOTS_NUM) {
-    job->num_shots = *(const size_t *)value;
+  char *value = (char *)values;
+  // The fidelity of cx is the only property that depends on the sites. It is
+  // looked up directly instead of going through the single query every time.
+  if (prop == QDMI_OPERATION_PROPERTY_FIDELITY &&
+      strcmp(operation->name, "cx") == 0 && tuple_size == 2 &&
+      size >= sizeof(double)) {
+    for (size_t i = 0; i < num_tuples; ++i) {
+      const C_QDMI_Site *pair = &sites[2 * i];
+      const double fidelity =
+          pair[0] == pair[1] ? -1.0 : C_QDMI_get_cx_fidelity(pair[0], pair[1]);
+      if (fidelity < 0) {
+        status[i] = QDMI_ERROR_INVALIDARGUMENT;
+        continue;
+      }
+      memcpy(value + (i * size), &fidelity, sizeof(double));
+      status[i] = QDMI_SUCCESS;
+    }
     return QDMI_SUCCESS;
   }
-  return QDMI_ERROR_NOTSUPPORTED;
+  for (size_t i = 0; i < num_tuples; ++i) {
+    status[i] = C_QDMI_query_operation_property_dev(
+        operation, tuple_size, &sites[i * tuple_size], prop, size,
+        value + (i * size), NULL);
+  }
+  return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
-int C_QDMI_control_submit_job_dev(C_QDMI_Job job) {
-  if (job == NULL || job->status != QDMI_JOB_STATUS_CREATED) {
-    return QDMI_ERROR_INVALIDARGUMENT;
-  }
-  C_QDMI_set_device_status(QDMI_DEVICE_STATUS_BUSY);
-  job->status = QDMI_JOB_STATUS_SUBMITTED;
-  // here, the actual submission of the problem to the device would happen
-  // ...
-  // set job status to running for demonstration purposes
-  job->status = QDMI_JOB_STATUS_RUNNING;
+/**
+ * @brief Execute a job, i.e., generate random results for it.
+ * @param job the job to execute.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static void C_QDMI_execute_job(C_QDMI_Job job) {
   // generate random result data
   size_t num_qubits = 0;
   C_QDMI_query_device_property_dev(QDMI_DEVICE_PROPERTY_QUBITSNUM,
                                    sizeof(size_t), &num_qubits, NULL);
-  job->results_length = job->num_shots * (num_qubits + 1);
+  // without shots, the results still hold the terminating null character
+  job->num_qubits = num_qubits;
+  job->results_length =
+      job->num_shots == 0 ? 1 : job->num_shots * (num_qubits + 1);
   job->results = (char *)malloc(job->results_length);
+  // the random bits are generated in blocks and consumed one by one
+  uint64_t bits[64];
+  size_t num_bits = 0;
   for (size_t i = 0; i < job->num_shots; ++i) {
     // generate random bitstring
     for (size_t j = 0; j < num_qubits; ++j) {
-      *(job->results + (i * (num_qubits + 1) + j)) = (rand() % 2) ? '1' : '0';
+      if (num_bits == 0) {
+        C_QDMI_fill_random(bits, 64);
+        num_bits = 64 * 64;
+      }
+      --num_bits;
+      *(job->results + (i * (num_qubits + 1) + j)) =
+          ((bits[num_bits / 64] >> (num_bits % 64)) & 1U) ? '1' : '0';
     }
     if (i < job->num_shots - 1) {
       *(job->results + ((i + 1) * (num_qubits + 1) - 1)) = ',';
@@ -370,8 +622,8 @@ int C_QDMI_control_submit_job_dev(C_QDMI_Job job) {
   job->state_vec = (double *)malloc(job->state_vec_length * sizeof(double));
   double norm = 0.0;
   for (size_t i = 0; i < job->state_vec_length / 2; ++i) {
-    const double real_part = (((double)rand() / RAND_MAX) * 2.0) - 1.0;
-    const double imag_part = (((double)rand() / RAND_MAX) * 2.0) - 1.0;
+    const double real_part = C_QDMI_random_real();
+    const double imag_part = C_QDMI_random_real();
     norm += real_part * real_part + imag_part * imag_part;
     job->state_vec[2UL * i] = real_part;
     job->state_vec[(2UL * i) + 1] = imag_part;
@@ -382,46 +634,396 @@ int C_QDMI_control_submit_job_dev(C_QDMI_Job job) {
     // NOLINTNEXTLINE(*-core.UndefinedBinaryOperatorResult)
     job->state_vec[i] = job->state_vec[i] / norm;
   }
+}
+
+/**
+ * @brief The main loop of the worker thread executing the submitted jobs.
+ * @details Jobs are executed in the order of their submission until the device
+ * is finalized. Once a job has finished, its callback is invoked.
+ * @param arg unused.
+ * @return NULL.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static void *C_QDMI_run_worker(void *arg) {
+  (void)arg;
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  while (true) {
+    while (!state->stop && state->head == NULL) {
+      pthread_cond_wait(&state->cond, &state->mutex);
+    }
+    if (state->stop) {
+      break;
+    }
+    C_QDMI_Job job = state->head;
+    C_QDMI_dequeue_job(job);
+    job->status = QDMI_JOB_STATUS_RUNNING;
+    job->executing = true;
+    state->current = job;
+    pthread_mutex_unlock(&state->mutex);
+    C_QDMI_execute_job(job);
+    pthread_mutex_lock(&state->mutex);
+    state->current = NULL;
+    // the job might have been cancelled in the meantime
+    if (job->status == QDMI_JOB_STATUS_RUNNING) {
+      job->status = QDMI_JOB_STATUS_DONE;
+      atomic_fetch_sub(C_QDMI_get_num_active_jobs(), 1);
+      const C_QDMI_Job_Callback callback = job->callback;
+      void *user_data = job->user_data;
+      pthread_cond_broadcast(&state->cond);
+      pthread_mutex_unlock(&state->mutex);
+      if (callback != NULL) {
+        callback(job, QDMI_JOB_STATUS_DONE, user_data);
+      }
+      pthread_mutex_lock(&state->mutex);
+    }
+    // only now the job may be freed
+    job->executing = false;
+    pthread_cond_broadcast(&state->cond);
+  }
+  pthread_mutex_unlock(&state->mutex);
+  return NULL;
+}
+
+int C_QDMI_control_create_job_dev(const QDMI_Program_Format format,
+                                  const size_t size, const void *prog,
+                                  C_QDMI_Job *job) {
+  if (C_QDMI_read_device_status() == QDMI_DEVICE_STATUS_OFFLINE) {
+    return QDMI_ERROR_FATAL;
+  }
+  if (size == 0 || prog == NULL || job == NULL) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  if (format != QDMI_PROGRAM_FORMAT_QASM2 &&
+      format != QDMI_PROGRAM_FORMAT_QIRSTRING &&
+      format != QDMI_PROGRAM_FORMAT_QIRMODULE) {
+    return QDMI_ERROR_NOTSUPPORTED;
+  }
+
+  *job = (C_QDMI_Job)malloc(sizeof(C_QDMI_Job_impl_t));
+  // set job id to random number for demonstration purposes
+  (*job)->id = (int)(C_QDMI_random() >> 33U);
+  (*job)->status = QDMI_JOB_STATUS_CREATED;
+  (*job)->num_shots = 0;
+  (*job)->num_qubits = 0;
+  (*job)->results = NULL;
+  atomic_init(&(*job)->histogram, NULL);
+  (*job)->state_vec = NULL;
+  (*job)->executing = false;
+  (*job)->callback = NULL;
+  (*job)->user_data = NULL;
+  (*job)->next = NULL;
+  return QDMI_SUCCESS;
+} /// [DOXYGEN FUNCTION END]
+
+int C_QDMI_control_set_parameter_dev(C_QDMI_Job job,
+                                     const QDMI_Job_Parameter param,
+                                     const size_t size, const void *value) {
+  if (job == NULL || param >= QDMI_JOB_PARAMETER_MAX || size == 0) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  const QDMI_Job_Status status = job->status;
+  pthread_mutex_unlock(&state->mutex);
+  if (status != QDMI_JOB_STATUS_CREATED) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  if (param == QDMI_JOB_PARAMETER_SHOTS_NUM) {
+    job->num_shots = *(const size_t *)value;
+    return QDMI_SUCCESS;
+  }
+  return QDMI_ERROR_NOTSUPPORTED;
+} /// [DOXYGEN FUNCTION END]
+
+int C_QDMI_control_submit_job_dev(C_QDMI_Job job) {
+  if (job == NULL) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  if (job->status != QDMI_JOB_STATUS_CREATED) {
+    pthread_mutex_unlock(&state->mutex);
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  if (!state->started) {
+    if (pthread_create(&state->thread, NULL, C_QDMI_run_worker, NULL) != 0) {
+      pthread_mutex_unlock(&state->mutex);
+      return QDMI_ERROR_FATAL;
+    }
+    state->started = true;
+  }
+  // here, the actual submission of the problem to the device would happen
+  // ...
+  // for demonstration purposes, the job is executed by a worker thread
+  job->status = QDMI_JOB_STATUS_SUBMITTED;
+  job->next = NULL;
+  if (state->tail == NULL) {
+    state->head = job;
+  } else {
+    state->tail->next = job;
+  }
+  state->tail = job;
+  atomic_fetch_add(C_QDMI_get_num_active_jobs(), 1);
+  pthread_cond_broadcast(&state->cond);
+  pthread_mutex_unlock(&state->mutex);
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
 int C_QDMI_control_cancel_dev(C_QDMI_Job job) {
+  if (job == NULL) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
   // cannot cancel a job that is already done
   if (job->status == QDMI_JOB_STATUS_DONE) {
+    pthread_mutex_unlock(&state->mutex);
     return QDMI_ERROR_INVALIDARGUMENT;
   }
-
+  if (job->status == QDMI_JOB_STATUS_CANCELLED) {
+    pthread_mutex_unlock(&state->mutex);
+    return QDMI_SUCCESS;
+  }
+  // a running job finishes its execution, but its results are discarded
+  if (job->status == QDMI_JOB_STATUS_SUBMITTED) {
+    C_QDMI_dequeue_job(job);
+  }
+  if (job->status != QDMI_JOB_STATUS_CREATED) {
+    atomic_fetch_sub(C_QDMI_get_num_active_jobs(), 1);
+  }
   job->status = QDMI_JOB_STATUS_CANCELLED;
-  C_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
+  const C_QDMI_Job_Callback callback = job->callback;
+  void *user_data = job->user_data;
+  pthread_cond_broadcast(&state->cond);
+  pthread_mutex_unlock(&state->mutex);
+  if (callback != NULL) {
+    callback(job, QDMI_JOB_STATUS_CANCELLED, user_data);
+  }
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
 int C_QDMI_control_check_dev(C_QDMI_Job job, QDMI_Job_Status *status) {
-  // randomly decide whether job is done or not
-  if (job->status == QDMI_JOB_STATUS_RUNNING && rand() % 2 == 0) {
-    C_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
-    job->status = QDMI_JOB_STATUS_DONE;
+  if (job == NULL || status == NULL) {
+    return QDMI_ERROR_INVALIDARGUMENT;
   }
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
   *status = job->status;
+  pthread_mutex_unlock(&state->mutex);
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
 int C_QDMI_control_wait_dev(C_QDMI_Job job) {
-  // in a real implementation, this would wait for the job to finish
-  job->status = QDMI_JOB_STATUS_DONE;
-  C_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
+  if (job == NULL) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  if (job->status == QDMI_JOB_STATUS_CREATED) {
+    pthread_mutex_unlock(&state->mutex);
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  while (job->status != QDMI_JOB_STATUS_DONE &&
+         job->status != QDMI_JOB_STATUS_CANCELLED) {
+    pthread_cond_wait(&state->cond, &state->mutex);
+  }
+  pthread_mutex_unlock(&state->mutex);
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
-// Comparison function for qsort
-int C_QDMI_Compare_results(const void *a, const void *b) {
-  return strcmp(*(char **)a, *(char **)b);
+int C_QDMI_control_wait_for_dev(C_QDMI_Job job, const size_t timeout) {
+  if (job == NULL) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  // the condition variable measures time with the realtime clock
+  struct timespec deadline;
+  timespec_get(&deadline, TIME_UTC);
+  deadline.tv_sec += (time_t)(timeout / 1000);
+  deadline.tv_nsec += (long)(timeout % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec += 1;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  if (job->status == QDMI_JOB_STATUS_CREATED) {
+    pthread_mutex_unlock(&state->mutex);
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  int ret = QDMI_SUCCESS;
+  while (job->status != QDMI_JOB_STATUS_DONE &&
+         job->status != QDMI_JOB_STATUS_CANCELLED) {
+    if (pthread_cond_timedwait(&state->cond, &state->mutex, &deadline) ==
+        ETIMEDOUT) {
+      ret = QDMI_ERROR_TIMEOUT;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&state->mutex);
+  return ret;
 } /// [DOXYGEN FUNCTION END]
 
+/**
+ * @brief Local function to free a histogram.
+ * @param hist the histogram to free, may be NULL.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static void C_QDMI_free_histogram(C_QDMI_Histogram_t *hist) {
+  if (hist != NULL) {
+    free(hist->keys);
+    free(hist->values);
+    free(hist);
+  }
+}
+
+/**
+ * @brief Local function to sort words with a least significant digit radix
+ * sort.
+ * @param words the words to sort.
+ * @param tmp a buffer of the same length used by the sort.
+ * @param num_words the number of words.
+ * @param num_bits the number of least significant bits that may be set.
+ * @return the buffer holding the sorted words, either @p words or @p tmp.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static uint64_t *C_QDMI_radix_sort(uint64_t *words, uint64_t *tmp,
+                                   const size_t num_words,
+                                   const size_t num_bits) {
+  for (size_t shift = 0; shift < num_bits; shift += 8) {
+    size_t offsets[256] = {0};
+    for (size_t i = 0; i < num_words; ++i) {
+      ++offsets[(words[i] >> shift) & 0xFFU];
+    }
+    size_t offset = 0;
+    for (size_t d = 0; d < 256; ++d) {
+      const size_t count = offsets[d];
+      offsets[d] = offset;
+      offset += count;
+    }
+    for (size_t i = 0; i < num_words; ++i) {
+      tmp[offsets[(words[i] >> shift) & 0xFFU]++] = words[i];
+    }
+    uint64_t *sorted = tmp;
+    tmp = words;
+    words = sorted;
+  }
+  return words;
+}
+
+/**
+ * @brief Local function to compute the histogram of the shots of a job.
+ * @details Every shot is packed into a word such that the order of the words
+ * equals the order of the bitstrings. The words are radix-sorted and equal
+ * words are counted in runs.
+ * @param job the job, which must be done and measure at most 64 qubits.
+ * @return the histogram, or NULL if memory could not be allocated.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static C_QDMI_Histogram_t *C_QDMI_compute_histogram(const C_QDMI_Job job) {
+  C_QDMI_Histogram_t *hist =
+      (C_QDMI_Histogram_t *)calloc(1, sizeof(C_QDMI_Histogram_t));
+  if (hist == NULL || job->num_shots == 0) {
+    return hist;
+  }
+  const size_t num_qubits = job->num_qubits;
+  const size_t stride = num_qubits + 1;
+  uint64_t *packed = (uint64_t *)malloc(job->num_shots * sizeof(uint64_t));
+  uint64_t *tmp = (uint64_t *)malloc(job->num_shots * sizeof(uint64_t));
+  if (packed == NULL || tmp == NULL) {
+    free(packed);
+    free(tmp);
+    free(hist);
+    return NULL;
+  }
+  // the first character of a bitstring becomes the most significant bit
+  for (size_t i = 0; i < job->num_shots; ++i) {
+    const char *shot = job->results + (i * stride);
+    uint64_t word = 0;
+    for (size_t j = 0; j < num_qubits; ++j) {
+      word = (word << 1U) | (uint64_t)(shot[j] == '1');
+    }
+    packed[i] = word;
+  }
+  const uint64_t *sorted =
+      C_QDMI_radix_sort(packed, tmp, job->num_shots, num_qubits);
+  hist->num_entries = 1;
+  for (size_t i = 1; i < job->num_shots; ++i) {
+    hist->num_entries += (size_t)(sorted[i] != sorted[i - 1]);
+  }
+  hist->keys_length = hist->num_entries * stride;
+  hist->keys = (char *)malloc(hist->keys_length);
+  hist->values = (size_t *)malloc(hist->num_entries * sizeof(size_t));
+  if (hist->keys == NULL || hist->values == NULL) {
+    free(packed);
+    free(tmp);
+    C_QDMI_free_histogram(hist);
+    return NULL;
+  }
+  size_t entry = 0;
+  for (size_t i = 0; i < job->num_shots; ++entry) {
+    // count the run of equal words starting at i
+    size_t end = i + 1;
+    while (end < job->num_shots && sorted[end] == sorted[i]) {
+      ++end;
+    }
+    char *key = hist->keys + (entry * stride);
+    for (size_t j = 0; j < num_qubits; ++j) {
+      key[j] = ((sorted[i] >> (num_qubits - 1 - j)) & 1U) ? '1' : '0';
+    }
+    key[num_qubits] = ',';
+    hist->values[entry] = end - i;
+    i = end;
+  }
+  hist->keys[hist->keys_length - 1] = '\0';
+  free(packed);
+  free(tmp);
+  return hist;
+}
+
+/**
+ * @brief Local function to get the histogram of the shots of a job.
+ * @details The histogram is computed on the first request and cached in the
+ * job. If several threads request it at the same time, the first computed
+ * histogram is kept and the others are discarded.
+ * @param job the job, which must be done and measure at most 64 qubits.
+ * @return the histogram, or NULL if memory could not be allocated.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+static const C_QDMI_Histogram_t *C_QDMI_get_histogram(C_QDMI_Job job) {
+  C_QDMI_Histogram_t *hist = atomic_load(&job->histogram);
+  if (hist != NULL) {
+    return hist;
+  }
+  hist = C_QDMI_compute_histogram(job);
+  if (hist == NULL) {
+    return NULL;
+  }
+  C_QDMI_Histogram_t *expected = NULL;
+  if (!atomic_compare_exchange_strong(&job->histogram, &expected, hist)) {
+    C_QDMI_free_histogram(hist);
+    return expected;
+  }
+  return hist;
+}
+
 int C_QDMI_control_get_data_dev(C_QDMI_Job job, const QDMI_Job_Result result,
                                 const size_t size, void *data,
                                 size_t *size_ret) {
-  if (job->status != QDMI_JOB_STATUS_DONE) {
+  if (job == NULL) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  // the results are not modified anymore once the job is done
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  const QDMI_Job_Status status = job->status;
+  pthread_mutex_unlock(&state->mutex);
+  if (status != QDMI_JOB_STATUS_DONE) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
   if (result == QDMI_JOB_RESULT_SHOTS) {
@@ -439,82 +1041,31 @@ int C_QDMI_control_get_data_dev(C_QDMI_Job job, const QDMI_Job_Result result,
   }
   if (result == QDMI_JOB_RESULT_HIST_KEYS ||
       result == QDMI_JOB_RESULT_HIST_VALUES) {
-    char *raw_data = malloc(job->results_length);
-    strncpy(raw_data, job->results, job->results_length);
-    // split the string at the commas
-    char **raw_data_split = (char **)malloc(sizeof(char *) * job->num_shots);
-    char *token = strtok(raw_data, ",");
-    int i = 0;
-    while (token != NULL) {
-      raw_data_split[i] = token;
-      token = strtok(NULL, ",");
-      ++i;
-    }
-    // Sort the array
-    qsort((void *)raw_data_split, job->num_shots, sizeof(char *),
-          C_QDMI_Compare_results);
-    // Count unique elements
-    const size_t num_qubits = strlen(raw_data_split[0]);
-
-    size_t count = 1; // First element is always unique
-    for (size_t j = 1; j < job->num_shots; ++j) {
-      if (strncmp(raw_data_split[j], raw_data_split[j - 1], num_qubits) != 0) {
-        count++;
-      }
+    // the shots are packed into words for the histogram
+    if (job->num_qubits > 64) {
+      return QDMI_ERROR_NOTSUPPORTED;
     }
-
-    if (result == QDMI_JOB_RESULT_HIST_KEYS) {
-      const size_t req_size = count * (num_qubits + 1);
-      if (size_ret != NULL) {
-        *size_ret = req_size;
-      }
-      if (data != NULL) {
-        if (size < req_size) {
-          free((void *)raw_data_split);
-          free(raw_data);
-          return QDMI_ERROR_INVALIDARGUMENT;
-        }
-
-        char *data_ptr = data;
-        strncpy(data_ptr, raw_data_split[0], num_qubits);
-        data_ptr += num_qubits;
-        for (size_t j = 1; j < job->num_shots; ++j) {
-          if (strncmp(raw_data_split[j], raw_data_split[j - 1], num_qubits) !=
-              0) {
-            *data_ptr++ = ',';
-            strncpy(data_ptr, raw_data_split[j], num_qubits);
-            data_ptr += num_qubits;
-          }
-        }
-        *data_ptr = '\0';
-      }
-    } else {
-      const size_t req_size = count * sizeof(size_t);
-      if (size_ret != NULL) {
-        *size_ret = req_size;
+    const C_QDMI_Histogram_t *hist = C_QDMI_get_histogram(job);
+    if (hist == NULL) {
+      return QDMI_ERROR_OUTOFMEM;
+    }
+    const void *hist_data = hist->keys;
+    size_t req_size = hist->keys_length;
+    if (result == QDMI_JOB_RESULT_HIST_VALUES) {
+      hist_data = hist->values;
+      req_size = hist->num_entries * sizeof(size_t);
+    }
+    if (size_ret != NULL) {
+      *size_ret = req_size;
+    }
+    if (data != NULL) {
+      if (size < req_size) {
+        return QDMI_ERROR_INVALIDARGUMENT;
       }
-      if (data != NULL) {
-        if (size < req_size) {
-          free((void *)raw_data_split);
-          free(raw_data);
-          return QDMI_ERROR_INVALIDARGUMENT;
-        }
-
-        size_t *data_ptr = data;
-        size_t n = 1;
-        for (size_t j = 1; j < job->num_shots; ++j) {
-          if (strcmp(raw_data_split[j], raw_data_split[j - 1]) != 0) {
-            *data_ptr++ = n;
-            n = 1;
-          } else {
-            ++n;
-          }
-        }
-        *data_ptr = n;
+      if (req_size > 0) {
+        memcpy(data, hist_data, req_size);
       }
     }
-    free((void *)raw_data_split);
-    free(raw_data);
     return QDMI_SUCCESS;
   }
   if (result == QDMI_JOB_RESULT_STATEVECTOR_DENSE) {
@@ -627,8 +1178,42 @@ int C_QDMI_control_get_data_dev(C_QDMI_Job job, const QDMI_Job_Result result,
   return QDMI_ERROR_NOTSUPPORTED;
 } /// [DOXYGEN FUNCTION END]
 
+int C_QDMI_control_set_callback_dev(C_QDMI_Job job,
+                                    C_QDMI_Job_Callback callback,
+                                    void *user_data) {
+  if (job == NULL) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  job->callback = callback;
+  job->user_data = user_data;
+  const QDMI_Job_Status status = job->status;
+  pthread_mutex_unlock(&state->mutex);
+  if (callback != NULL && (status == QDMI_JOB_STATUS_DONE ||
+                           status == QDMI_JOB_STATUS_CANCELLED)) {
+    callback(job, status, user_data);
+  }
+  return QDMI_SUCCESS;
+} /// [DOXYGEN FUNCTION END]
+
 void C_QDMI_control_free_job_dev(C_QDMI_Job job) {
+  if (job == NULL) {
+    return;
+  }
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  if (job->status == QDMI_JOB_STATUS_SUBMITTED) {
+    C_QDMI_dequeue_job(job);
+    atomic_fetch_sub(C_QDMI_get_num_active_jobs(), 1);
+  }
+  // wait until the worker thread has released the job
+  while (job->executing) {
+    pthread_cond_wait(&state->cond, &state->mutex);
+  }
+  pthread_mutex_unlock(&state->mutex);
   // this method should free all resources associated with the job
+  C_QDMI_free_histogram(atomic_load(&job->histogram));
   if (job->results != NULL) {
     free(job->results);
     free(job->state_vec);
@@ -638,11 +1223,54 @@ void C_QDMI_control_free_job_dev(C_QDMI_Job job) {
 } /// [DOXYGEN FUNCTION END]
 
 int C_QDMI_control_initialize_dev(void) {
-  C_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  // the same library may be opened several times by a driver
+  if (state->num_initialized++ == 0) {
+    C_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
+  }
+  pthread_mutex_unlock(&state->mutex);
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
 int C_QDMI_control_finalize_dev(void) {
+  C_QDMI_Worker_State_t *state = C_QDMI_get_worker_state();
+  pthread_mutex_lock(&state->mutex);
+  if (state->num_initialized > 0 && --state->num_initialized > 0) {
+    pthread_mutex_unlock(&state->mutex);
+    return QDMI_SUCCESS;
+  }
+  state->stop = true;
+  // jobs that have not been started yet are cancelled
+  C_QDMI_Job cancelled = state->head;
+  for (C_QDMI_Job it = cancelled; it != NULL; it = it->next) {
+    it->status = QDMI_JOB_STATUS_CANCELLED;
+    atomic_fetch_sub(C_QDMI_get_num_active_jobs(), 1);
+  }
+  state->head = NULL;
+  state->tail = NULL;
+  pthread_cond_broadcast(&state->cond);
+  pthread_mutex_unlock(&state->mutex);
+  while (cancelled != NULL) {
+    C_QDMI_Job job = cancelled;
+    cancelled = job->next;
+    job->next = NULL;
+    if (job->callback != NULL) {
+      job->callback(job, QDMI_JOB_STATUS_CANCELLED, job->user_data);
+    }
+  }
+  if (state->started) {
+    pthread_join(state->thread, NULL);
+    state->started = false;
+  }
+  pthread_mutex_lock(&state->mutex);
+  state->stop = false;
+  pthread_mutex_unlock(&state->mutex);
   C_QDMI_set_device_status(QDMI_DEVICE_STATUS_OFFLINE);
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
+
+C_QDMI_DEVICE_VTABLE_DEFINE_WITH(C_QDMI_query_device_properties_dev,
+                                 C_QDMI_query_operation_properties_dev,
+                                 C_QDMI_control_set_callback_dev,
+                                 C_QDMI_control_wait_for_dev);
@@ -24,31 +24,137 @@ SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include "cxx_qdmi/device.h"
 
+#include "simulator.hpp"
+
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <complex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <fstream>
 #include <functional>
+#include <istream>
 #include <iterator>
 #include <limits>
 #include <map>
+#include <mutex>
+#include <new>
+#include <numeric>
 #include <random>
+#include <sstream>
 #include <string>
-#include <unordered_map>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+/**
+ * @brief The job parameter setting the maximum number of threads simulating a
+ * job as a `size_t`.
+ * @details The default of 0 uses all hardware threads. Circuits on few qubits
+ * are always simulated by a single thread.
+ */
+constexpr QDMI_Job_Parameter CXX_QDMI_JOB_PARAMETER_NUM_THREADS =
+    QDMI_JOB_PARAMETER_CUSTOM_1;
+
+/**
+ * @brief The device property reporting how many times the device was
+ * initialized and not finalized yet as a `size_t`.
+ * @details A driver may initialize the same library several times, e.g., once
+ * for every entry of its configuration that refers to it.
+ */
+constexpr QDMI_Device_Property CXX_QDMI_DEVICE_PROPERTY_NUM_INITIALIZED =
+    QDMI_DEVICE_PROPERTY_CUSTOM_2;
+
+/**
+ * @brief The device property reporting how many site and operation property
+ * queries the device answered as a `size_t`.
+ */
+constexpr QDMI_Device_Property
+    CXX_QDMI_DEVICE_PROPERTY_NUM_CALIBRATION_QUERIES =
+        QDMI_DEVICE_PROPERTY_CUSTOM_3;
+
+/**
+ * @brief The program format of a calibration run.
+ * @details Executing the job starts a new calibration epoch of the device. The
+ * content of the program is ignored and the job yields no shots. Since the
+ * calibration data of this device is fixed, it stays the same.
+ */
+constexpr QDMI_Program_Format CXX_QDMI_PROGRAM_FORMAT_CALIBRATION =
+    QDMI_PROGRAM_FORMAT_CUSTOM_1;
+
+/**
+ * @brief The job result reporting the number of qubits the results of a job
+ * comprise as a `size_t`.
+ * @details The results of a simulated program only comprise the qubits it
+ * declares: every bitstring has one character per qubit and the dense state
+ * has two to the power of this number amplitudes. The results of all other
+ * jobs comprise all qubits of the device.
+ */
+constexpr QDMI_Job_Result CXX_QDMI_JOB_RESULT_NUM_QUBITS =
+    QDMI_JOB_RESULT_CUSTOM_1;
+
+/**
+ * @brief The maximum number of qubits of the random state of a job that is
+ * not simulated.
+ * @details The state of larger devices is not available.
+ */
+constexpr size_t CXX_QDMI_MAX_RANDOM_STATE_QUBITS = 20;
+
 struct CXX_QDMI_Job_impl_d {
   int id = 0;
+  /// The status of the job, guarded by the mutex of the device state.
   QDMI_Job_Status status = QDMI_JOB_STATUS_SUBMITTED;
   size_t num_shots = 0;
-  std::vector<std::string> results;
-  std::vector<std::complex<double>> state_vec;
+  /// The number of qubits measured in every shot, see
+  /// @ref CXX_QDMI_JOB_RESULT_NUM_QUBITS.
+  size_t num_qubits = 0;
+  /// The measured bitstrings, packed into consecutive words per shot. The i-th
+  /// character of a bitstring is stored in bit i % 64 of word i / 64.
+  std::vector<uint64_t> shots;
+  /// Renders @ref shots into @ref shots_ascii on the first request.
+  std::once_flag shots_ascii_once;
+  /// The comma-separated bitstrings including the null terminator.
+  std::string shots_ascii;
+  /// Computes @ref hist_keys and @ref hist_values on the first request.
+  std::once_flag hist_once;
+  /// The distinct bitstrings in ascending order, comma-separated including the
+  /// null terminator.
+  std::string hist_keys;
+  /// The number of occurrences of each bitstring in @ref hist_keys.
+  std::vector<size_t> hist_values;
+  /// The circuit of a QASM2 program, simulated instead of random results.
+  CXX_QDMI_Circuit circuit;
+  /// Whether @ref circuit holds the program of the job.
+  bool simulate = false;
+  /// Whether the job is a calibration run.
+  bool calibrate = false;
+  /// The maximum number of threads simulating the job, 0 for all hardware
+  /// threads.
+  size_t num_threads = 0;
+  /// The state of the qubits of the program, where bit q of an index is the
+  /// value of qubit q. Empty if the state is not available.
+  CXX_QDMI_Amplitudes state_vec;
+  /// Whether the worker thread of the device currently holds the job.
+  bool executing = false;
+  /// The callback invoked when the job has finished or was cancelled.
+  CXX_QDMI_Job_Callback callback = nullptr;
+  /// The user data passed to the callback.
+  void *user_data = nullptr;
 };
 
 struct CXX_QDMI_Site_impl_d {
-  size_t id;
+  size_t id = 0;
+  /// The T1 time of the qubit.
+  double t1 = 0;
+  /// The T2 time of the qubit.
+  double t2 = 0;
 };
 
 struct CXX_QDMI_Operation_impl_d {
@@ -56,12 +162,138 @@ struct CXX_QDMI_Operation_impl_d {
 };
 
 struct CXX_QDMI_Device_State {
-  QDMI_Device_Status status = QDMI_DEVICE_STATUS_OFFLINE;
-  std::random_device rd;
-  std::mt19937 gen{rd()};
+  /// Either @ref QDMI_DEVICE_STATUS_OFFLINE or @ref QDMI_DEVICE_STATUS_IDLE.
+  std::atomic<QDMI_Device_Status> status = QDMI_DEVICE_STATUS_OFFLINE;
+  /// The number of submitted jobs that have not finished yet. The device is
+  /// reported as busy as long as this number is positive.
+  std::atomic<size_t> num_active_jobs = 0;
+
+  /// Protects the job queue and the status of all jobs.
+  std::mutex mutex;
+  /// Notified whenever a job is queued or changes its status.
+  std::condition_variable cv;
+  /// The submitted jobs waiting for execution.
+  std::deque<CXX_QDMI_Job> queue;
+  /// The job currently executed by the worker thread, if any.
+  CXX_QDMI_Job current = nullptr;
+  /// The thread executing the submitted jobs, started on the first submission.
+  std::thread worker;
+  /// Requests the worker thread to stop.
+  bool stop = false;
+  /// The number of times the device was initialized but not yet finalized.
+  size_t num_initialized = 0;
+  /// The current calibration epoch, advanced by every calibration run.
+  std::atomic<size_t> calibration_epoch = 0;
+  /// The number of site and operation property queries answered.
+  std::atomic<size_t> num_calibration_queries = 0;
+
+  CXX_QDMI_Device_State() = default;
+  CXX_QDMI_Device_State(const CXX_QDMI_Device_State &) = delete;
+  CXX_QDMI_Device_State &operator=(const CXX_QDMI_Device_State &) = delete;
+  CXX_QDMI_Device_State(CXX_QDMI_Device_State &&) = delete;
+  CXX_QDMI_Device_State &operator=(CXX_QDMI_Device_State &&) = delete;
+
+  ~CXX_QDMI_Device_State() {
+    // the worker must not outlive the state, even without finalization
+    if (worker.joinable()) {
+      {
+        const std::lock_guard lock(mutex);
+        stop = true;
+      }
+      cv.notify_all();
+      worker.join();
+    }
+  }
+};
+
+/**
+ * @brief The xoshiro256** pseudo random number generator, see
+ * https://prng.di.unimi.it.
+ * @details The generator runs several independent streams. A single draw uses
+ * the first stream only, whereas @ref fill advances all streams in lockstep.
+ * Since the state is laid out stream-minor, the compiler vectorizes the bulk
+ * generation of random bits.
+ */
+struct CXX_QDMI_Xoshiro256 {
+  using result_type = uint64_t;
+  /// The number of independent streams.
+  static constexpr size_t LANES = 4;
+
+  /// The k-th state word of stream l is `state[k][l]`.
+  std::array<std::array<uint64_t, LANES>, 4> state{};
+
+  explicit CXX_QDMI_Xoshiro256(uint64_t seed) {
+    // expand the seed with splitmix64 as recommended by the authors
+    for (auto &word : state) {
+      for (auto &lane : word) {
+        seed += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+        lane = z ^ (z >> 31U);
+      }
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() { return next(0); }
+
+  /**
+   * @brief Fill a buffer with random words.
+   * @param out the buffer to fill.
+   * @param num_words the number of words to write.
+   */
+  void fill(uint64_t *out, const size_t num_words) {
+    // work on a local copy, which the compiler knows not to alias the output
+    auto local = state;
+    size_t i = 0;
+    for (; i + LANES <= num_words; i += LANES) {
+      for (size_t l = 0; l < LANES; ++l) {
+        out[i + l] = step(local, l);
+      }
+    }
+    for (; i < num_words; ++i) {
+      out[i] = step(local, 0);
+    }
+    state = local;
+  }
+
+private:
+  static constexpr uint64_t rotl(const uint64_t x, const unsigned int k) {
+    return (x << k) | (x >> (64U - k));
+  }
+
+  static result_type step(std::array<std::array<uint64_t, LANES>, 4> &s,
+                          const size_t l) {
+    const uint64_t result = rotl(s[1][l] * 5, 7) * 9;
+    const uint64_t t = s[1][l] << 17U;
+    s[2][l] ^= s[0][l];
+    s[3][l] ^= s[1][l];
+    s[1][l] ^= s[2][l];
+    s[0][l] ^= s[3][l];
+    s[2][l] ^= t;
+    s[3][l] = rotl(s[3][l], 45);
+    return result;
+  }
+
+  result_type next(const size_t l) { return step(state, l); }
+};
+
+/**
+ * @brief The random number generators of a single thread.
+ * @details Every thread owns its generators such that concurrent job creation
+ * and execution do not contend on a shared lock.
+ */
+struct CXX_QDMI_Random_Generators {
+  CXX_QDMI_Xoshiro256 gen{(static_cast<uint64_t>(std::random_device{}())
+                           << 32U) |
+                          std::random_device{}()};
   std::uniform_int_distribution<> dis =
       std::uniform_int_distribution<>(0, std::numeric_limits<int>::max());
-  std::bernoulli_distribution dis_bin{0.5};
   std::uniform_real_distribution<> dis_real =
       std::uniform_real_distribution<>(-1.0, 1.0);
 };
@@ -78,6 +310,18 @@ CXX_QDMI_Device_State *CXX_QDMI_get_device_state() {
   return &device_state;
 }
 
+/**
+ * @brief Local function to read how often the device is initialized.
+ * @return the number of initializations that were not finalized yet.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+size_t CXX_QDMI_get_num_initialized() {
+  auto *state = CXX_QDMI_get_device_state();
+  const std::lock_guard lock(state->mutex);
+  return state->num_initialized;
+}
+
 /**
  * @brief Local function to read the device status.
  * @return the current device status.
@@ -85,7 +329,12 @@ CXX_QDMI_Device_State *CXX_QDMI_get_device_state() {
  * this file. Hence, it is not part of any header file.
  */
 QDMI_Device_Status CXX_QDMI_get_device_status() {
-  return CXX_QDMI_get_device_state()->status;
+  const auto *state = CXX_QDMI_get_device_state();
+  const auto status = state->status.load();
+  if (status == QDMI_DEVICE_STATUS_IDLE && state->num_active_jobs.load() > 0) {
+    return QDMI_DEVICE_STATUS_BUSY;
+  }
+  return status;
 }
 
 /**
@@ -95,7 +344,19 @@ QDMI_Device_Status CXX_QDMI_get_device_status() {
  * this file. Hence, it is not part of any header file.
  */
 void CXX_QDMI_set_device_status(QDMI_Device_Status status) {
-  CXX_QDMI_get_device_state()->status = status;
+  CXX_QDMI_get_device_state()->status.store(status);
+}
+
+/**
+ * @brief Static function to maintain the random number generators of the
+ * calling thread.
+ * @return a reference to the random number generators.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+CXX_QDMI_Random_Generators &CXX_QDMI_get_random_generators() {
+  thread_local CXX_QDMI_Random_Generators generators;
+  return generators;
 }
 
 /**
@@ -105,19 +366,19 @@ void CXX_QDMI_set_device_status(QDMI_Device_Status status) {
  * this file. Hence, it is not part of any header file.
  */
 int CXX_QDMI_generate_job_id() {
-  auto *state = CXX_QDMI_get_device_state();
-  return state->dis(state->gen);
+  auto &rng = CXX_QDMI_get_random_generators();
+  return rng.dis(rng.gen);
 }
 
 /**
- * @brief Generate a random bit.
- * @return a random bit.
+ * @brief Fill a buffer with random bits.
+ * @param words the buffer to fill.
+ * @param num_words the number of 64-bit words to write.
  * @note This function is considered private and should not be used outside of
  * this file. Hence, it is not part of any header file.
  */
-bool CXX_QDMI_generate_bit() {
-  auto *state = CXX_QDMI_get_device_state();
-  return state->dis_bin(state->gen);
+void CXX_QDMI_generate_bits(uint64_t *words, const size_t num_words) {
+  CXX_QDMI_get_random_generators().gen.fill(words, num_words);
 }
 
 /**
@@ -127,73 +388,683 @@ bool CXX_QDMI_generate_bit() {
  * this file. Hence, it is not part of any header file.
  */
 double CXX_QDMI_generate_real() {
+  auto &rng = CXX_QDMI_get_random_generators();
+  return rng.dis_real(rng.gen);
+}
+
+/**
+ * @brief Compute the number of words holding the bitstring of one shot.
+ * @param num_qubits the number of measured qubits.
+ * @return the number of words per shot.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+constexpr size_t CXX_QDMI_num_shot_words(const size_t num_qubits) {
+  return (num_qubits + 63) / 64;
+}
+
+/**
+ * @brief Write a packed bitstring as characters.
+ * @param words the words holding the bitstring.
+ * @param num_qubits the number of bits in the bitstring.
+ * @param out the buffer receiving `num_qubits` characters.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+void CXX_QDMI_render_bits(const uint64_t *words, const size_t num_qubits,
+                          char *out) {
+  for (size_t i = 0; i < num_qubits; ++i) {
+    out[i] = ((words[i / 64] >> (i % 64)) & 1U) != 0 ? '1' : '0';
+  }
+}
+
+/**
+ * @brief Write the bitstring of a shot as characters.
+ * @param job the job holding the shot.
+ * @param shot the index of the shot.
+ * @param out the buffer receiving `job->num_qubits` characters.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+void CXX_QDMI_render_shot(const CXX_QDMI_Job_impl_d &job, const size_t shot,
+                          char *out) {
+  CXX_QDMI_render_bits(
+      job.shots.data() + (shot * CXX_QDMI_num_shot_words(job.num_qubits)),
+      job.num_qubits, out);
+}
+
+/**
+ * @brief Get the comma-separated bitstrings of all shots of a job.
+ * @details The text is rendered once on the first call and then reused, such
+ * that repeated requests only copy it.
+ * @param job the job, which must be done.
+ * @return the bitstrings including the null terminator, or an empty string if
+ * the job has no shots.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+const std::string &CXX_QDMI_get_shots_ascii(CXX_QDMI_Job job) {
+  std::call_once(job->shots_ascii_once, [job] {
+    if (job->num_shots == 0) {
+      return;
+    }
+    const size_t stride = job->num_qubits + 1;
+    job->shots_ascii.resize(job->num_shots * stride);
+    for (size_t i = 0; i < job->num_shots; ++i) {
+      CXX_QDMI_render_shot(*job, i, &job->shots_ascii[i * stride]);
+      job->shots_ascii[((i + 1) * stride) - 1] = ',';
+    }
+    job->shots_ascii.back() = '\0';
+  });
+  return job->shots_ascii;
+}
+
+/**
+ * @brief Compute the histogram of the shots of a job.
+ * @details The distinct bitstrings are counted in a flat hash table with open
+ * addressing that is keyed by the packed bitstrings. Afterwards, the entries
+ * are ordered by their bitstrings and stored in @ref
+ * CXX_QDMI_Job_impl_d::hist_keys and @ref CXX_QDMI_Job_impl_d::hist_values in
+ * matching order.
+ * @param job the job, which must be done.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+void CXX_QDMI_compute_histogram(CXX_QDMI_Job job) {
+  constexpr auto empty = std::numeric_limits<size_t>::max();
+  const size_t num_words = CXX_QDMI_num_shot_words(job->num_qubits);
+  const auto hash = [num_words](const uint64_t *key) {
+    uint64_t h = 0;
+    for (size_t w = 0; w < num_words; ++w) {
+      h = (h ^ key[w]) * 0x9E3779B97F4A7C15ULL;
+    }
+    return static_cast<size_t>(h ^ (h >> 32U));
+  };
+  // the packed bitstrings and counts of the entries in order of insertion
+  std::vector<uint64_t> keys;
+  std::vector<size_t> counts;
+  // the table maps slots to entries and is kept at most half full
+  std::vector<size_t> table(16, empty);
+  for (size_t i = 0; i < job->num_shots; ++i) {
+    const auto *shot = job->shots.data() + (i * num_words);
+    size_t slot = hash(shot) & (table.size() - 1);
+    while (table[slot] != empty &&
+           !std::equal(shot, shot + num_words,
+                       keys.data() + (table[slot] * num_words))) {
+      slot = (slot + 1) & (table.size() - 1);
+    }
+    if (table[slot] != empty) {
+      ++counts[table[slot]];
+      continue;
+    }
+    table[slot] = counts.size();
+    keys.insert(keys.end(), shot, shot + num_words);
+    counts.emplace_back(1);
+    if (2 * counts.size() > table.size()) {
+      std::vector<size_t> grown(2 * table.size(), empty);
+      for (size_t e = 0; e < counts.size(); ++e) {
+        slot = hash(keys.data() + (e * num_words)) & (grown.size() - 1);
+        while (grown[slot] != empty) {
+          slot = (slot + 1) & (grown.size() - 1);
+        }
+        grown[slot] = e;
+      }
+      table = std::move(grown);
+    }
+  }
+  // order the entries by their bitstrings
+  const size_t stride = job->num_qubits + 1;
+  std::string rendered(counts.size() * stride, ',');
+  for (size_t e = 0; e < counts.size(); ++e) {
+    CXX_QDMI_render_bits(keys.data() + (e * num_words), job->num_qubits,
+                         &rendered[e * stride]);
+  }
+  std::vector<size_t> order(counts.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+    return rendered.compare(a * stride, job->num_qubits, rendered,
+                            b * stride, job->num_qubits) < 0;
+  });
+  job->hist_keys.resize(rendered.size());
+  job->hist_values.resize(counts.size());
+  for (size_t e = 0; e < order.size(); ++e) {
+    std::copy_n(&rendered[order[e] * stride], stride,
+                &job->hist_keys[e * stride]);
+    job->hist_values[e] = counts[order[e]];
+  }
+  if (!job->hist_keys.empty()) {
+    job->hist_keys.back() = '\0';
+  }
+}
+
+/**
+ * @brief Generate random results for a job whose program is not simulated.
+ * @param job the job.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+void CXX_QDMI_generate_random_results(CXX_QDMI_Job job) {
+  const size_t num_qubits = job->num_qubits;
+  const size_t num_words = CXX_QDMI_num_shot_words(num_qubits);
+  // all shots are stored in a single allocation
+  job->shots.resize(job->num_shots * num_words);
+  CXX_QDMI_generate_bits(job->shots.data(), job->shots.size());
+  // clear the bits beyond the last qubit of every shot
+  if (num_qubits % 64 != 0) {
+    const uint64_t mask = (uint64_t{1} << (num_qubits % 64)) - 1;
+    for (size_t i = 0; i < job->num_shots; ++i) {
+      job->shots[((i + 1) * num_words) - 1] &= mask;
+    }
+  }
+  // Generate random complex numbers and calculate the norm
+  job->state_vec.clear();
+  if (num_qubits > CXX_QDMI_MAX_RANDOM_STATE_QUBITS) {
+    return;
+  }
+  const size_t num_amplitudes = size_t{1} << num_qubits;
+  job->state_vec.reserve(num_amplitudes);
+  double norm = 0.0;
+  for (size_t i = 0; i < num_amplitudes; ++i) {
+    const auto &c = job->state_vec.emplace_back(CXX_QDMI_generate_real(),
+                                                CXX_QDMI_generate_real());
+    norm += std::norm(c);
+  }
+  // Normalize the vector
+  norm = std::sqrt(norm);
+  for (auto &c : job->state_vec) {
+    c /= norm;
+  }
+}
+
+/**
+ * @brief Simulate the circuit of a job and sample its shots from the final
+ * state.
+ * @details The state and the shots only comprise the qubits declared by the
+ * program.
+ * @param job the job.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+void CXX_QDMI_simulate_job(CXX_QDMI_Job job) {
+  const size_t num_qubits = job->num_qubits;
+  CXX_QDMI_simulate(job->circuit, num_qubits, job->num_threads,
+                    job->state_vec);
+  // every shot is drawn from one word of random bits
+  std::vector<uint64_t> samples(job->num_shots);
+  CXX_QDMI_generate_bits(samples.data(), samples.size());
+  CXX_QDMI_sample(job->state_vec, samples.data(), samples.size());
+  // the i-th character of a bitstring is the value of qubit num_qubits - 1 - i
+  const size_t num_words = CXX_QDMI_num_shot_words(num_qubits);
+  job->shots.assign(job->num_shots * num_words, 0);
+  for (size_t i = 0; i < job->num_shots; ++i) {
+    uint64_t *shot = job->shots.data() + (i * num_words);
+    for (size_t q = 0; q < num_qubits; ++q) {
+      const size_t j = num_qubits - 1 - q;
+      shot[j / 64] |= ((samples[i] >> q) & 1U) << (j % 64);
+    }
+  }
+}
+
+/**
+ * @brief Execute a job.
+ * @details Jobs created from a QASM2 program are simulated, all other jobs
+ * receive random results.
+ * @param job the job to execute.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+void CXX_QDMI_execute_job(CXX_QDMI_Job job) {
+  if (job->calibrate) {
+    job->num_shots = 0;
+    ++CXX_QDMI_get_device_state()->calibration_epoch;
+  } else if (job->simulate) {
+    job->num_qubits = job->circuit.num_qubits;
+    CXX_QDMI_simulate_job(job);
+  } else {
+    CXX_QDMI_query_device_property_dev(QDMI_DEVICE_PROPERTY_QUBITSNUM,
+                                       sizeof(size_t), &job->num_qubits,
+                                       nullptr);
+    CXX_QDMI_generate_random_results(job);
+  }
+}
+
+/**
+ * @brief The main loop of the worker thread executing the submitted jobs.
+ * @details Jobs are executed in the order of their submission until the device
+ * is finalized. Once a job has finished, its callback is invoked. A job whose
+ * results do not fit into memory is cancelled instead.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+void CXX_QDMI_run_worker() {
   auto *state = CXX_QDMI_get_device_state();
-  return state->dis_real(state->gen);
+  std::unique_lock lock(state->mutex);
+  while (true) {
+    state->cv.wait(lock,
+                   [state] { return state->stop || !state->queue.empty(); });
+    if (state->stop) {
+      return;
+    }
+    auto *job = state->queue.front();
+    state->queue.pop_front();
+    job->status = QDMI_JOB_STATUS_RUNNING;
+    job->executing = true;
+    state->current = job;
+    lock.unlock();
+    auto status = QDMI_JOB_STATUS_DONE;
+    try {
+      CXX_QDMI_execute_job(job);
+    } catch (const std::bad_alloc &) {
+      // release the partial results
+      job->shots = {};
+      job->state_vec = {};
+      status = QDMI_JOB_STATUS_CANCELLED;
+    }
+    lock.lock();
+    state->current = nullptr;
+    // the job might have been cancelled in the meantime
+    if (job->status == QDMI_JOB_STATUS_RUNNING) {
+      job->status = status;
+      --state->num_active_jobs;
+      const auto callback = job->callback;
+      auto *user_data = job->user_data;
+      lock.unlock();
+      state->cv.notify_all();
+      if (callback != nullptr) {
+        callback(job, status, user_data);
+      }
+      lock.lock();
+    }
+    // only now the job may be freed
+    job->executing = false;
+    state->cv.notify_all();
+  }
 }
 
 // NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
 std::array<CXX_QDMI_Operation_impl_d, 4> device_operations = {
     CXX_QDMI_Operation_impl_d{"rx"}, CXX_QDMI_Operation_impl_d{"ry"},
     CXX_QDMI_Operation_impl_d{"rz"}, CXX_QDMI_Operation_impl_d{"cx"}};
-
-std::array<CXX_QDMI_Site_impl_d, 7> device_sites = {
-    CXX_QDMI_Site_impl_d{0}, CXX_QDMI_Site_impl_d{1}, CXX_QDMI_Site_impl_d{2},
-    CXX_QDMI_Site_impl_d{3}, CXX_QDMI_Site_impl_d{4}};
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
-} // namespace
 
-constexpr static std::array<const CXX_QDMI_Site_impl_d *const, 20>
-    // clang-format off
-    DEVICE_COUPLING_MAP = {
-      device_sites.data(), &device_sites[1],
-      &device_sites[1], device_sites.data(),
-      &device_sites[1], &device_sites[2],
-      &device_sites[2], &device_sites[1],
-      &device_sites[2], &device_sites[3],
-      &device_sites[3], &device_sites[2],
-      &device_sites[3], &device_sites[4],
-      &device_sites[4], &device_sites[3],
-      &device_sites[4], device_sites.data(),
-      device_sites.data(), &device_sites[4]};
-// clang-format on
-
-const static std::unordered_map<const CXX_QDMI_Operation_impl_d *, double>
-    OPERATION_DURATIONS = {
-        {device_operations.data(), 0.01},
-        {&device_operations[1], 0.01},
-        {&device_operations[2], 0.01},
-        {&device_operations[3], 0.1},
+/// The index of the only two-qubit operation in @ref device_operations.
+constexpr size_t CX_INDEX = 3;
+
+/// The calibration data of a two-qubit operation on an edge.
+struct CXX_QDMI_Edge_data {
+  double fidelity = 0;
+  double duration = 0;
 };
 
-struct CXX_QDMI_Pair_hash {
-  template <class T1, class T2>
-  size_t operator()(const std::pair<T1, T2> &p) const {
-    auto hash1 = std::hash<T1>{}(p.first);
-    auto hash2 = std::hash<T2>{}(p.second);
-    return hash1 ^ hash2;
+/**
+ * @brief The edges of the device, indexed by the ids of their sites.
+ * @details The data of the edges is stored in a single array, sorted by the
+ * ids of their first and second site. For small devices, a dense matrix maps
+ * every pair of sites to its edge in a single load. For larger devices, whose
+ * matrix would mostly be empty, the second sites of the edges starting at a
+ * site are searched in its row of the array, as in the compressed sparse row
+ * format.
+ */
+struct CXX_QDMI_Edge_table {
+  /// The maximum number of sites for which the dense matrix is used.
+  static constexpr size_t DENSE_MAX_SITES = 128;
+
+  /**
+   * @brief Build the table.
+   * @param num_sites the number of sites.
+   * @param directed_edges the ids of the sites and the data of every directed
+   * edge, where the last data of duplicate edges is kept.
+   */
+  void build(size_t num_sites,
+             std::vector<std::pair<std::pair<uint32_t, uint32_t>,
+                                   CXX_QDMI_Edge_data>> &&directed_edges);
+
+  /**
+   * @brief Find the edge between two sites.
+   * @param first the id of the first site, less than the number of sites.
+   * @param second the id of the second site, less than the number of sites.
+   * @return the data of the edge, or `nullptr` if there is no such edge.
+   */
+  [[nodiscard]] const CXX_QDMI_Edge_data *find(const size_t first,
+                                               const size_t second) const {
+    if (!dense.empty()) {
+      const uint32_t e = dense[(first * num_sites) + second];
+      return e == NO_EDGE ? nullptr : &edges[e];
+    }
+    const uint32_t *begin = columns.data() + row_offsets[first];
+    const uint32_t *end = columns.data() + row_offsets[first + 1];
+    const uint32_t *it = std::lower_bound(begin, end, second);
+    return (it == end || *it != second)
+               ? nullptr
+               : &edges[static_cast<size_t>(it - columns.data())];
   }
+
+private:
+  static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+  size_t num_sites = 0;
+  std::vector<CXX_QDMI_Edge_data> edges;
+  /// The index of the edge of every pair of sites, or @ref NO_EDGE.
+  std::vector<uint32_t> dense;
+  /// The edges of site i are at the indices [row_offsets[i], row_offsets[i+1]).
+  std::vector<size_t> row_offsets;
+  /// The id of the second site of every edge.
+  std::vector<uint32_t> columns;
 };
 
-const static std::unordered_map<
-    const CXX_QDMI_Operation_impl_d *,
-    std::unordered_map<
-        std::pair<const CXX_QDMI_Site_impl_d *, const CXX_QDMI_Site_impl_d *>,
-        double, CXX_QDMI_Pair_hash>>
-    OPERATION_FIDELITIES = {
-        {&device_operations[3],
-         {{{device_sites.data(), &device_sites[1]}, 0.99},
-          {{&device_sites[1], device_sites.data()}, 0.99},
-          {{&device_sites[1], &device_sites[2]}, 0.98},
-          {{&device_sites[2], &device_sites[1]}, 0.98},
-          {{&device_sites[2], &device_sites[3]}, 0.97},
-          {{&device_sites[3], &device_sites[2]}, 0.97},
-          {{&device_sites[3], &device_sites[4]}, 0.96},
-          {{&device_sites[4], &device_sites[3]}, 0.96},
-          {{&device_sites[4], device_sites.data()}, 0.95},
-          {{device_sites.data(), &device_sites[4]}, 0.95}}},
-        // No need to specify single-qubit fidelities here
+void CXX_QDMI_Edge_table::build(
+    const size_t num_device_sites,
+    std::vector<std::pair<std::pair<uint32_t, uint32_t>, CXX_QDMI_Edge_data>>
+        &&directed_edges) {
+  num_sites = num_device_sites;
+  std::stable_sort(
+      directed_edges.begin(), directed_edges.end(),
+      [](const auto &a, const auto &b) { return a.first < b.first; });
+  edges.clear();
+  dense.clear();
+  columns.clear();
+  row_offsets.assign(num_sites + 1, 0);
+  for (size_t i = 0; i < directed_edges.size(); ++i) {
+    const auto &[sites, data] = directed_edges[i];
+    if (i + 1 < directed_edges.size() &&
+        directed_edges[i + 1].first == sites) {
+      continue;
+    }
+    edges.emplace_back(data);
+    columns.emplace_back(sites.second);
+    ++row_offsets[sites.first + 1];
+  }
+  std::partial_sum(row_offsets.begin(), row_offsets.end(),
+                   row_offsets.begin());
+  if (num_sites <= DENSE_MAX_SITES) {
+    dense.assign(num_sites * num_sites, NO_EDGE);
+    for (size_t first = 0; first < num_sites; ++first) {
+      for (size_t e = row_offsets[first]; e < row_offsets[first + 1]; ++e) {
+        dense[(first * num_sites) + columns[e]] = static_cast<uint32_t>(e);
+      }
+    }
+    columns.clear();
+    row_offsets.clear();
+  }
+}
+
+/**
+ * @brief The topology and calibration data of the device.
+ * @details The description is loaded when the device is initialized and does
+ * not change until it is finalized. Hence, it is read without locking.
+ */
+struct CXX_QDMI_Device_Description {
+  /// The text the description was parsed from.
+  std::string source;
+  std::string name;
+  /// The sites of the device, where the i-th site has the id i.
+  std::vector<CXX_QDMI_Site_impl_d> sites;
+  /// The coupling map as consecutive pairs of sites.
+  std::vector<CXX_QDMI_Site> coupling_map;
+  /// The duration of every operation in @ref device_operations.
+  std::array<double, 4> durations = {0.01, 0.01, 0.01, 0.1};
+  /// The fidelity of every single-qubit operation in @ref device_operations.
+  std::array<double, 4> fidelities = {0.999, 0.999, 0.999, 0};
+  /// The fidelities and durations of `cx` on every edge.
+  CXX_QDMI_Edge_table cx_edges;
 };
 
+/**
+ * @brief The description of the device if no description file is given.
+ * @details A ring of five qubits.
+ */
+constexpr const char *DEFAULT_DEVICE_DESCRIPTION = R"(
+name C++ Device with 5 qubits
+qubits 5
+coherence 1000 100000
+edge 0 1 0.99
+edge 1 2 0.98
+edge 2 3 0.97
+edge 3 4 0.96
+edge 4 0 0.95
+)";
+
+/**
+ * @brief Find an operation by its name.
+ * @return the index of the operation in @ref device_operations, or the number
+ * of operations if there is none of that name.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+size_t CXX_QDMI_find_operation(const std::string &name) {
+  size_t i = 0;
+  while (i < device_operations.size() && name != device_operations[i].name) {
+    ++i;
+  }
+  return i;
+}
+
+/**
+ * @brief Parse a device description.
+ * @details Every line contains one of the following entries, where empty lines
+ * and lines starting with `#` are ignored:
+ * - `name <name>`: the name of the device, i.e., the rest of the line.
+ * - `qubits <num>`: the number of qubits, which must precede all entries
+ *   referring to sites.
+ * - `coherence <t1> <t2>`: the T1 and T2 times of all qubits.
+ * - `site <site> <t1> <t2>`: the T1 and T2 times of a single qubit.
+ * - `duration <operation> <duration>`: the duration of an operation.
+ * - `fidelity <operation> <fidelity>`: the fidelity of a single-qubit
+ *   operation.
+ * - `edge <site> <site> <fidelity> [<duration>]`: a coupling in both
+ *   directions with the fidelity and, optionally, the duration of `cx`. A
+ *   repeated coupling of the same sites, in either order, replaces the data of
+ *   the earlier one.
+ * @param input the stream to read the description from.
+ * @param description the description to fill.
+ * @return @ref QDMI_SUCCESS if the description was parsed, otherwise
+ * @ref QDMI_ERROR_INVALIDARGUMENT.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+int CXX_QDMI_parse_device_description(
+    std::istream &input, CXX_QDMI_Device_Description &description) {
+  description = CXX_QDMI_Device_Description{};
+  // the edges refer to the sites, which are only allocated by `qubits`
+  std::vector<std::tuple<size_t, size_t, double, double>> edges;
+  // the index in `edges` of every coupling, keyed by its ordered sites
+  std::map<std::pair<size_t, size_t>, size_t> edge_indices;
+  const auto valid_site = [&description](const size_t site) {
+    return site < description.sites.size();
+  };
+  std::string line;
+  while (std::getline(input, line)) {
+    std::istringstream iss(line);
+    std::string key;
+    if (!(iss >> key) || key[0] == '#') {
+      continue;
+    }
+    bool valid = true;
+    if (key == "name") {
+      std::getline(iss >> std::ws, description.name);
+    } else if (key == "qubits") {
+      size_t num_qubits = 0;
+      // the ids of the sites are stored in 32 bits by the edge table
+      valid = static_cast<bool>(iss >> num_qubits) && num_qubits > 0 &&
+              num_qubits < std::numeric_limits<uint32_t>::max() &&
+              description.sites.empty();
+      for (size_t i = 0; valid && i < num_qubits; ++i) {
+        description.sites.emplace_back(CXX_QDMI_Site_impl_d{i, 0, 0});
+      }
+    } else if (key == "coherence") {
+      double t1 = 0;
+      double t2 = 0;
+      valid = static_cast<bool>(iss >> t1 >> t2);
+      for (auto &site : description.sites) {
+        site.t1 = t1;
+        site.t2 = t2;
+      }
+    } else if (key == "site") {
+      size_t site = 0;
+      double t1 = 0;
+      double t2 = 0;
+      valid = static_cast<bool>(iss >> site >> t1 >> t2) && valid_site(site);
+      if (valid) {
+        description.sites[site].t1 = t1;
+        description.sites[site].t2 = t2;
+      }
+    } else if (key == "duration" || key == "fidelity") {
+      std::string operation;
+      double value = 0;
+      valid = static_cast<bool>(iss >> operation >> value);
+      const size_t i = CXX_QDMI_find_operation(operation);
+      valid = valid && i < device_operations.size() &&
+              (key == "duration" || i != CX_INDEX);
+      if (valid) {
+        (key == "duration" ? description.durations
+                           : description.fidelities)[i] = value;
+      }
+    } else if (key == "edge") {
+      size_t a = 0;
+      size_t b = 0;
+      double fidelity = 0;
+      // a missing duration is filled in with the duration of `cx` below
+      double duration = -1;
+      valid = static_cast<bool>(iss >> a >> b >> fidelity) && valid_site(a) &&
+              valid_site(b) && a != b;
+      if (valid && !(iss >> duration)) {
+        duration = -1;
+      }
+      const auto [it, inserted] =
+          edge_indices.try_emplace(std::minmax(a, b), edges.size());
+      if (inserted) {
+        edges.emplace_back(a, b, fidelity, duration);
+      } else {
+        edges[it->second] = {a, b, fidelity, duration};
+      }
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+  }
+  if (description.sites.empty()) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  if (description.name.empty()) {
+    description.name = "C++ Device with " +
+                       std::to_string(description.sites.size()) + " qubits";
+  }
+  std::vector<std::pair<std::pair<uint32_t, uint32_t>, CXX_QDMI_Edge_data>>
+      directed_edges;
+  directed_edges.reserve(2 * edges.size());
+  description.coupling_map.reserve(4 * edges.size());
+  for (const auto &[a, b, fidelity, duration] : edges) {
+    const CXX_QDMI_Edge_data data{
+        fidelity, duration < 0 ? description.durations[CX_INDEX] : duration};
+    for (const auto &[first, second] : {std::pair{a, b}, std::pair{b, a}}) {
+      description.coupling_map.emplace_back(&description.sites[first]);
+      description.coupling_map.emplace_back(&description.sites[second]);
+      directed_edges.emplace_back(std::pair{static_cast<uint32_t>(first),
+                                            static_cast<uint32_t>(second)},
+                                  data);
+    }
+  }
+  description.cx_edges.build(description.sites.size(),
+                             std::move(directed_edges));
+  return QDMI_SUCCESS;
+}
+
+/**
+ * @brief Static function to maintain the device descriptions.
+ * @details Every description that has been loaded is kept for the lifetime of
+ * the library, since clients may still hold handles to its sites after the
+ * device has been finalized and initialized again. The last description is the
+ * one of the device.
+ * @return a reference to the loaded device descriptions.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+std::deque<CXX_QDMI_Device_Description> &CXX_QDMI_get_device_descriptions() {
+  static std::deque<CXX_QDMI_Device_Description> descriptions = [] {
+    std::deque<CXX_QDMI_Device_Description> d(1);
+    std::istringstream input(DEFAULT_DEVICE_DESCRIPTION);
+    CXX_QDMI_parse_device_description(input, d.back());
+    d.back().source = DEFAULT_DEVICE_DESCRIPTION;
+    return d;
+  }();
+  return descriptions;
+}
+
+/**
+ * @brief Get the current description of the device.
+ * @return a pointer to the device description.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+CXX_QDMI_Device_Description *CXX_QDMI_get_device_description() {
+  return &CXX_QDMI_get_device_descriptions().back();
+}
+
+/**
+ * @brief Find the `cx` edge between two sites of the device.
+ * @param description the device description.
+ * @param first the first site.
+ * @param second the second site.
+ * @return the data of the edge, or `nullptr` if the sites are not coupled or
+ * do not belong to the device.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+const CXX_QDMI_Edge_data *
+CXX_QDMI_find_cx_edge(const CXX_QDMI_Device_Description &description,
+                      const CXX_QDMI_Site_impl_d *first,
+                      const CXX_QDMI_Site_impl_d *second) {
+  const auto &sites = description.sites;
+  if (first == nullptr || second == nullptr || first->id >= sites.size() ||
+      second->id >= sites.size() || &sites[first->id] != first ||
+      &sites[second->id] != second) {
+    return nullptr;
+  }
+  return description.cx_edges.find(first->id, second->id);
+}
+
+/**
+ * @brief Load the device description.
+ * @details The description is read from the file named by the environment
+ * variable `CXX_QDMI_DEVICE_FILE` or, if it is not set, from
+ * @ref DEFAULT_DEVICE_DESCRIPTION. If the text is the same as the one of the
+ * current description, the current description is kept. Otherwise, the new
+ * description is appended to @ref CXX_QDMI_get_device_descriptions such that
+ * the sites of the previous ones stay valid.
+ * @return @ref QDMI_SUCCESS if the description was loaded, otherwise
+ * @ref QDMI_ERROR_FATAL.
+ * @note This function is considered private and should not be used outside of
+ * this file. Hence, it is not part of any header file.
+ */
+int CXX_QDMI_load_device_description() {
+  std::string source = DEFAULT_DEVICE_DESCRIPTION;
+  // NOLINTNEXTLINE(concurrency-mt-unsafe) not modified by the device
+  if (const char *file_name = std::getenv("CXX_QDMI_DEVICE_FILE");
+      file_name != nullptr) {
+    std::ifstream input(file_name);
+    if (!input) {
+      return QDMI_ERROR_FATAL;
+    }
+    std::ostringstream buffer;
+    buffer << input.rdbuf();
+    source = buffer.str();
+  }
+  auto &descriptions = CXX_QDMI_get_device_descriptions();
+  if (source == descriptions.back().source) {
+    return QDMI_SUCCESS;
+  }
+  CXX_QDMI_Device_Description description;
+  std::istringstream input(source);
+  if (CXX_QDMI_parse_device_description(input, description) != QDMI_SUCCESS) {
+    return QDMI_ERROR_FATAL;
+  }
+  description.source = std::move(source);
+  descriptions.emplace_back(std::move(description));
+  return QDMI_SUCCESS;
+}
+} // namespace
+
 // NOLINTBEGIN(bugprone-macro-parentheses)
 #define ADD_SINGLE_VALUE_PROPERTY(prop_name, prop_type, prop_value, prop,      \
                                   size, value, size_ret)                       \
@@ -256,6 +1127,7 @@ int CXX_QDMI_query_get_sites_dev(const size_t num_entries, CXX_QDMI_Site *sites,
       (sites == nullptr && num_sites == nullptr)) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
+  auto &device_sites = CXX_QDMI_get_device_description()->sites;
   if (sites != nullptr) {
     for (size_t i = 0; i < std::min(num_entries, device_sites.size()); ++i) {
       sites[i] = &device_sites[i];
@@ -293,19 +1165,32 @@ int CXX_QDMI_query_device_property_dev(const QDMI_Device_Property prop,
       (value == nullptr && size_ret == nullptr)) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
-  ADD_STRING_PROPERTY(QDMI_DEVICE_PROPERTY_NAME, "C++ Device with 5 qubits",
+  const auto *description = CXX_QDMI_get_device_description();
+  ADD_STRING_PROPERTY(QDMI_DEVICE_PROPERTY_NAME, description->name.c_str(),
                       prop, size, value, size_ret)
   ADD_STRING_PROPERTY(QDMI_DEVICE_PROPERTY_VERSION, "0.1.0", prop, size, value,
                       size_ret)
   ADD_STRING_PROPERTY(QDMI_DEVICE_PROPERTY_LIBRARYVERSION, "1.0.0", prop, size,
                       value, size_ret)
-  ADD_SINGLE_VALUE_PROPERTY(QDMI_DEVICE_PROPERTY_QUBITSNUM, size_t, 5, prop,
-                            size, value, size_ret)
+  ADD_SINGLE_VALUE_PROPERTY(QDMI_DEVICE_PROPERTY_QUBITSNUM, size_t,
+                            description->sites.size(), prop, size, value,
+                            size_ret)
   ADD_SINGLE_VALUE_PROPERTY(QDMI_DEVICE_PROPERTY_STATUS, QDMI_Device_Status,
                             CXX_QDMI_get_device_status(), prop, size, value,
                             size_ret)
+  ADD_SINGLE_VALUE_PROPERTY(CXX_QDMI_DEVICE_PROPERTY_NUM_INITIALIZED, size_t,
+                            CXX_QDMI_get_num_initialized(), prop, size, value,
+                            size_ret)
+  ADD_SINGLE_VALUE_PROPERTY(
+      CXX_QDMI_DEVICE_PROPERTY_NUM_CALIBRATION_QUERIES, size_t,
+      CXX_QDMI_get_device_state()->num_calibration_queries.load(), prop, size,
+      value, size_ret)
+  ADD_SINGLE_VALUE_PROPERTY(
+      QDMI_DEVICE_PROPERTY_CALIBRATIONEPOCH, size_t,
+      CXX_QDMI_get_device_state()->calibration_epoch.load(), prop, size, value,
+      size_ret)
   ADD_LIST_PROPERTY(QDMI_DEVICE_PROPERTY_COUPLINGMAP, CXX_QDMI_Site,
-                    DEVICE_COUPLING_MAP, prop, size, value, size_ret)
+                    description->coupling_map, prop, size, value, size_ret)
   return QDMI_ERROR_NOTSUPPORTED;
 } /// [DOXYGEN FUNCTION END]
 
@@ -317,9 +1202,10 @@ int CXX_QDMI_query_site_property_dev(CXX_QDMI_Site site,
       (value == nullptr && size_ret == nullptr)) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
-  ADD_SINGLE_VALUE_PROPERTY(QDMI_SITE_PROPERTY_TIME_T1, double, 1000.0, prop,
+  ++CXX_QDMI_get_device_state()->num_calibration_queries;
+  ADD_SINGLE_VALUE_PROPERTY(QDMI_SITE_PROPERTY_TIME_T1, double, site->t1, prop,
                             size, value, size_ret)
-  ADD_SINGLE_VALUE_PROPERTY(QDMI_SITE_PROPERTY_TIME_T2, double, 100000.0, prop,
+  ADD_SINGLE_VALUE_PROPERTY(QDMI_SITE_PROPERTY_TIME_T2, double, site->t2, prop,
                             size, value, size_ret)
   return QDMI_ERROR_NOTSUPPORTED;
 } /// [DOXYGEN FUNCTION END]
@@ -332,55 +1218,109 @@ int CXX_QDMI_query_operation_property_dev(
       (value == nullptr && size_ret == nullptr)) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
+  ++CXX_QDMI_get_device_state()->num_calibration_queries;
   // General properties
   ADD_STRING_PROPERTY(QDMI_OPERATION_PROPERTY_NAME, operation->name, prop, size,
                       value, size_ret)
-  if (strcmp(operation->name, "cx") == 0) {
+  const auto *description = CXX_QDMI_get_device_description();
+  const auto index =
+      static_cast<size_t>(operation - device_operations.data());
+  if (index == CX_INDEX) {
     if (sites != nullptr && num_sites != 2) {
       return QDMI_ERROR_INVALIDARGUMENT;
     }
-    ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_DURATION, double,
-                              OPERATION_DURATIONS.at(operation), prop, size,
-                              value, size_ret)
     if (sites == nullptr) {
+      ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_DURATION, double,
+                                description->durations[index], prop, size,
+                                value, size_ret)
       ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_QUBITSNUM, size_t, 2,
                                 prop, size, value, size_ret)
       return QDMI_ERROR_NOTSUPPORTED;
     }
-    const std::pair site_pair = {sites[0], sites[1]};
-    if (site_pair.first == site_pair.second) {
-      return QDMI_ERROR_INVALIDARGUMENT;
-    }
-    const auto it = OPERATION_FIDELITIES.find(operation);
-    if (it == OPERATION_FIDELITIES.end()) {
-      return QDMI_ERROR_INVALIDARGUMENT;
-    }
-    const auto fit = it->second.find(site_pair);
-    if (fit == it->second.end()) {
+    const auto *edge =
+        CXX_QDMI_find_cx_edge(*description, sites[0], sites[1]);
+    if (edge == nullptr) {
       return QDMI_ERROR_INVALIDARGUMENT;
     }
+    ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_DURATION, double,
+                              edge->duration, prop, size, value, size_ret)
     ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_FIDELITY, double,
-                              fit->second, prop, size, value, size_ret)
-  } else if (strcmp(operation->name, "rx") == 0 ||
-             strcmp(operation->name, "ry") == 0 ||
-             strcmp(operation->name, "rz") == 0) {
+                              edge->fidelity, prop, size, value, size_ret)
+  } else if (index < device_operations.size()) {
     if (sites != nullptr && num_sites != 1) {
       return QDMI_ERROR_INVALIDARGUMENT;
     }
-    ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_DURATION, double, 0.01,
-                              prop, size, value, size_ret)
+    ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_DURATION, double,
+                              description->durations[index], prop, size, value,
+                              size_ret)
     ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_QUBITSNUM, size_t, 1,
                               prop, size, value, size_ret)
-    ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_FIDELITY, double, 0.999,
-                              prop, size, value, size_ret)
+    ADD_SINGLE_VALUE_PROPERTY(QDMI_OPERATION_PROPERTY_FIDELITY, double,
+                              description->fidelities[index], prop, size,
+                              value, size_ret)
   }
   return QDMI_ERROR_NOTSUPPORTED;
 } /// [DOXYGEN FUNCTION END]
 
+int CXX_QDMI_query_device_properties_dev(
+    const size_t num_queries, QDMI_Device_Property_Query *queries) {
+  if (queries == nullptr && num_queries > 0) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  for (size_t i = 0; i < num_queries; ++i) {
+    auto &query = queries[i];
+    query.size_ret = 0;
+    query.status = CXX_QDMI_query_device_property_dev(
+        query.prop, query.size, query.value, &query.size_ret);
+  }
+  return QDMI_SUCCESS;
+} /// [DOXYGEN FUNCTION END]
+
+int CXX_QDMI_query_operation_properties_dev(
+    CXX_QDMI_Operation operation, const size_t num_tuples,
+    const size_t tuple_size, const CXX_QDMI_Site *sites,
+    const QDMI_Operation_Property prop, const size_t size, void *values,
+    int *status) {
+  if (prop >= QDMI_OPERATION_PROPERTY_MAX || operation == nullptr ||
+      (num_tuples > 0 && (tuple_size == 0 || sites == nullptr ||
+                          values == nullptr || status == nullptr))) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  auto *value = static_cast<char *>(values);
+  // The two-qubit fidelities and durations are the only properties that
+  // depend on the sites. They are looked up directly in the edge table.
+  if ((prop == QDMI_OPERATION_PROPERTY_FIDELITY ||
+       prop == QDMI_OPERATION_PROPERTY_DURATION) &&
+      operation == &device_operations[CX_INDEX] && tuple_size == 2 &&
+      size >= sizeof(double)) {
+    const auto *description = CXX_QDMI_get_device_description();
+    for (size_t i = 0; i < num_tuples; ++i) {
+      const auto *edge = CXX_QDMI_find_cx_edge(*description, sites[2 * i],
+                                               sites[(2 * i) + 1]);
+      if (edge == nullptr) {
+        status[i] = QDMI_ERROR_INVALIDARGUMENT;
+        continue;
+      }
+      std::memcpy(value + (i * size),
+                  prop == QDMI_OPERATION_PROPERTY_FIDELITY ? &edge->fidelity
+                                                           : &edge->duration,
+                  sizeof(double));
+      status[i] = QDMI_SUCCESS;
+    }
+    return QDMI_SUCCESS;
+  }
+  for (size_t i = 0; i < num_tuples; ++i) {
+    status[i] = CXX_QDMI_query_operation_property_dev(
+        operation, tuple_size, &sites[i * tuple_size], prop, size,
+        value + (i * size), nullptr);
+  }
+  return QDMI_SUCCESS;
+} /// [DOXYGEN FUNCTION END]
+
 int CXX_QDMI_control_create_job_dev(const QDMI_Program_Format format,
                                     const size_t size, const void *prog,
                                     CXX_QDMI_Job *job) {
-  if (CXX_QDMI_get_device_status() != QDMI_DEVICE_STATUS_IDLE) {
+  if (CXX_QDMI_get_device_status() == QDMI_DEVICE_STATUS_OFFLINE) {
     return QDMI_ERROR_FATAL;
   }
   if (size == 0 || prog == nullptr || job == nullptr) {
@@ -388,11 +1328,30 @@ int CXX_QDMI_control_create_job_dev(const QDMI_Program_Format format,
   }
   if (format != QDMI_PROGRAM_FORMAT_QASM2 &&
       format != QDMI_PROGRAM_FORMAT_QIRSTRING &&
-      format != QDMI_PROGRAM_FORMAT_QIRMODULE) {
+      format != QDMI_PROGRAM_FORMAT_QIRMODULE &&
+      format != CXX_QDMI_PROGRAM_FORMAT_CALIBRATION) {
     return QDMI_ERROR_NOTSUPPORTED;
   }
+  CXX_QDMI_Circuit circuit;
+  if (format == QDMI_PROGRAM_FORMAT_QASM2) {
+    size_t num_qubits = 0;
+    CXX_QDMI_query_device_property_dev(QDMI_DEVICE_PROPERTY_QUBITSNUM,
+                                       sizeof(size_t), &num_qubits, nullptr);
+    // the program ends at its null terminator or after size characters
+    const auto *text = static_cast<const char *>(prog);
+    const std::string program(text, std::find(text, text + size, '\0'));
+    if (const int ret = CXX_QDMI_parse_qasm2(
+            program, std::min(num_qubits, CXX_QDMI_MAX_SIMULATED_QUBITS),
+            circuit);
+        ret != QDMI_SUCCESS) {
+      return ret;
+    }
+  }
 
   *job = new CXX_QDMI_Job_impl_d;
+  (*job)->simulate = format == QDMI_PROGRAM_FORMAT_QASM2;
+  (*job)->calibrate = format == CXX_QDMI_PROGRAM_FORMAT_CALIBRATION;
+  (*job)->circuit = std::move(circuit);
   // set job id to random number for demonstration purposes
   (*job)->id = CXX_QDMI_generate_job_id();
   (*job)->status = QDMI_JOB_STATUS_CREATED;
@@ -402,80 +1361,138 @@ int CXX_QDMI_control_create_job_dev(const QDMI_Program_Format format,
 int CXX_QDMI_control_set_parameter_dev(CXX_QDMI_Job job,
                                        const QDMI_Job_Parameter param,
                                        const size_t size, const void *value) {
-  if (job == nullptr || param >= QDMI_JOB_PARAMETER_MAX || size == 0 ||
-      job->status != QDMI_JOB_STATUS_CREATED) {
+  if (job == nullptr || param >= QDMI_JOB_PARAMETER_MAX || size == 0) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
+  {
+    const std::lock_guard lock(CXX_QDMI_get_device_state()->mutex);
+    if (job->status != QDMI_JOB_STATUS_CREATED) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+  }
   if (param == QDMI_JOB_PARAMETER_SHOTS_NUM) {
     job->num_shots = *static_cast<const size_t *>(value);
     return QDMI_SUCCESS;
   }
+  if (param == CXX_QDMI_JOB_PARAMETER_NUM_THREADS) {
+    if (size != sizeof(size_t)) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    job->num_threads = *static_cast<const size_t *>(value);
+    return QDMI_SUCCESS;
+  }
   return QDMI_ERROR_NOTSUPPORTED;
 } /// [DOXYGEN FUNCTION END]
 
 int CXX_QDMI_control_submit_job_dev(CXX_QDMI_Job job) {
-  if (job == nullptr || job->status != QDMI_JOB_STATUS_CREATED) {
+  if (job == nullptr) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
-  CXX_QDMI_set_device_status(QDMI_DEVICE_STATUS_BUSY);
-  job->status = QDMI_JOB_STATUS_SUBMITTED;
-  // here, the actual submission of the problem to the device would happen
-  // ...
-  // set job status to running for demonstration purposes
-  job->status = QDMI_JOB_STATUS_RUNNING;
-  // generate random result data
-  size_t num_qubits = 0;
-  CXX_QDMI_query_device_property_dev(QDMI_DEVICE_PROPERTY_QUBITSNUM,
-                                     sizeof(size_t), &num_qubits, nullptr);
-  job->results.clear();
-  job->results.reserve(job->num_shots);
-  for (size_t i = 0; i < job->num_shots; ++i) {
-    // generate random bitstring
-    std::string result(num_qubits, '0');
-    std::generate(result.begin(), result.end(),
-                  [&]() { return CXX_QDMI_generate_bit() ? '1' : '0'; });
-    job->results.emplace_back(std::move(result));
-  }
-  // Generate random complex numbers and calculate the norm
-  job->state_vec.clear();
-  job->state_vec.reserve(1U << num_qubits);
-  double norm = 0.0;
-  for (size_t i = 0; i < 1U << num_qubits; ++i) {
-    const auto &c = job->state_vec.emplace_back(CXX_QDMI_generate_real(),
-                                                CXX_QDMI_generate_real());
-    norm += std::norm(c);
-  }
-  // Normalize the vector
-  norm = std::sqrt(norm);
-  for (auto &c : job->state_vec) {
-    c /= norm;
+  auto *state = CXX_QDMI_get_device_state();
+  {
+    const std::lock_guard lock(state->mutex);
+    if (job->status != QDMI_JOB_STATUS_CREATED) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    // here, the actual submission of the problem to the device would happen
+    // ...
+    // for demonstration purposes, the job is executed by a worker thread
+    job->status = QDMI_JOB_STATUS_SUBMITTED;
+    state->queue.emplace_back(job);
+    if (!state->worker.joinable()) {
+      state->worker = std::thread(CXX_QDMI_run_worker);
+    }
+    ++state->num_active_jobs;
   }
+  state->cv.notify_all();
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
 int CXX_QDMI_control_cancel_dev(CXX_QDMI_Job job) {
+  if (job == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  auto *state = CXX_QDMI_get_device_state();
+  std::unique_lock lock(state->mutex);
   if (job->status == QDMI_JOB_STATUS_DONE) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
-
+  if (job->status == QDMI_JOB_STATUS_CANCELLED) {
+    return QDMI_SUCCESS;
+  }
+  // a running job finishes its execution, but its results are discarded
+  if (job->status == QDMI_JOB_STATUS_SUBMITTED) {
+    state->queue.erase(
+        std::find(state->queue.begin(), state->queue.end(), job));
+  }
+  if (job->status != QDMI_JOB_STATUS_CREATED) {
+    --state->num_active_jobs;
+  }
   job->status = QDMI_JOB_STATUS_CANCELLED;
-  CXX_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
+  const auto callback = job->callback;
+  auto *user_data = job->user_data;
+  lock.unlock();
+  state->cv.notify_all();
+  if (callback != nullptr) {
+    callback(job, QDMI_JOB_STATUS_CANCELLED, user_data);
+  }
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
 int CXX_QDMI_control_check_dev(CXX_QDMI_Job job, QDMI_Job_Status *status) {
-  // randomly decide whether job is done or not
-  if (job->status == QDMI_JOB_STATUS_RUNNING && CXX_QDMI_generate_bit()) {
-    CXX_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
-    job->status = QDMI_JOB_STATUS_DONE;
+  if (job == nullptr || status == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
   }
+  auto *state = CXX_QDMI_get_device_state();
+  const std::lock_guard lock(state->mutex);
   *status = job->status;
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
 int CXX_QDMI_control_wait_dev(CXX_QDMI_Job job) {
-  job->status = QDMI_JOB_STATUS_DONE;
-  CXX_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
+  if (job == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  auto *state = CXX_QDMI_get_device_state();
+  std::unique_lock lock(state->mutex);
+  if (job->status == QDMI_JOB_STATUS_CREATED) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  state->cv.wait(lock, [job] {
+    return job->status == QDMI_JOB_STATUS_DONE ||
+           job->status == QDMI_JOB_STATUS_CANCELLED;
+  });
+  return QDMI_SUCCESS;
+} /// [DOXYGEN FUNCTION END]
+
+int CXX_QDMI_control_wait_for_dev(CXX_QDMI_Job job, const size_t timeout) {
+  if (job == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  auto *state = CXX_QDMI_get_device_state();
+  std::unique_lock lock(state->mutex);
+  if (job->status == QDMI_JOB_STATUS_CREATED) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  const auto finished = [job] {
+    return job->status == QDMI_JOB_STATUS_DONE ||
+           job->status == QDMI_JOB_STATUS_CANCELLED;
+  };
+  using Clock = std::chrono::steady_clock;
+  const auto now = Clock::now();
+  // timeouts beyond the range of the clock wait without a limit
+  const auto max_timeout =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          Clock::time_point::max() - now)
+          .count();
+  if (timeout >= static_cast<uint64_t>(max_timeout)) {
+    state->cv.wait(lock, finished);
+    return QDMI_SUCCESS;
+  }
+  if (!state->cv.wait_until(lock, now + std::chrono::milliseconds(timeout),
+                            finished)) {
+    return QDMI_ERROR_TIMEOUT;
+  }
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
@@ -483,26 +1500,35 @@ int CXX_QDMI_control_get_data_dev(CXX_QDMI_Job job,
                                   const QDMI_Job_Result result,
                                   const size_t size, void *data,
                                   size_t *size_ret) {
-  if (job->status != QDMI_JOB_STATUS_DONE) {
+  if (job == nullptr) {
     return QDMI_ERROR_INVALIDARGUMENT;
   }
+  {
+    // the results are not modified anymore once the job is done
+    const std::lock_guard lock(CXX_QDMI_get_device_state()->mutex);
+    if (job->status != QDMI_JOB_STATUS_DONE) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+  }
+  if (result == CXX_QDMI_JOB_RESULT_NUM_QUBITS) {
+    if (data != nullptr) {
+      if (size < sizeof(size_t)) {
+        return QDMI_ERROR_INVALIDARGUMENT;
+      }
+      *static_cast<size_t *>(data) = job->num_qubits;
+    }
+    if (size_ret != nullptr) {
+      *size_ret = sizeof(size_t);
+    }
+    return QDMI_SUCCESS;
+  }
   if (result == QDMI_JOB_RESULT_SHOTS) {
-    const size_t bitstring_size =
-        job->results.empty() ? 0 : job->results.front().length();
-    const size_t req_size = job->results.size() * (bitstring_size + 1);
+    const size_t req_size = job->num_shots * (job->num_qubits + 1);
     if (data != nullptr) {
       if (size < req_size) {
         return QDMI_ERROR_INVALIDARGUMENT;
       }
-      auto *data_ptr = static_cast<char *>(data);
-      for (auto it = job->results.begin(); it != job->results.end(); ++it) {
-        data_ptr = std::copy(it->begin(), it->end(), data_ptr);
-        if (std::next(it) != job->results.end()) {
-          *data_ptr++ = ','; // Add comma separator
-        } else {
-          *data_ptr++ = '\0'; // Add null terminator at the end
-        }
-      }
+      std::memcpy(data, CXX_QDMI_get_shots_ascii(job).data(), req_size);
     }
     if (size_ret != nullptr) {
       *size_ret = req_size;
@@ -511,47 +1537,29 @@ int CXX_QDMI_control_get_data_dev(CXX_QDMI_Job job,
   }
   if (result == QDMI_JOB_RESULT_HIST_KEYS ||
       result == QDMI_JOB_RESULT_HIST_VALUES) {
-    // Count unique elements
-    std::map<std::string, size_t> hist;
-    for (const auto &shot : job->results) {
-      hist[shot]++;
-    }
-    if (result == QDMI_JOB_RESULT_HIST_KEYS) {
-      const size_t bitstring_size =
-          job->results.empty() ? 0 : job->results.front().length();
-      const size_t req_size = hist.size() * (bitstring_size + 1);
-      if (size_ret != nullptr) {
-        *size_ret = req_size;
-      }
-      if (data != nullptr) {
-        if (size < req_size) {
-          return QDMI_ERROR_INVALIDARGUMENT;
-        }
-        char *data_ptr = static_cast<char *>(data);
-        for (const auto &[bitstring, count] : hist) {
-          std::copy(bitstring.begin(), bitstring.end(), data_ptr);
-          data_ptr += bitstring.length();
-          *data_ptr++ = ',';
-        }
-        *(data_ptr - 1) = '\0'; // Replace last comma with null terminator
-      }
-    } else {
-      const size_t req_size = hist.size() * sizeof(size_t);
-      if (size_ret != nullptr) {
-        *size_ret = req_size;
-      }
-      if (data != nullptr) {
-        if (size < req_size) {
-          return QDMI_ERROR_INVALIDARGUMENT;
-        }
-        auto *data_ptr = static_cast<size_t *>(data);
-        for (const auto &[_, count] : hist) {
-          *data_ptr++ = count;
-        }
+    // the histogram is computed on the first request and then reused
+    std::call_once(job->hist_once, CXX_QDMI_compute_histogram, job);
+    const void *hist_data = job->hist_keys.data();
+    size_t req_size = job->hist_keys.size();
+    if (result == QDMI_JOB_RESULT_HIST_VALUES) {
+      hist_data = job->hist_values.data();
+      req_size = job->hist_values.size() * sizeof(size_t);
+    }
+    if (size_ret != nullptr) {
+      *size_ret = req_size;
+    }
+    if (data != nullptr) {
+      if (size < req_size) {
+        return QDMI_ERROR_INVALIDARGUMENT;
       }
+      std::memcpy(data, hist_data, req_size);
     }
     return QDMI_SUCCESS;
   }
+  // the remaining results are derived from the state
+  if (job->state_vec.empty()) {
+    return QDMI_ERROR_NOTSUPPORTED;
+  }
   if (result == QDMI_JOB_RESULT_STATEVECTOR_DENSE) {
     const size_t req_size = job->state_vec.size() * 2 * sizeof(double);
     if (data != nullptr) {
@@ -576,8 +1584,7 @@ int CXX_QDMI_control_get_data_dev(CXX_QDMI_Job job,
         ++count;
       }
     }
-    const auto num_qubits =
-        static_cast<size_t>(std::log2(job->state_vec.size()));
+    const size_t num_qubits = job->num_qubits;
 
     if (result == QDMI_JOB_RESULT_STATEVECTOR_SPARSE_KEYS ||
         result == QDMI_JOB_RESULT_PROBABILITIES_SPARSE_KEYS) {
@@ -590,13 +1597,15 @@ int CXX_QDMI_control_get_data_dev(CXX_QDMI_Job job,
         for (size_t i = 0; i < job->state_vec.size(); ++i) {
           if (job->state_vec[i] != 0.0) {
             for (size_t j = 0; j < num_qubits; ++j) {
-              *data_ptr++ =
-                  ((i & (1 << (num_qubits - j - 1))) != 0U) ? '1' : '0';
+              const size_t q = num_qubits - j - 1;
+              *data_ptr++ = ((i >> q) & 1U) != 0U ? '1' : '0';
             }
             *data_ptr++ = ',';
           }
         }
-        *(data_ptr - 1) = '\0'; // Replace last comma with null terminator
+        if (data_ptr != data) {
+          *(data_ptr - 1) = '\0'; // Replace last comma with null terminator
+        }
       }
       if (size_ret != nullptr) {
         *size_ret = req_size;
@@ -629,7 +1638,9 @@ int CXX_QDMI_control_get_data_dev(CXX_QDMI_Job job,
         }
         auto *data_ptr = static_cast<double *>(data);
         for (const auto &c : job->state_vec) {
-          *data_ptr++ = std::norm(c);
+          if (c != 0.) {
+            *data_ptr++ = std::norm(c);
+          }
         }
       }
       if (size_ret != nullptr) {
@@ -657,14 +1668,92 @@ int CXX_QDMI_control_get_data_dev(CXX_QDMI_Job job,
   return QDMI_ERROR_NOTSUPPORTED;
 } /// [DOXYGEN FUNCTION END]
 
-void CXX_QDMI_control_free_job_dev(CXX_QDMI_Job job) { delete job; }
+int CXX_QDMI_control_set_callback_dev(CXX_QDMI_Job job,
+                                      CXX_QDMI_Job_Callback callback,
+                                      void *user_data) {
+  if (job == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  std::unique_lock lock(CXX_QDMI_get_device_state()->mutex);
+  job->callback = callback;
+  job->user_data = user_data;
+  const auto status = job->status;
+  lock.unlock();
+  if (callback != nullptr && (status == QDMI_JOB_STATUS_DONE ||
+                              status == QDMI_JOB_STATUS_CANCELLED)) {
+    callback(job, status, user_data);
+  }
+  return QDMI_SUCCESS;
+} /// [DOXYGEN FUNCTION END]
+
+void CXX_QDMI_control_free_job_dev(CXX_QDMI_Job job) {
+  if (job == nullptr) {
+    return;
+  }
+  auto *state = CXX_QDMI_get_device_state();
+  {
+    std::unique_lock lock(state->mutex);
+    if (job->status == QDMI_JOB_STATUS_SUBMITTED) {
+      state->queue.erase(
+          std::find(state->queue.begin(), state->queue.end(), job));
+      --state->num_active_jobs;
+    }
+    // wait until the worker thread has released the job
+    state->cv.wait(lock, [job] { return !job->executing; });
+  }
+  delete job;
+} /// [DOXYGEN FUNCTION END]
 
 int CXX_QDMI_control_initialize_dev() {
-  CXX_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
+  auto *state = CXX_QDMI_get_device_state();
+  const std::lock_guard lock(state->mutex);
+  // the same library may be opened several times by a driver
+  if (state->num_initialized == 0) {
+    if (const int ret = CXX_QDMI_load_device_description();
+        ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    CXX_QDMI_set_device_status(QDMI_DEVICE_STATUS_IDLE);
+  }
+  ++state->num_initialized;
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
 
 int CXX_QDMI_control_finalize_dev() {
+  auto *state = CXX_QDMI_get_device_state();
+  std::vector<CXX_QDMI_Job> cancelled;
+  {
+    const std::lock_guard lock(state->mutex);
+    if (state->num_initialized > 0 && --state->num_initialized > 0) {
+      return QDMI_SUCCESS;
+    }
+    state->stop = true;
+    // jobs that have not been started yet are cancelled
+    for (auto *job : state->queue) {
+      job->status = QDMI_JOB_STATUS_CANCELLED;
+      --state->num_active_jobs;
+      cancelled.emplace_back(job);
+    }
+    state->queue.clear();
+  }
+  state->cv.notify_all();
+  for (auto *job : cancelled) {
+    if (job->callback != nullptr) {
+      job->callback(job, QDMI_JOB_STATUS_CANCELLED, job->user_data);
+    }
+  }
+  if (state->worker.joinable()) {
+    state->worker.join();
+  }
+  {
+    const std::lock_guard lock(state->mutex);
+    state->stop = false;
+  }
   CXX_QDMI_set_device_status(QDMI_DEVICE_STATUS_OFFLINE);
   return QDMI_SUCCESS;
 } /// [DOXYGEN FUNCTION END]
+
+CXX_QDMI_DEVICE_VTABLE_DEFINE_WITH(CXX_QDMI_query_device_properties_dev,
+                                   CXX_QDMI_query_operation_properties_dev,
+                                   CXX_QDMI_control_set_callback_dev,
+                                   CXX_QDMI_control_wait_for_dev);
@@ -0,0 +1,952 @@
+/*------------------------------------------------------------------------------
+Copyright 2024 Munich Quantum Software Stack Project
+
+Licensed under the Apache License, Version 2.0 with LLVM Exceptions (the
+"License"); you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+https://github.com/Munich-Quantum-Software-Stack/QDMI/blob/develop/LICENSE
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+License for the specific language governing permissions and limitations under
+the License.
+
+SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+------------------------------------------------------------------------------*/
+
+/** @file
+ * @brief The implementation of the state-vector simulator of the C++ example
+ * device.
+ */
+
+#include "simulator.hpp"
+
+#include "qdmi/common/enums.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <complex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+using Complex = std::complex<double>;
+using Matrix = std::array<Complex, 4>;
+using Matrix4 = std::array<Complex, 16>;
+
+constexpr double PI = 3.14159265358979323846;
+/// The minimum number of amplitude pairs or quadruples a thread processes per
+/// gate.
+constexpr std::size_t PARALLEL_MIN_BLOCK = 4096;
+/// The number of amplitude quadruples a gate on two qubits processes at once.
+constexpr std::size_t PAIR_TILE = 8;
+/// The minimum number of gates fused into a gate on two qubits.
+constexpr std::size_t PAIR_MIN_PARTS = 3;
+
+/// A vector of real numbers aligned to cache lines.
+using Aligned_doubles =
+    std::vector<double, CXX_QDMI_Aligned_Allocator<double>>;
+
+/**
+ * @brief The matrix of the general single-qubit gate `U(theta, phi, lambda)`.
+ */
+Matrix U_matrix(const double theta, const double phi, const double lambda) {
+  const double c = std::cos(theta / 2);
+  const double s = std::sin(theta / 2);
+  return {Complex(c, 0), -std::polar(s, lambda), std::polar(s, phi),
+          std::polar(c, phi + lambda)};
+}
+
+/// A quantum register declared by the program.
+struct Register {
+  std::string name;
+  std::size_t offset;
+  std::size_t size;
+};
+
+/**
+ * @brief A recursive-descent parser for the statements of an OpenQASM 2
+ * program.
+ */
+class Qasm2Parser {
+public:
+  Qasm2Parser(const std::size_t max_num_qubits, CXX_QDMI_Circuit &result)
+      : max_qubits(max_num_qubits), circuit(result) {}
+
+  /**
+   * @brief Parse a single statement without its terminating semicolon.
+   * @param statement the statement.
+   * @return a QDMI status code.
+   */
+  int parse_statement(const std::string &statement) {
+    text = statement;
+    pos = 0;
+    const auto keyword = identifier();
+    if (keyword.empty()) {
+      skip_space();
+      return pos == text.size() ? QDMI_SUCCESS : QDMI_ERROR_INVALIDARGUMENT;
+    }
+    if (keyword == "OPENQASM" || keyword == "include" || keyword == "creg" ||
+        keyword == "measure" || keyword == "barrier") {
+      return QDMI_SUCCESS;
+    }
+    if (keyword == "qreg") {
+      return parse_qreg();
+    }
+    if (keyword == "gate" || keyword == "opaque" || keyword == "if" ||
+        keyword == "reset") {
+      return QDMI_ERROR_NOTSUPPORTED;
+    }
+    return parse_gate(keyword);
+  }
+
+private:
+  std::size_t max_qubits;
+  CXX_QDMI_Circuit &circuit;
+  std::vector<Register> registers;
+  std::string text;
+  std::size_t pos = 0;
+  bool error = false;
+
+  void skip_space() {
+    while (pos < text.size() &&
+           std::isspace(static_cast<unsigned char>(text[pos])) != 0) {
+      ++pos;
+    }
+  }
+
+  bool accept(const char c) {
+    skip_space();
+    if (pos < text.size() && text[pos] == c) {
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+
+  std::string identifier() {
+    skip_space();
+    const auto start = pos;
+    while (pos < text.size() &&
+           (std::isalnum(static_cast<unsigned char>(text[pos])) != 0 ||
+            text[pos] == '_')) {
+      ++pos;
+    }
+    return text.substr(start, pos - start);
+  }
+
+  bool integer(std::size_t &value) {
+    skip_space();
+    const char *begin = text.c_str() + pos;
+    char *end = nullptr;
+    value = std::strtoull(begin, &end, 10);
+    if (end == begin) {
+      return false;
+    }
+    pos += static_cast<std::size_t>(end - begin);
+    return true;
+  }
+
+  // expression := term (('+' | '-') term)*
+  double expression() {
+    double value = term();
+    while (true) {
+      if (accept('+')) {
+        value += term();
+      } else if (accept('-')) {
+        value -= term();
+      } else {
+        return value;
+      }
+    }
+  }
+
+  // term := power (('*' | '/') power)*
+  double term() {
+    double value = power();
+    while (true) {
+      if (accept('*')) {
+        value *= power();
+      } else if (accept('/')) {
+        value /= power();
+      } else {
+        return value;
+      }
+    }
+  }
+
+  // power := factor ('^' power)?
+  double power() {
+    const double base = factor();
+    return accept('^') ? std::pow(base, power()) : base;
+  }
+
+  // factor := ('-' | '+') factor | number | 'pi' | function '(' expression ')'
+  //         | '(' expression ')'
+  double factor() {
+    if (accept('-')) {
+      return -factor();
+    }
+    if (accept('+')) {
+      return factor();
+    }
+    if (accept('(')) {
+      const double value = expression();
+      error |= !accept(')');
+      return value;
+    }
+    skip_space();
+    if (pos < text.size() &&
+        (std::isdigit(static_cast<unsigned char>(text[pos])) != 0 ||
+         text[pos] == '.')) {
+      const char *begin = text.c_str() + pos;
+      char *end = nullptr;
+      const double value = std::strtod(begin, &end);
+      pos += static_cast<std::size_t>(end - begin);
+      return value;
+    }
+    const auto name = identifier();
+    if (name == "pi") {
+      return PI;
+    }
+    double (*function)(double) = nullptr;
+    if (name == "sin") {
+      function = [](const double x) { return std::sin(x); };
+    } else if (name == "cos") {
+      function = [](const double x) { return std::cos(x); };
+    } else if (name == "tan") {
+      function = [](const double x) { return std::tan(x); };
+    } else if (name == "exp") {
+      function = [](const double x) { return std::exp(x); };
+    } else if (name == "ln") {
+      function = [](const double x) { return std::log(x); };
+    } else if (name == "sqrt") {
+      function = [](const double x) { return std::sqrt(x); };
+    }
+    if (function == nullptr || !accept('(')) {
+      error = true;
+      return 0;
+    }
+    const double value = expression();
+    error |= !accept(')');
+    return function(value);
+  }
+
+  int parse_qreg() {
+    const auto name = identifier();
+    std::size_t size = 0;
+    if (name.empty() || !accept('[') || !integer(size) || !accept(']')) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    skip_space();
+    if (pos != text.size()) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    if (size > max_qubits - circuit.num_qubits) {
+      return QDMI_ERROR_NOTSUPPORTED;
+    }
+    registers.emplace_back(Register{name, circuit.num_qubits, size});
+    circuit.num_qubits += size;
+    return QDMI_SUCCESS;
+  }
+
+  /**
+   * @brief Parse an operand, which is either a single qubit or a register.
+   * @param qubits the qubits the operand refers to.
+   * @return a QDMI status code.
+   */
+  int operand(std::vector<std::size_t> &qubits) {
+    const auto name = identifier();
+    const auto it =
+        std::find_if(registers.begin(), registers.end(),
+                     [&name](const Register &r) { return r.name == name; });
+    if (it == registers.end()) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    qubits.clear();
+    if (accept('[')) {
+      std::size_t index = 0;
+      if (!integer(index) || !accept(']') || index >= it->size) {
+        return QDMI_ERROR_INVALIDARGUMENT;
+      }
+      qubits.emplace_back(it->offset + index);
+    } else {
+      for (std::size_t i = 0; i < it->size; ++i) {
+        qubits.emplace_back(it->offset + i);
+      }
+    }
+    return QDMI_SUCCESS;
+  }
+
+  void single(const Matrix &matrix, const std::size_t target) {
+    circuit.gates.emplace_back(
+        CXX_QDMI_Gate{matrix, target, CXX_QDMI_Gate::NO_CONTROL});
+  }
+
+  void cx(const std::size_t control, const std::size_t target) {
+    circuit.gates.emplace_back(CXX_QDMI_Gate{{}, target, control});
+  }
+
+  int parse_gate(const std::string &name) {
+    std::vector<double> params;
+    if (accept('(')) {
+      if (!accept(')')) {
+        do {
+          params.emplace_back(expression());
+        } while (accept(','));
+        if (!accept(')')) {
+          return QDMI_ERROR_INVALIDARGUMENT;
+        }
+      }
+    }
+    if (error) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    std::vector<std::vector<std::size_t>> operands;
+    do {
+      auto &qubits = operands.emplace_back();
+      if (const int ret = operand(qubits); ret != QDMI_SUCCESS) {
+        return ret;
+      }
+    } while (accept(','));
+    skip_space();
+    if (pos != text.size()) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    // registers as operands apply the gate to each of their qubits
+    std::size_t width = 1;
+    for (const auto &qubits : operands) {
+      if (qubits.size() != 1) {
+        if (width != 1 && width != qubits.size()) {
+          return QDMI_ERROR_INVALIDARGUMENT;
+        }
+        width = qubits.size();
+      }
+    }
+    std::vector<std::size_t> qubits(operands.size());
+    for (std::size_t i = 0; i < width; ++i) {
+      for (std::size_t j = 0; j < operands.size(); ++j) {
+        qubits[j] = operands[j].size() == 1 ? operands[j][0] : operands[j][i];
+      }
+      if (const int ret = apply(name, params, qubits); ret != QDMI_SUCCESS) {
+        return ret;
+      }
+    }
+    return QDMI_SUCCESS;
+  }
+
+  /**
+   * @brief Append a gate of `qelib1.inc` to the circuit.
+   * @param name the name of the gate.
+   * @param p the parameters of the gate.
+   * @param q the qubits of the gate.
+   * @return a QDMI status code.
+   */
+  int apply(const std::string &name, const std::vector<double> &p,
+            const std::vector<std::size_t> &q) {
+    const Complex i(0, 1);
+    const double r = 1 / std::sqrt(2.0);
+    // the number of parameters and qubits of every supported gate
+    const auto expect = [&p, &q](const std::size_t num_params,
+                                 const std::size_t num_qubits) {
+      return p.size() == num_params && q.size() == num_qubits;
+    };
+    if (q.size() == 2 && q[0] == q[1]) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    if ((name == "cx" || name == "CX") && expect(0, 2)) {
+      cx(q[0], q[1]);
+    } else if (name == "cz" && expect(0, 2)) {
+      const Matrix h = {r, r, r, -r};
+      single(h, q[1]);
+      cx(q[0], q[1]);
+      single(h, q[1]);
+    } else if (name == "swap" && expect(0, 2)) {
+      cx(q[0], q[1]);
+      cx(q[1], q[0]);
+      cx(q[0], q[1]);
+    } else if (name == "rx" && expect(1, 1)) {
+      const double c = std::cos(p[0] / 2);
+      const double s = std::sin(p[0] / 2);
+      single({c, -i * s, -i * s, c}, q[0]);
+    } else if (name == "ry" && expect(1, 1)) {
+      const double c = std::cos(p[0] / 2);
+      const double s = std::sin(p[0] / 2);
+      single({c, -s, s, c}, q[0]);
+    } else if (name == "rz" && expect(1, 1)) {
+      single({std::polar(1.0, -p[0] / 2), 0, 0, std::polar(1.0, p[0] / 2)},
+             q[0]);
+    } else if ((name == "U" || name == "u" || name == "u3") && expect(3, 1)) {
+      single(U_matrix(p[0], p[1], p[2]), q[0]);
+    } else if (name == "u2" && expect(2, 1)) {
+      single(U_matrix(PI / 2, p[0], p[1]), q[0]);
+    } else if ((name == "u1" || name == "p") && expect(1, 1)) {
+      single({1, 0, 0, std::polar(1.0, p[0])}, q[0]);
+    } else if (name == "id" && expect(0, 1)) {
+      // nothing to do
+    } else if (name == "x" && expect(0, 1)) {
+      single({0, 1, 1, 0}, q[0]);
+    } else if (name == "y" && expect(0, 1)) {
+      single({0, -i, i, 0}, q[0]);
+    } else if (name == "z" && expect(0, 1)) {
+      single({1, 0, 0, -1}, q[0]);
+    } else if (name == "h" && expect(0, 1)) {
+      single({r, r, r, -r}, q[0]);
+    } else if (name == "s" && expect(0, 1)) {
+      single({1, 0, 0, i}, q[0]);
+    } else if (name == "sdg" && expect(0, 1)) {
+      single({1, 0, 0, -i}, q[0]);
+    } else if (name == "t" && expect(0, 1)) {
+      single({1, 0, 0, std::polar(1.0, PI / 4)}, q[0]);
+    } else if (name == "tdg" && expect(0, 1)) {
+      single({1, 0, 0, std::polar(1.0, -PI / 4)}, q[0]);
+    } else if (name == "sx" && expect(0, 1)) {
+      single({(1. + i) / 2., (1. - i) / 2., (1. - i) / 2., (1. + i) / 2.},
+             q[0]);
+    } else {
+      return QDMI_ERROR_NOTSUPPORTED;
+    }
+    return QDMI_SUCCESS;
+  }
+};
+
+/**
+ * @brief A pool of threads that execute the tasks of a parallel loop.
+ * @details The calling thread takes part in every loop, so a pool for n
+ * threads spawns n - 1 workers. The workers are kept for the lifetime of the
+ * pool, i.e., the simulation of one circuit, such that every gate only pays
+ * for waking them up instead of creating threads.
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(const std::size_t num_threads) {
+    for (std::size_t i = 1; i < num_threads; ++i) {
+      workers.emplace_back([this] { work(); });
+    }
+  }
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool() {
+    {
+      const std::lock_guard lock(mutex);
+      stop = true;
+    }
+    start_cv.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  /// The number of threads taking part in a loop.
+  [[nodiscard]] std::size_t size() const { return workers.size() + 1; }
+
+  /**
+   * @brief Call @p task for every index below @p num_tasks and wait until all
+   * calls have returned.
+   */
+  void parallel_for(const std::size_t num_tasks,
+                    const std::function<void(std::size_t)> &task) {
+    {
+      const std::lock_guard lock(mutex);
+      current_task = &task;
+      current_num_tasks = num_tasks;
+      next_task = 0;
+      num_busy = workers.size();
+      ++generation;
+    }
+    start_cv.notify_all();
+    run_tasks(task, num_tasks);
+    std::unique_lock lock(mutex);
+    done_cv.wait(lock, [this] { return num_busy == 0; });
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  /// Notified when a loop starts or the pool is destroyed.
+  std::condition_variable start_cv;
+  /// Notified when the last worker has finished its part of a loop.
+  std::condition_variable done_cv;
+  const std::function<void(std::size_t)> *current_task = nullptr;
+  std::size_t current_num_tasks = 0;
+  /// The index of the next task to be claimed by any thread.
+  std::atomic<std::size_t> next_task{0};
+  /// The number of workers that have not finished the current loop.
+  std::size_t num_busy = 0;
+  /// Incremented for every loop, so that workers recognize new loops.
+  std::size_t generation = 0;
+  bool stop = false;
+
+  void run_tasks(const std::function<void(std::size_t)> &task,
+                 const std::size_t num_tasks) {
+    for (auto i = next_task.fetch_add(1); i < num_tasks;
+         i = next_task.fetch_add(1)) {
+      task(i);
+    }
+  }
+
+  void work() {
+    std::size_t seen = 0;
+    std::unique_lock lock(mutex);
+    while (true) {
+      start_cv.wait(lock, [this, seen] { return stop || generation != seen; });
+      if (stop) {
+        return;
+      }
+      seen = generation;
+      const auto *task = current_task;
+      const auto num_tasks = current_num_tasks;
+      lock.unlock();
+      run_tasks(*task, num_tasks);
+      lock.lock();
+      if (--num_busy == 0) {
+        done_cv.notify_one();
+      }
+    }
+  }
+};
+
+/**
+ * @brief Apply a single-qubit gate to a range of amplitude pairs of a state
+ * stored as separate real and imaginary parts.
+ * @details The pairs of amplitudes differing only in the target qubit are
+ * numbered consecutively, and the pairs in [@p begin, @p end) are multiplied
+ * by the matrix of the gate. The inner loop runs over consecutive amplitudes,
+ * which the compiler vectorizes for all but the lowest qubits.
+ */
+void Apply_single(double *re, double *im, const std::size_t begin,
+                  const std::size_t end, const CXX_QDMI_Gate &gate) {
+  const std::size_t stride = std::size_t{1} << gate.target;
+  const double m00r = gate.matrix[0].real();
+  const double m00i = gate.matrix[0].imag();
+  const double m01r = gate.matrix[1].real();
+  const double m01i = gate.matrix[1].imag();
+  const double m10r = gate.matrix[2].real();
+  const double m10i = gate.matrix[2].imag();
+  const double m11r = gate.matrix[3].real();
+  const double m11i = gate.matrix[3].imag();
+  for (std::size_t pair = begin; pair < end;) {
+    // the pairs up to the next block of 2 * stride amplitudes are contiguous
+    const std::size_t offset = pair & (stride - 1);
+    const std::size_t length = std::min(stride - offset, end - pair);
+    const std::size_t base = ((pair - offset) << 1U) + offset;
+    double *re0 = re + base;
+    double *im0 = im + base;
+    double *re1 = re0 + stride;
+    double *im1 = im0 + stride;
+    for (std::size_t k = 0; k < length; ++k) {
+      const double a0r = re0[k];
+      const double a0i = im0[k];
+      const double a1r = re1[k];
+      const double a1i = im1[k];
+      re0[k] = (m00r * a0r) - (m00i * a0i) + (m01r * a1r) - (m01i * a1i);
+      im0[k] = (m00r * a0i) + (m00i * a0r) + (m01r * a1i) + (m01i * a1r);
+      re1[k] = (m10r * a0r) - (m10i * a0i) + (m11r * a1r) - (m11i * a1i);
+      im1[k] = (m10r * a0i) + (m10i * a0r) + (m11r * a1i) + (m11i * a1r);
+    }
+    pair += length;
+  }
+}
+
+/**
+ * @brief Apply a CX gate to a range of amplitude pairs of a state stored as
+ * separate real and imaginary parts.
+ * @details The pairs are numbered as in @ref Apply_single. The amplitudes of
+ * the pairs in [@p begin, @p end) whose control qubit is set are swapped.
+ */
+void Apply_cx(double *re, double *im, const std::size_t begin,
+              const std::size_t end, const CXX_QDMI_Gate &gate) {
+  const std::size_t stride = std::size_t{1} << gate.target;
+  const std::size_t control = std::size_t{1} << gate.control;
+  for (std::size_t pair = begin; pair < end;) {
+    const std::size_t offset = pair & (stride - 1);
+    const std::size_t length = std::min(stride - offset, end - pair);
+    const std::size_t base = ((pair - offset) << 1U) + offset;
+    for (std::size_t k = 0; k < length; ++k) {
+      const std::size_t i0 = base + k;
+      if ((i0 & control) != 0) {
+        std::swap(re[i0], re[i0 + stride]);
+        std::swap(im[i0], im[i0 + stride]);
+      }
+    }
+    pair += length;
+  }
+}
+
+/**
+ * @brief A gate of a circuit after fusion.
+ * @details Single-qubit gates and CX gates are applied by their own kernels.
+ * Gates fused into a gate on two qubits are combined into one 4x4 matrix,
+ * which is applied by a more expensive kernel.
+ */
+struct Fused_gate {
+  enum KIND : uint8_t { SINGLE, CX, PAIR };
+  KIND kind = SINGLE;
+  /// The gate of kind SINGLE or CX. The matrix of a SINGLE gate is the
+  /// product of all fused gates.
+  CXX_QDMI_Gate gate;
+  /// The lower qubit of a PAIR gate.
+  std::size_t low = 0;
+  /// The higher qubit of a PAIR gate.
+  std::size_t high = 0;
+  /// The matrix of a PAIR gate in row-major order, where basis state k has
+  /// the value k / 2 on the higher and k % 2 on the lower qubit.
+  Matrix4 matrix{};
+  /// The SINGLE and CX gates fused into a PAIR gate.
+  std::vector<Fused_gate> parts;
+  /// Whether the gate has been moved into a later gate.
+  bool removed = false;
+};
+
+/// A fused gate of kind SINGLE or CX consisting of one gate.
+Fused_gate Make_fused(const Fused_gate::KIND kind, const CXX_QDMI_Gate &gate) {
+  Fused_gate fused;
+  fused.kind = kind;
+  fused.gate = gate;
+  return fused;
+}
+
+/// The product @p a * @p b of two 2x2 matrices.
+Matrix Multiply(const Matrix &a, const Matrix &b) {
+  return {(a[0] * b[0]) + (a[1] * b[2]), (a[0] * b[1]) + (a[1] * b[3]),
+          (a[2] * b[0]) + (a[3] * b[2]), (a[2] * b[1]) + (a[3] * b[3])};
+}
+
+/// The product @p a * @p b of two 4x4 matrices.
+Matrix4 Multiply(const Matrix4 &a, const Matrix4 &b) {
+  Matrix4 product{};
+  for (std::size_t row = 0; row < 4; ++row) {
+    for (std::size_t k = 0; k < 4; ++k) {
+      for (std::size_t col = 0; col < 4; ++col) {
+        product[(4 * row) + col] += a[(4 * row) + k] * b[(4 * k) + col];
+      }
+    }
+  }
+  return product;
+}
+
+/**
+ * @brief The 4x4 matrix of a SINGLE or CX gate acting on the qubits of a PAIR
+ * gate.
+ */
+Matrix4 Embed(const Fused_gate &part, const Fused_gate &pair) {
+  const std::size_t target_bit = part.gate.target == pair.high ? 2 : 1;
+  Matrix4 embedded{};
+  for (std::size_t col = 0; col < 4; ++col) {
+    if (part.kind == Fused_gate::CX) {
+      // the target is flipped if the control is set
+      const bool control = (col & (3 - target_bit)) != 0;
+      embedded[(4 * (control ? col ^ target_bit : col)) + col] = 1;
+      continue;
+    }
+    // the matrix acts on the target, the other qubit keeps its value
+    const std::size_t c = (col & target_bit) != 0 ? 1 : 0;
+    for (const std::size_t r : {std::size_t{0}, std::size_t{1}}) {
+      const std::size_t row = (col & ~target_bit) | (r * target_bit);
+      embedded[(4 * row) + col] = part.gate.matrix[(2 * r) + c];
+    }
+  }
+  return embedded;
+}
+
+/// Append a SINGLE or CX gate to a PAIR gate.
+void Absorb(Fused_gate &pair, const Fused_gate &part) {
+  pair.matrix = Multiply(Embed(part, pair), pair.matrix);
+  auto &parts = pair.parts;
+  if (part.kind == Fused_gate::SINGLE && !parts.empty() &&
+      parts.back().kind == Fused_gate::SINGLE &&
+      parts.back().gate.target == part.gate.target) {
+    parts.back().gate.matrix =
+        Multiply(part.gate.matrix, parts.back().gate.matrix);
+  } else {
+    parts.emplace_back(part);
+  }
+}
+
+/**
+ * @brief Fuse the gates of a circuit.
+ * @details Every gate is merged into the last fused gate acting on its qubits
+ * if that gate acts on no other qubits. This is valid because all gates in
+ * between act on other qubits and, hence, commute with the merged gate.
+ * Single-qubit gates that are followed by a gate on two qubits are moved
+ * into the latter. Hence, every gate on two qubits absorbs the single-qubit
+ * gates on its qubits before and after it. Since the kernel of PAIR gates
+ * costs about two sweeps of the cheaper kernels, PAIR gates of fewer than
+ * @ref PAIR_MIN_PARTS parts are split into their parts again.
+ */
+std::vector<Fused_gate> Fuse(const CXX_QDMI_Circuit &circuit,
+                             const std::size_t num_qubits) {
+  constexpr auto none = std::numeric_limits<std::size_t>::max();
+  std::vector<Fused_gate> fused;
+  // the index of the last fused gate acting on every qubit
+  std::vector<std::size_t> last(num_qubits, none);
+  for (const auto &gate : circuit.gates) {
+    if (gate.control == CXX_QDMI_Gate::NO_CONTROL) {
+      const std::size_t j = last[gate.target];
+      if (j == none) {
+        last[gate.target] = fused.size();
+        fused.emplace_back(Make_fused(Fused_gate::SINGLE, gate));
+      } else if (fused[j].kind == Fused_gate::SINGLE) {
+        fused[j].gate.matrix = Multiply(gate.matrix, fused[j].gate.matrix);
+      } else {
+        Absorb(fused[j], Make_fused(Fused_gate::SINGLE, gate));
+      }
+      continue;
+    }
+    const std::size_t j = last[gate.control];
+    if (j != none && j == last[gate.target]) {
+      // the last gate on both qubits acts on the same pair
+      Absorb(fused[j], Make_fused(Fused_gate::CX, gate));
+      continue;
+    }
+    Fused_gate pair;
+    pair.kind = Fused_gate::PAIR;
+    pair.low = std::min(gate.control, gate.target);
+    pair.high = std::max(gate.control, gate.target);
+    pair.matrix = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    for (const auto qubit : {gate.control, gate.target}) {
+      const std::size_t k = last[qubit];
+      if (k != none && fused[k].kind == Fused_gate::SINGLE) {
+        Absorb(pair, fused[k]);
+        fused[k].removed = true;
+      }
+      last[qubit] = fused.size();
+    }
+    Absorb(pair, Make_fused(Fused_gate::CX, gate));
+    fused.emplace_back(std::move(pair));
+  }
+  std::vector<Fused_gate> result;
+  for (auto &g : fused) {
+    if (g.removed) {
+      continue;
+    }
+    if (g.kind == Fused_gate::PAIR && g.parts.size() < PAIR_MIN_PARTS) {
+      std::move(g.parts.begin(), g.parts.end(), std::back_inserter(result));
+    } else {
+      result.emplace_back(std::move(g));
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Apply a PAIR gate to a range of amplitude quadruples of a state
+ * stored as separate real and imaginary parts.
+ * @details The quadruples of amplitudes differing only in the two qubits of
+ * the gate are numbered consecutively, and the quadruples in [@p begin,
+ * @p end) are multiplied by the matrix of the gate.
+ */
+void Apply_pair(double *re, double *im, const std::size_t begin,
+                const std::size_t end, const Fused_gate &gate) {
+  const std::size_t low = std::size_t{1} << gate.low;
+  const std::size_t high = std::size_t{1} << gate.high;
+  std::array<double, 16> mr{};
+  std::array<double, 16> mi{};
+  for (std::size_t k = 0; k < 16; ++k) {
+    mr[k] = gate.matrix[k].real();
+    mi[k] = gate.matrix[k].imag();
+  }
+  for (std::size_t quad = begin; quad < end;) {
+    // the quadruples up to the next multiple of low are contiguous
+    const std::size_t offset = quad & (low - 1);
+    const std::size_t length = std::min(low - offset, end - quad);
+    // insert a zero bit at the positions of both qubits
+    std::size_t base = ((quad - offset) << 1U) + offset;
+    const std::size_t high_offset = base & (high - 1);
+    base = ((base - high_offset) << 1U) + high_offset;
+    const std::array<double *, 4> ptr_re = {re + base, re + base + low,
+                                            re + base + high,
+                                            re + base + low + high};
+    const std::array<double *, 4> ptr_im = {im + base, im + base + low,
+                                            im + base + high,
+                                            im + base + low + high};
+    // the amplitudes are processed in local tiles, which cannot alias each
+    // other and, hence, allow the compiler to vectorize the matrix product
+    std::size_t k = 0;
+    for (; k + PAIR_TILE <= length; k += PAIR_TILE) {
+      std::array<std::array<double, PAIR_TILE>, 4> ar;
+      std::array<std::array<double, PAIR_TILE>, 4> ai;
+      for (std::size_t c = 0; c < 4; ++c) {
+        std::copy_n(ptr_re[c] + k, PAIR_TILE, ar[c].begin());
+        std::copy_n(ptr_im[c] + k, PAIR_TILE, ai[c].begin());
+      }
+      for (std::size_t r = 0; r < 4; ++r) {
+        std::array<double, PAIR_TILE> sr;
+        std::array<double, PAIR_TILE> si;
+        const double *row_re = mr.data() + (4 * r);
+        const double *row_im = mi.data() + (4 * r);
+        for (std::size_t t = 0; t < PAIR_TILE; ++t) {
+          sr[t] = (row_re[0] * ar[0][t]) - (row_im[0] * ai[0][t]) +
+                  (row_re[1] * ar[1][t]) - (row_im[1] * ai[1][t]) +
+                  (row_re[2] * ar[2][t]) - (row_im[2] * ai[2][t]) +
+                  (row_re[3] * ar[3][t]) - (row_im[3] * ai[3][t]);
+          si[t] = (row_re[0] * ai[0][t]) + (row_im[0] * ar[0][t]) +
+                  (row_re[1] * ai[1][t]) + (row_im[1] * ar[1][t]) +
+                  (row_re[2] * ai[2][t]) + (row_im[2] * ar[2][t]) +
+                  (row_re[3] * ai[3][t]) + (row_im[3] * ar[3][t]);
+        }
+        std::copy_n(sr.begin(), PAIR_TILE, ptr_re[r] + k);
+        std::copy_n(si.begin(), PAIR_TILE, ptr_im[r] + k);
+      }
+    }
+    // the remaining amplitudes, e.g., if the lower qubit is one of the lowest
+    for (; k < length; ++k) {
+      std::array<double, 4> ar{};
+      std::array<double, 4> ai{};
+      for (std::size_t c = 0; c < 4; ++c) {
+        ar[c] = ptr_re[c][k];
+        ai[c] = ptr_im[c][k];
+      }
+      for (std::size_t r = 0; r < 4; ++r) {
+        double sr = 0.0;
+        double si = 0.0;
+        for (std::size_t c = 0; c < 4; ++c) {
+          sr += (mr[(4 * r) + c] * ar[c]) - (mi[(4 * r) + c] * ai[c]);
+          si += (mr[(4 * r) + c] * ai[c]) + (mi[(4 * r) + c] * ar[c]);
+        }
+        ptr_re[r][k] = sr;
+        ptr_im[r][k] = si;
+      }
+    }
+    quad += length;
+  }
+}
+
+/**
+ * @brief The number of independent units, i.e., pairs or quadruples of
+ * amplitudes, a gate is applied to.
+ */
+std::size_t Num_units(const Fused_gate &gate,
+                      const std::size_t num_amplitudes) {
+  return gate.kind == Fused_gate::PAIR ? num_amplitudes / 4
+                                       : num_amplitudes / 2;
+}
+
+/**
+ * @brief Apply a gate to the units in [@p begin, @p end).
+ */
+void Apply_gate(double *re, double *im, const std::size_t begin,
+                const std::size_t end, const Fused_gate &gate) {
+  switch (gate.kind) {
+  case Fused_gate::SINGLE:
+    Apply_single(re, im, begin, end, gate.gate);
+    break;
+  case Fused_gate::CX:
+    Apply_cx(re, im, begin, end, gate.gate);
+    break;
+  case Fused_gate::PAIR:
+    Apply_pair(re, im, begin, end, gate);
+    break;
+  }
+}
+} // namespace
+
+int CXX_QDMI_parse_qasm2(const std::string &program,
+                         const std::size_t max_qubits,
+                         CXX_QDMI_Circuit &circuit) {
+  circuit = CXX_QDMI_Circuit{};
+  Qasm2Parser parser(max_qubits, circuit);
+  std::string statement;
+  for (std::size_t i = 0; i < program.size(); ++i) {
+    if (program.compare(i, 2, "//") == 0) {
+      // skip the comment until the end of the line
+      i = program.find('\n', i);
+      if (i == std::string::npos) {
+        break;
+      }
+      continue;
+    }
+    if (program[i] == '\0') {
+      break;
+    }
+    if (program[i] != ';') {
+      statement += program[i];
+      continue;
+    }
+    if (const int ret = parser.parse_statement(statement);
+        ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    statement.clear();
+  }
+  // text after the last statement must be blank
+  return std::all_of(statement.begin(), statement.end(),
+                     [](const char c) {
+                       return std::isspace(static_cast<unsigned char>(c)) != 0;
+                     })
+             ? QDMI_SUCCESS
+             : QDMI_ERROR_INVALIDARGUMENT;
+}
+
+void CXX_QDMI_simulate(const CXX_QDMI_Circuit &circuit,
+                       const std::size_t num_qubits, std::size_t num_threads,
+                       CXX_QDMI_Amplitudes &state) {
+  const std::size_t num_amplitudes = std::size_t{1} << num_qubits;
+  const std::size_t num_pairs = num_amplitudes / 2;
+  // the kernels work on separate real and imaginary parts
+  Aligned_doubles re(num_amplitudes, 0.0);
+  Aligned_doubles im(num_amplitudes, 0.0);
+  re[0] = 1.0;
+  if (num_threads == 0) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  // every gate sweeps over the whole state, so fewer gates take less time
+  const auto gates = Fuse(circuit, num_qubits);
+  if (num_qubits < CXX_QDMI_PARALLEL_MIN_QUBITS || num_threads == 1) {
+    for (const auto &gate : gates) {
+      Apply_gate(re.data(), im.data(), 0, Num_units(gate, num_amplitudes),
+                 gate);
+    }
+  } else {
+    // every thread gets one contiguous block of units per gate
+    ThreadPool pool(std::min(num_threads, num_pairs / PARALLEL_MIN_BLOCK));
+    for (const auto &gate : gates) {
+      const std::size_t num_units = Num_units(gate, num_amplitudes);
+      const std::size_t block = num_units / pool.size();
+      pool.parallel_for(pool.size(), [&](const std::size_t i) {
+        const std::size_t end =
+            i + 1 == pool.size() ? num_units : (i + 1) * block;
+        Apply_gate(re.data(), im.data(), i * block, end, gate);
+      });
+    }
+  }
+  state.resize(num_amplitudes);
+  for (std::size_t i = 0; i < num_amplitudes; ++i) {
+    state[i] = Complex(re[i], im[i]);
+  }
+}
+
+void CXX_QDMI_sample(const CXX_QDMI_Amplitudes &state, uint64_t *samples,
+                     const std::size_t num_samples) {
+  std::vector<double> cumulative(state.size());
+  double total = 0.0;
+  for (std::size_t i = 0; i < state.size(); ++i) {
+    total += std::norm(state[i]);
+    cumulative[i] = total;
+  }
+  for (std::size_t i = 0; i < num_samples; ++i) {
+    // the upper 53 bits give a uniform number in [0, 1)
+    const double u =
+        static_cast<double>(samples[i] >> 11U) * 0x1.0p-53 * total;
+    const auto it =
+        std::upper_bound(cumulative.begin(), cumulative.end(), u);
+    samples[i] = static_cast<uint64_t>(
+        std::min<std::ptrdiff_t>(it - cumulative.begin(),
+                                 static_cast<std::ptrdiff_t>(state.size()) -
+                                     1));
+  }
+}
@@ -0,0 +1,153 @@
+/*------------------------------------------------------------------------------
+Copyright 2024 Munich Quantum Software Stack Project
+
+Licensed under the Apache License, Version 2.0 with LLVM Exceptions (the
+"License"); you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+https://github.com/Munich-Quantum-Software-Stack/QDMI/blob/develop/LICENSE
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+License for the specific language governing permissions and limitations under
+the License.
+
+SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+------------------------------------------------------------------------------*/
+
+/** @file
+ * @brief A state-vector simulator executing the jobs of the C++ example
+ * device.
+ * @details OpenQASM 2 programs are parsed into a circuit of single-qubit
+ * gates and CX gates, which is then applied to a state vector. The gates of
+ * `qelib1.inc` that act on at most two qubits are supported, next to the
+ * native `rx`, `ry`, `rz`, and `cx` gates of the device. Measurements and
+ * barriers are accepted, but all qubits are measured at the end of the
+ * circuit.
+ */
+
+#pragma once
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * @brief An allocator of memory aligned to cache lines.
+ * @details The alignment allows the gate kernels to use aligned vector loads
+ * and keeps the amplitudes of different threads on different cache lines.
+ */
+template <class T> struct CXX_QDMI_Aligned_Allocator {
+  using value_type = T;
+  /// The alignment of all allocations in bytes.
+  static constexpr std::size_t ALIGNMENT = 64;
+
+  CXX_QDMI_Aligned_Allocator() = default;
+  template <class U>
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  CXX_QDMI_Aligned_Allocator(const CXX_QDMI_Aligned_Allocator<U> & /*unused*/) {
+  }
+
+  T *allocate(const std::size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t{ALIGNMENT}));
+  }
+  void deallocate(T *p, const std::size_t /*unused*/) {
+    ::operator delete(p, std::align_val_t{ALIGNMENT});
+  }
+
+  template <class U>
+  bool operator==(const CXX_QDMI_Aligned_Allocator<U> & /*unused*/) const {
+    return true;
+  }
+  template <class U>
+  bool operator!=(const CXX_QDMI_Aligned_Allocator<U> & /*unused*/) const {
+    return false;
+  }
+};
+
+/// A vector of amplitudes aligned to cache lines.
+using CXX_QDMI_Amplitudes =
+    std::vector<std::complex<double>,
+                CXX_QDMI_Aligned_Allocator<std::complex<double>>>;
+
+/// A gate of a circuit, either a single-qubit gate or a CX gate.
+struct CXX_QDMI_Gate {
+  /// The value of @ref control for single-qubit gates.
+  static constexpr std::size_t NO_CONTROL =
+      std::numeric_limits<std::size_t>::max();
+  /// The matrix of a single-qubit gate in row-major order, unused for CX.
+  std::array<std::complex<double>, 4> matrix{};
+  /// The qubit the gate acts on.
+  std::size_t target = 0;
+  /// The control qubit of a CX gate, or @ref NO_CONTROL.
+  std::size_t control = NO_CONTROL;
+};
+
+/// A circuit as parsed from a program.
+struct CXX_QDMI_Circuit {
+  /// The number of qubits declared by the program.
+  std::size_t num_qubits = 0;
+  /// The gates in the order of their application.
+  std::vector<CXX_QDMI_Gate> gates;
+};
+
+/**
+ * @brief The maximum number of qubits of a simulated program.
+ * @details The state of a program of this size already occupies 64 GiB.
+ */
+constexpr std::size_t CXX_QDMI_MAX_SIMULATED_QUBITS = 32;
+
+/**
+ * @brief Parse an OpenQASM 2 program.
+ * @param program the program.
+ * @param max_qubits the maximum number of qubits the program may declare.
+ * @param circuit the circuit to fill.
+ * @return @ref QDMI_SUCCESS if the program was parsed,
+ * @ref QDMI_ERROR_INVALIDARGUMENT if it is malformed, or
+ * @ref QDMI_ERROR_NOTSUPPORTED if it uses unsupported statements or declares
+ * more than @p max_qubits qubits.
+ */
+int CXX_QDMI_parse_qasm2(const std::string &program, std::size_t max_qubits,
+                         CXX_QDMI_Circuit &circuit);
+
+/**
+ * @brief The number of qubits from which on gates are applied by multiple
+ * threads.
+ * @details Below, forking and joining the threads for every gate costs more
+ * than the gate itself.
+ */
+constexpr std::size_t CXX_QDMI_PARALLEL_MIN_QUBITS = 14;
+
+/**
+ * @brief Simulate a circuit starting from the all-zero state.
+ * @details Before the simulation, consecutive gates on the same qubit or pair
+ * of qubits are fused into a single gate. States of at least
+ * @ref CXX_QDMI_PARALLEL_MIN_QUBITS qubits are split into contiguous blocks of
+ * amplitudes, one per thread, for every gate.
+ * @param circuit the circuit to simulate.
+ * @param num_qubits the number of qubits of the state, at least the number of
+ * qubits of the circuit.
+ * @param num_threads the maximum number of threads to use, or 0 to use all
+ * hardware threads.
+ * @param state the final state, where bit q of an index is the value of qubit
+ * q.
+ */
+void CXX_QDMI_simulate(const CXX_QDMI_Circuit &circuit, std::size_t num_qubits,
+                       std::size_t num_threads, CXX_QDMI_Amplitudes &state);
+
+/**
+ * @brief Sample basis states from a state.
+ * @param state the state to sample from.
+ * @param samples the buffer holding one word of uniformly random bits per
+ * sample, each of which is replaced by the index of a sampled basis state.
+ * @param num_samples the number of samples.
+ */
+void CXX_QDMI_sample(const CXX_QDMI_Amplitudes &state, uint64_t *samples,
+                     std::size_t num_samples);
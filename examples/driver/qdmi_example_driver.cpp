@@ -23,175 +23,1938 @@ SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include "qdmi_example_driver.h"
 
+#include "qdmi_example_driver_probes.h"
+
 #include "qdmi/driver.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <cstdlib>
 #include <dlfcn.h>
 #include <exception>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
-/** @name Definition of the QDMI Device and Session data structures
- * @{
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+/** @name Definition of the QDMI Device and Session data structures
+ * @{
+ */
+
+namespace {
+/// The kind of entity a cached property belongs to.
+enum class PROPERTY_KIND : uint8_t { DEVICE, SITE, OPERATION };
+
+/// How long a property value stays valid in the property cache.
+enum class PROPERTY_LIFETIME : uint8_t {
+  /// The value never changes and is cached forever.
+  IMMUTABLE,
+  /// The value is cached until the calibration epoch of the device changes.
+  CALIBRATED,
+  /// The value may change at any time and is never cached.
+  UNCACHED,
+};
+
+/// The maximum number of sites of an operation property that is cached.
+constexpr size_t PROPERTY_KEY_MAX_SITES = 4;
+
+/**
+ * @brief The key of a property in the property cache.
+ * @details The key is stored inline, so that looking up a property does not
+ * allocate.
+ */
+struct Property_key {
+  PROPERTY_KIND kind;
+  int prop;
+  /// The site or operation the property belongs to, if any.
+  const void *handle;
+  /// The number of sites an operation property is queried for.
+  size_t num_sites;
+  /// The sites an operation property is queried for, unused entries are null.
+  std::array<const void *, PROPERTY_KEY_MAX_SITES> sites;
+
+  bool operator==(const Property_key &other) const {
+    return kind == other.kind && prop == other.prop &&
+           handle == other.handle && num_sites == other.num_sites &&
+           sites == other.sites;
+  }
+};
+
+/**
+ * @brief Hash function for @ref Property_key.
+ */
+struct Property_key_hash {
+  size_t operator()(const Property_key &key) const {
+    auto seed = std::hash<int>{}(static_cast<int>(key.kind));
+    const auto combine = [&seed](const size_t value) {
+      seed ^= value + 0x9e3779b9 + (seed << 6U) + (seed >> 2U);
+    };
+    combine(std::hash<int>{}(key.prop));
+    combine(std::hash<const void *>{}(key.handle));
+    for (size_t i = 0; i < key.num_sites; ++i) {
+      combine(std::hash<const void *>{}(key.sites[i]));
+    }
+    return seed;
+  }
+};
+
+/**
+ * @brief A cached property value.
+ */
+struct Property_entry {
+  std::vector<unsigned char> data;
+  PROPERTY_LIFETIME lifetime = PROPERTY_LIFETIME::IMMUTABLE;
+};
+
+/// How long the calibration epoch of a device is used before querying it again.
+constexpr std::chrono::milliseconds EPOCH_CHECK_INTERVAL{100};
+
+/**
+ * @brief A cache of the property values queried from a device.
+ */
+struct Property_cache {
+  std::mutex mutex;
+  /// The calibration epoch the calibrated entries belong to.
+  size_t epoch = 0;
+  std::unordered_map<Property_key, Property_entry, Property_key_hash> entries;
+  /// The calibration epoch last reported by the device.
+  std::atomic<size_t> device_epoch{0};
+  /// Whether the device reported a calibration epoch at the last check.
+  std::atomic<bool> has_epoch{false};
+  /// The time of the last check of the calibration epoch in nanoseconds of the
+  /// steady clock, or zero if it was never checked.
+  std::atomic<int64_t> epoch_checked{0};
+};
+
+/// The number of shards the call statistics of a device are split into.
+constexpr size_t NUM_STATS_SHARDS = 16;
+
+/**
+ * @brief The call statistics of a group of threads for one device.
+ * @details Every thread always records its calls in the same shard, so few
+ * threads share a shard and the relaxed atomic increments rarely contend.
+ * Other threads can read the counters at any time to merge the shards.
+ */
+struct alignas(64) Call_stats_shard {
+  /// The counters of a single entry point.
+  struct Counters {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> max_ns;
+    std::array<std::atomic<uint64_t>, QDMI_DRIVER_STATS_BUCKETS> buckets;
+  };
+  std::array<Counters, QDMI_DRIVER_CALL_MAX> calls;
+};
+
+/**
+ * @brief Generate a unique id for a device.
+ * @details Unlike the address of a device, the id is never reused, so it can
+ * safely identify a device in the trace even after the device was freed.
+ * @return a new id.
+ */
+uint64_t Next_device_id() {
+  static std::atomic<uint64_t> next_id{0};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get a copy of a library path that lives until the program exits.
+ * @details Trace events refer to the name of their device this way, since the
+ * device itself may be freed before the events are written.
+ * @param lib_name the path of a device library.
+ * @return a pointer to the copy, the same for equal paths.
+ */
+const std::string *Intern_lib_name(const std::string &lib_name) {
+  static std::mutex mutex;
+  static std::unordered_set<std::string> names;
+  const std::lock_guard lock(mutex);
+  return &*names.insert(lib_name).first;
+}
+
+/**
+ * @brief A thread waiting for one of several jobs to finish.
+ */
+struct Job_waiter {
+  std::mutex mutex;
+  std::condition_variable cv;
+  /// Set when one of the jobs has finished since the flag was last cleared.
+  bool signalled = false;
+
+  /// Wake up the waiting thread.
+  void signal() {
+    {
+      const std::lock_guard lock(mutex);
+      signalled = true;
+    }
+    cv.notify_all();
+  }
+};
+
+/**
+ * @brief The completion state of a job created through the driver.
+ * @details The record is updated by the completion callback registered with
+ * the device and outlives every invocation of that callback.
+ */
+struct Job_record {
+  std::mutex mutex;
+  /// The threads to wake up when the job has finished or was cancelled.
+  std::vector<std::shared_ptr<Job_waiter>> waiters;
+  /// Whether the job has finished or was cancelled.
+  bool done = false;
+  /// The final status of the job, valid once @ref done is set.
+  QDMI_Job_Status status = QDMI_JOB_STATUS_CREATED;
+  /// The descriptor handed out to the client, created on first request.
+  int read_fd = -1;
+  /// The descriptor written to signal the completion of the job.
+  int write_fd = -1;
+
+  Job_record() = default;
+  Job_record(const Job_record &) = delete;
+  Job_record &operator=(const Job_record &) = delete;
+  Job_record(Job_record &&) = delete;
+  Job_record &operator=(Job_record &&) = delete;
+
+  ~Job_record() {
+    if (write_fd >= 0 && write_fd != read_fd) {
+      close(write_fd);
+    }
+    if (read_fd >= 0) {
+      close(read_fd);
+    }
+  }
+};
+} // namespace
+
+/**
+ * @brief Definition of the QDMI Device.
+ * @details A device is owned by the device snapshots that list it, and thus by
+ * the sessions holding these snapshots, and by itself while jobs created on it
+ * have not been freed. The device library is closed once the last of them
+ * releases the device.
+ */
+struct QDMI_Device_impl_d
+    : public std::enable_shared_from_this<QDMI_Device_impl_d> {
+  void *lib_handle = nullptr;
+  QDMI_Device_Mode mode = QDMI_DEVICE_MODE_READWRITE;
+  /// The path of the device library.
+  std::string lib_name;
+  /// The path of the device library, as referred to by trace events.
+  const std::string *trace_name = nullptr;
+  /// The prefix of the symbols exported by the device library.
+  std::string prefix;
+  /// Ensures that the device library is loaded exactly once.
+  std::once_flag load_flag;
+  /// Whether the device library is loaded and the device is initialized.
+  std::atomic<bool> loaded{false};
+  /// The time it took to open and initialize the device library.
+  std::chrono::nanoseconds load_time{};
+  /// The property values already queried from the device.
+  Property_cache property_cache;
+  /// Protects @ref jobs.
+  std::mutex jobs_mutex;
+  /// The completion state of the jobs created on the device, if the device
+  /// supports completion callbacks.
+  std::unordered_map<QDMI_Job, std::shared_ptr<Job_record>> jobs;
+  /// Protects @ref num_jobs, @ref jobs_reference, @ref retired, and
+  /// @ref finalized.
+  std::mutex lifecycle_mutex;
+  /// The number of jobs created on the device and not freed yet.
+  size_t num_jobs = 0;
+  /// Keeps the device alive as long as @ref num_jobs is positive.
+  std::shared_ptr<QDMI_Device_impl_d> jobs_reference;
+  /// Whether the device was removed from the configuration.
+  bool retired = false;
+  /// Whether the device was finalized after it had been retired.
+  bool finalized = false;
+  /// The unique id of the device.
+  uint64_t id = Next_device_id();
+  /// The call statistics of the device, if they are recorded.
+  std::unique_ptr<std::array<Call_stats_shard, NUM_STATS_SHARDS>> stats;
+
+  /// The functions of the device, stored contiguously.
+  QDMI_Device_vtable table{};
+
+  // default constructor
+  QDMI_Device_impl_d() = default;
+
+  // delete copy constructor, copy assignment, move constructor, move assignment
+  QDMI_Device_impl_d(const QDMI_Device_impl_d &) = delete;
+  QDMI_Device_impl_d &operator=(const QDMI_Device_impl_d &) = delete;
+  QDMI_Device_impl_d(QDMI_Device_impl_d &&) = delete;
+  QDMI_Device_impl_d &operator=(QDMI_Device_impl_d &&) = delete;
+
+  // destructor
+  ~QDMI_Device_impl_d() {
+    // Check if QDMI_control_finalize is not NULL before calling it
+    if (table.control_finalize != nullptr && !finalized) {
+      table.control_finalize();
+    }
+    // close the dynamic library
+    if (lib_handle != nullptr) {
+      dlclose(lib_handle);
+    }
+  }
+};
+
+namespace {
+/**
+ * @brief An immutable snapshot of the devices managed by the driver.
+ */
+struct Device_snapshot {
+  std::vector<std::shared_ptr<QDMI_Device_impl_d>> devices;
+};
+} // namespace
+
+namespace {
+/**
+ * @brief Whether the call statistics of devices opened from now on are
+ * recorded.
+ * @details This is enabled by setting the environment variable
+ * `QDMI_DRIVER_STATS` to any value other than `0` before calling
+ * @ref QDMI_Driver_init.
+ * @return the flag.
+ */
+std::atomic<bool> &Stats_enabled() {
+  static std::atomic<bool> enabled{false};
+  return enabled;
+}
+
+/**
+ * @brief Get the index of the call statistics shard of the calling thread.
+ * @return the index, assigned on the first call of the thread and the same
+ * for all devices.
+ */
+size_t Stats_shard_index() {
+  static std::atomic<size_t> next_index{0};
+  thread_local const size_t index =
+      next_index.fetch_add(1, std::memory_order_relaxed) % NUM_STATS_SHARDS;
+  return index;
+}
+
+/**
+ * @brief Whether trace events are recorded.
+ * @return the flag, checked on every recording attempt.
+ */
+std::atomic<bool> &Trace_enabled() {
+  static std::atomic<bool> enabled{false};
+  return enabled;
+}
+
+/**
+ * @brief Records the latency of a call to the driver in the call statistics.
+ * @details The latency is measured from construction to destruction. Nothing
+ * is recorded for devices that do not record call statistics. The start of
+ * the call is also taken while a trace is written, which records the call as
+ * a slice.
+ */
+struct Call_timer {
+  QDMI_Device_impl_d *device;
+  QDMI_Driver_Call call;
+  std::chrono::steady_clock::time_point start;
+
+  Call_timer(QDMI_Device_impl_d *dev, const QDMI_Driver_Call driver_call)
+      : device(dev != nullptr && dev->stats != nullptr ? dev : nullptr),
+        call(driver_call) {
+    if (device != nullptr ||
+        Trace_enabled().load(std::memory_order_relaxed)) {
+      start = std::chrono::steady_clock::now();
+    }
+  }
+  Call_timer(const Call_timer &) = delete;
+  Call_timer &operator=(const Call_timer &) = delete;
+  Call_timer(Call_timer &&) = delete;
+  Call_timer &operator=(Call_timer &&) = delete;
+
+  ~Call_timer() {
+    if (device == nullptr) {
+      return;
+    }
+    const auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+    auto &counters = (*device->stats)[Stats_shard_index()].calls[call];
+    const auto add = [](std::atomic<uint64_t> &counter, const uint64_t value) {
+      counter.fetch_add(value, std::memory_order_relaxed);
+    };
+    add(counters.count, 1);
+    add(counters.total_ns, ns);
+    auto max_ns = counters.max_ns.load(std::memory_order_relaxed);
+    while (ns > max_ns && !counters.max_ns.compare_exchange_weak(
+                              max_ns, ns, std::memory_order_relaxed)) {
+    }
+    // bucket i holds the latencies in [2^i, 2^(i+1)) ns
+    size_t bucket = 0;
+    for (auto v = ns >> 1U; v != 0 && bucket + 1 < QDMI_DRIVER_STATS_BUCKETS;
+         v >>= 1U) {
+      ++bucket;
+    }
+    add(counters.buckets[bucket], 1);
+  }
+};
+} // namespace
+
+namespace {
+/**
+ * @brief Generate a unique id for a session.
+ * @return a new id, never zero.
+ */
+uint64_t Next_session_id() {
+  static std::atomic<uint64_t> next_id{1};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief The session most recently used by the calling thread.
+ * @details Jobs are created on devices, not on sessions. The trace links a job
+ * to the session whose devices the creating thread obtained last.
+ * @return the id of the session, or zero if there is none.
+ */
+uint64_t &Current_session() {
+  thread_local uint64_t session = 0;
+  return session;
+}
+
+/// The kinds of events recorded in a trace.
+enum class TRACE_EVENT : uint8_t {
+  SESSION_ALLOC,
+  SESSION_FREE,
+  CREATE_JOB,
+  SUBMIT_JOB,
+  CHECK,
+  WAIT,
+  GET_DATA,
+  FREE_JOB,
+  JOB_COMPLETED,
+};
+
+/**
+ * @brief An event recorded in the trace buffer.
+ * @details Events are plain values, so recording one only copies a few words
+ * into the buffer. They are turned into JSON by the writer thread.
+ */
+struct Trace_event {
+  TRACE_EVENT kind = TRACE_EVENT::CHECK;
+  /// The device of a job event, if known. Only valid while recording.
+  const QDMI_Device_impl_d *device = nullptr;
+  /// The job of a job event.
+  const void *job = nullptr;
+  /// The status of the job, the size of the data, or the return value.
+  int64_t value = 0;
+  /// The start of the call the event belongs to, if any.
+  std::chrono::steady_clock::time_point start{};
+  /// The end of the call or the time of the event.
+  std::chrono::steady_clock::time_point end{};
+  /// The session of the event, or zero.
+  uint64_t session = 0;
+  /// The index of the recording thread.
+  uint32_t thread = 0;
+  /// The id of @ref device, set when recording.
+  uint64_t device_id = 0;
+  /// The library path of @ref device, set when recording.
+  const std::string *device_name = nullptr;
+};
+
+/**
+ * @brief A bounded lock-free queue of trace events.
+ * @details Any number of threads record events concurrently, and the writer
+ * thread is the only one consuming them. Every cell carries a sequence number
+ * telling whether it is free for the producer of a given position or filled
+ * for the consumer, so producers only contend on a single atomic increment.
+ * If the queue is full, the event is dropped and counted instead of blocking
+ * the recording thread.
+ */
+struct Trace_buffer {
+  /// The number of cells, a power of two.
+  static constexpr size_t CAPACITY = size_t{1} << 16U;
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    Trace_event event;
+  };
+  std::vector<Cell> cells;
+  /// The next position to write to.
+  std::atomic<size_t> head{0};
+  /// The next position to read from, only accessed by the consumer.
+  size_t tail = 0;
+  /// The number of events dropped because the queue was full.
+  std::atomic<uint64_t> dropped{0};
+
+  /// Allocate the cells, unless already done.
+  void allocate() {
+    if (!cells.empty()) {
+      return;
+    }
+    cells = std::vector<Cell>(CAPACITY);
+    for (size_t i = 0; i < CAPACITY; ++i) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /// Append an event, returns false if the queue is full.
+  bool push(const Trace_event &event) {
+    auto pos = head.load(std::memory_order_relaxed);
+    while (true) {
+      auto &cell = cells[pos & (CAPACITY - 1)];
+      const auto sequence = cell.sequence.load(std::memory_order_acquire);
+      if (sequence == pos) {
+        if (head.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed)) {
+          cell.event = event;
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (sequence < pos) {
+        // the consumer has not freed the cell of the previous round yet
+        return false;
+      } else {
+        pos = head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// Remove the oldest event, returns false if the queue is empty.
+  bool pop(Trace_event &event) {
+    auto &cell = cells[tail & (CAPACITY - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != tail + 1) {
+      return false;
+    }
+    event = cell.event;
+    cell.sequence.store(tail + CAPACITY, std::memory_order_release);
+    ++tail;
+    return true;
+  }
+};
+
+/**
+ * @brief Escape a string for use in a JSON string literal.
+ * @param text the string.
+ * @return the escaped string; control characters are replaced by spaces.
+ */
+std::string Json_escape(const std::string &text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      escaped += ' ';
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+/**
+ * @brief Turns trace events into a trace in the Chrome Trace Event Format.
+ * @details The writer only runs on the writer thread. It reconstructs the
+ * phases of every job from the recorded events and emits the following tracks:
+ * - one process per device, with one thread ("lane") per concurrently existing
+ *   job. A job is a slice from its creation to its release, subdivided into
+ *   the phases `created`, `submitted`, `running`, and `done` (or `cancelled`),
+ *   with instant events for every retrieval of its data.
+ * - one process for the sessions, with one thread per session. A flow arrow
+ *   leads from a session to every job it created.
+ * - one process for the client threads, with a slice for every call creating,
+ *   submitting, waiting for, reading, or freeing a job.
+ */
+struct Trace_writer {
+  /// The process of the sessions.
+  static constexpr uint64_t SESSIONS_PID = 0;
+  /// The process of the client threads.
+  static constexpr uint64_t CLIENT_PID = 1;
+  /// The process of a device is this offset plus the id of the device.
+  static constexpr uint64_t DEVICE_PID_OFFSET = 2;
+
+  /// The phases of a job, in the order they are passed through.
+  enum PHASE : uint8_t { CREATED, SUBMITTED, RUNNING, DONE, CANCELLED };
+  static constexpr std::array<const char *, 5> PHASE_NAMES = {
+      "created", "submitted", "running", "done", "cancelled"};
+
+  /// The state of a job that was not freed yet.
+  struct Job_state {
+    uint64_t pid;
+    uint64_t lane;
+    uint64_t begin_ns;
+    PHASE phase;
+    uint64_t phase_ns;
+    /// A later phase that was recorded before the job was submitted.
+    PHASE pending;
+    uint64_t pending_ns;
+  };
+
+  std::ofstream file;
+  /// The time all timestamps are relative to.
+  std::chrono::steady_clock::time_point origin;
+  /// Whether no event has been written yet.
+  bool first = true;
+  /// The latest timestamp seen.
+  uint64_t last_ns = 0;
+  /// The id of the next flow from a session to a job.
+  uint64_t next_flow = 0;
+  std::unordered_map<const void *, Job_state> jobs;
+  /// Which lanes of a device are occupied, by process of the device.
+  std::unordered_map<uint64_t, std::vector<bool>> lanes;
+  /// The start of the sessions that were not freed yet, by session id.
+  std::unordered_map<uint64_t, uint64_t> sessions;
+  /// The client threads that have been named already.
+  std::unordered_set<uint32_t> threads;
+
+  /// Convert a time point into nanoseconds since the start of the trace.
+  [[nodiscard]] uint64_t ns(const std::chrono::steady_clock::time_point t) {
+    return t < origin
+               ? 0
+               : static_cast<uint64_t>(
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         t - origin)
+                         .count());
+  }
+
+  /// Write nanoseconds as the microseconds expected by the format.
+  void write_us(const uint64_t ns) {
+    file << ns / 1000 << '.' << std::setw(3) << std::setfill('0')
+         << ns % 1000;
+  }
+
+  /// Start a new event and write the fields common to all events.
+  void begin(const char ph, const char *name, const uint64_t pid,
+             const uint64_t tid, const uint64_t ns) {
+    file << (first ? "\n" : ",\n") << R"({"ph":")" << ph << R"(","name":")"
+         << name << R"(","pid":)" << pid << R"(,"tid":)" << tid
+         << R"(,"ts":)";
+    write_us(ns);
+    first = false;
+  }
+
+  /// Write a metadata event naming a process or thread.
+  void name(const char *kind, const uint64_t pid, const uint64_t tid,
+            const std::string &label) {
+    begin('M', kind, pid, tid, 0);
+    file << R"(,"args":{"name":")" << Json_escape(label) << "\"}}";
+  }
+
+  /// Write a complete slice, optionally annotated with a job.
+  void slice(const char *name, const uint64_t pid, const uint64_t tid,
+             const uint64_t begin_ns, const uint64_t end_ns,
+             const void *job = nullptr) {
+    begin('X', name, pid, tid, begin_ns);
+    file << R"(,"dur":)";
+    write_us(end_ns - begin_ns);
+    if (job != nullptr) {
+      file << R"(,"args":{"job":")" << job << "\"}";
+    }
+    file << '}';
+  }
+
+  void write_header() {
+    file << R"({"displayTimeUnit":"ns","traceEvents":[)";
+    name("process_name", SESSIONS_PID, 0, "QDMI sessions");
+    name("process_name", CLIENT_PID, 0, "QDMI client threads");
+  }
+
+  void open_session(const uint64_t session, const uint64_t ns) {
+    if (sessions.emplace(session, ns).second) {
+      name("thread_name", SESSIONS_PID, session,
+           "session " + std::to_string(session));
+    }
+  }
+
+  /// Write the slice of a call of a client thread.
+  void call(const Trace_event &event, const char *function,
+            const uint64_t begin_ns, const uint64_t end_ns) {
+    if (threads.insert(event.thread).second) {
+      name("thread_name", CLIENT_PID, event.thread,
+           "thread " + std::to_string(event.thread));
+    }
+    slice(function, CLIENT_PID, event.thread, begin_ns, end_ns, event.job);
+  }
+
+  void create_job(const Trace_event &event, const uint64_t ns) {
+    const auto pid = DEVICE_PID_OFFSET + event.device_id;
+    auto [it, inserted] = lanes.try_emplace(pid);
+    auto &device_lanes = it->second;
+    if (inserted) {
+      name("process_name", pid, 0, "device " + *event.device_name);
+    }
+    auto lane = static_cast<size_t>(
+        std::find(device_lanes.begin(), device_lanes.end(), false) -
+        device_lanes.begin());
+    if (lane == device_lanes.size()) {
+      device_lanes.push_back(false);
+      name("thread_name", pid, lane + 1, "lane " + std::to_string(lane + 1));
+    }
+    device_lanes[lane] = true;
+    jobs[event.job] = {pid, lane + 1, ns, CREATED, ns, CREATED, 0};
+    if (event.session != 0) {
+      open_session(event.session, ns);
+      const auto flow = next_flow++;
+      begin('s', "job", SESSIONS_PID, event.session, ns);
+      file << R"(,"cat":"job","id":)" << flow << '}';
+      begin('f', "job", pid, lane + 1, ns);
+      file << R"(,"cat":"job","id":)" << flow << R"(,"bp":"e"})";
+    }
+  }
+
+  /// Move a job to a later phase, ignoring transitions to earlier phases.
+  void advance(const void *job, const PHASE phase, const uint64_t ns) {
+    const auto it = jobs.find(job);
+    if (it == jobs.end()) {
+      return;
+    }
+    auto &state = it->second;
+    if (phase <= state.phase || state.phase >= DONE) {
+      return;
+    }
+    if (state.phase == CREATED && (phase == RUNNING || phase == DONE)) {
+      // the completion callback of the device may be recorded before the
+      // call submitting the job returned
+      if (phase > state.pending) {
+        state.pending = phase;
+        state.pending_ns = ns;
+      }
+      return;
+    }
+    // events recorded concurrently may arrive slightly out of order
+    const auto end_ns = std::max(ns, state.phase_ns);
+    slice(PHASE_NAMES[state.phase], state.pid, state.lane, state.phase_ns,
+          end_ns);
+    state.phase = phase;
+    state.phase_ns = end_ns;
+    if (phase == SUBMITTED && state.pending != CREATED) {
+      advance(job, state.pending, state.pending_ns);
+    }
+  }
+
+  /// Map the status of a job to its phase.
+  static PHASE phase_of(const int64_t status) {
+    switch (status) {
+    case QDMI_JOB_STATUS_SUBMITTED:
+      return SUBMITTED;
+    case QDMI_JOB_STATUS_RUNNING:
+      return RUNNING;
+    case QDMI_JOB_STATUS_DONE:
+      return DONE;
+    case QDMI_JOB_STATUS_CANCELLED:
+      return CANCELLED;
+    default:
+      return CREATED;
+    }
+  }
+
+  void free_job(const void *job, const uint64_t ns) {
+    const auto it = jobs.find(job);
+    if (it == jobs.end()) {
+      return;
+    }
+    const auto &state = it->second;
+    const auto end_ns = std::max(ns, state.phase_ns);
+    slice(PHASE_NAMES[state.phase], state.pid, state.lane, state.phase_ns,
+          end_ns);
+    slice("job", state.pid, state.lane, state.begin_ns, end_ns, job);
+    lanes[state.pid][state.lane - 1] = false;
+    jobs.erase(it);
+  }
+
+  void process(const Trace_event &event) {
+    if (event.end < origin) {
+      // recorded before the trace was started
+      return;
+    }
+    const auto begin_ns = ns(event.start);
+    const auto end_ns = ns(event.end);
+    last_ns = std::max(last_ns, end_ns);
+    switch (event.kind) {
+    case TRACE_EVENT::SESSION_ALLOC:
+      open_session(event.session, end_ns);
+      break;
+    case TRACE_EVENT::SESSION_FREE:
+      if (const auto it = sessions.find(event.session); it != sessions.end()) {
+        slice("session", SESSIONS_PID, event.session, it->second, end_ns);
+        sessions.erase(it);
+      }
+      break;
+    case TRACE_EVENT::CREATE_JOB:
+      call(event, "create_job", begin_ns, end_ns);
+      create_job(event, end_ns);
+      break;
+    case TRACE_EVENT::SUBMIT_JOB:
+      call(event, "submit_job", begin_ns, end_ns);
+      advance(event.job, SUBMITTED, begin_ns);
+      break;
+    case TRACE_EVENT::CHECK:
+    case TRACE_EVENT::JOB_COMPLETED:
+      advance(event.job, phase_of(event.value), end_ns);
+      break;
+    case TRACE_EVENT::WAIT:
+      call(event, "wait", begin_ns, end_ns);
+      if (event.value == QDMI_SUCCESS) {
+        advance(event.job, DONE, end_ns);
+      }
+      break;
+    case TRACE_EVENT::GET_DATA:
+      call(event, "get_data", begin_ns, end_ns);
+      if (const auto it = jobs.find(event.job); it != jobs.end()) {
+        begin('i', "get_data", it->second.pid, it->second.lane, end_ns);
+        file << R"(,"s":"t","args":{"bytes":)" << event.value << "}}";
+      }
+      break;
+    case TRACE_EVENT::FREE_JOB:
+      call(event, "free_job", begin_ns, end_ns);
+      free_job(event.job, begin_ns);
+      break;
+    }
+  }
+
+  /// Close the jobs and sessions that are still open and end the trace.
+  void finish(const uint64_t dropped) {
+    while (!jobs.empty()) {
+      free_job(jobs.begin()->first, last_ns);
+    }
+    for (const auto &[session, begin_ns] : sessions) {
+      slice("session", SESSIONS_PID, session, begin_ns, last_ns);
+    }
+    sessions.clear();
+    file << "\n],\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+    file.close();
+  }
+};
+
+/**
+ * @brief The trace buffer and the thread writing its events to a file.
+ */
+struct Tracer {
+  /// The interval in which the writer thread drains the buffer.
+  static constexpr std::chrono::milliseconds FLUSH_INTERVAL{20};
+
+  Trace_buffer buffer;
+  /// Serializes starting and stopping the trace.
+  std::mutex control_mutex;
+  /// Protects @ref stop_requested.
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stop_requested = false;
+  std::thread thread;
+
+  Tracer() = default;
+  Tracer(const Tracer &) = delete;
+  Tracer &operator=(const Tracer &) = delete;
+  Tracer(Tracer &&) = delete;
+  Tracer &operator=(Tracer &&) = delete;
+
+  ~Tracer() { stop(); }
+
+  /// Start writing the events to a file, which must be open.
+  void start(std::ofstream file) {
+    buffer.allocate();
+    buffer.dropped.store(0, std::memory_order_relaxed);
+    auto writer = std::make_unique<Trace_writer>();
+    writer->file = std::move(file);
+    writer->origin = std::chrono::steady_clock::now();
+    writer->write_header();
+    {
+      const std::lock_guard lock(mutex);
+      stop_requested = false;
+    }
+    Trace_enabled().store(true, std::memory_order_release);
+    thread = std::thread([this, writer = std::move(writer)] {
+      Trace_event event;
+      while (true) {
+        bool written = false;
+        while (buffer.pop(event)) {
+          writer->process(event);
+          written = true;
+        }
+        if (written) {
+          writer->file.flush();
+        }
+        std::unique_lock lock(mutex);
+        if (cv.wait_for(lock, FLUSH_INTERVAL,
+                        [this] { return stop_requested; })) {
+          break;
+        }
+      }
+      while (buffer.pop(event)) {
+        writer->process(event);
+      }
+      writer->finish(buffer.dropped.load(std::memory_order_relaxed));
+    });
+  }
+
+  /// Stop recording, write the remaining events, and close the file.
+  void stop() {
+    if (!thread.joinable()) {
+      return;
+    }
+    Trace_enabled().store(false, std::memory_order_relaxed);
+    {
+      const std::lock_guard lock(mutex);
+      stop_requested = true;
+    }
+    cv.notify_all();
+    thread.join();
+  }
+};
+
+/**
+ * @brief Static function to maintain the tracer.
+ * @return the tracer.
+ */
+Tracer &Get_tracer() {
+  static Tracer tracer;
+  return tracer;
+}
+
+/**
+ * @brief Get the index of the calling thread in the trace.
+ * @return the index, assigned on the first call of the thread.
+ */
+uint32_t Trace_thread() {
+  static std::atomic<uint32_t> next_index{1};
+  thread_local const uint32_t index =
+      next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+/**
+ * @brief Record an event in the trace, if a trace is being written.
+ * @details The end of the event is set to the current time, its start to the
+ * same time if it has none, and its session to @ref Current_session if it has
+ * none. Recording never blocks; the event is dropped if the buffer is full.
+ * @param event the event.
+ */
+void Trace(Trace_event event) {
+  if (!Trace_enabled().load(std::memory_order_relaxed)) {
+    return;
+  }
+  event.end = std::chrono::steady_clock::now();
+  if (event.start == std::chrono::steady_clock::time_point{}) {
+    event.start = event.end;
+  }
+  if (event.session == 0) {
+    event.session = Current_session();
+  }
+  event.thread = Trace_thread();
+  if (event.device != nullptr) {
+    event.device_id = event.device->id;
+    event.device_name = event.device->trace_name;
+  }
+  auto &buffer = Get_tracer().buffer;
+  if (!buffer.push(event)) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+} // namespace
+
+/**
+ * @brief Definition of the QDMI Session.
+ */
+struct QDMI_Session_impl_d {
+  /// The unique id of the session.
+  uint64_t id = Next_session_id();
+  /// The devices the session has access to. The snapshot is kept alive by the
+  /// session, even if the driver published a newer one in the meantime.
+  std::shared_ptr<const Device_snapshot> device_list;
+  std::string owner;
+  std::string token;
+};
+
+/// @}
+
+/** @name Implementation of the QDMI Driver Interface
+ * @{
+ */
+
+namespace {
+/**
+ * @brief The registry of the devices managed by the driver.
+ * @details Readers obtain the current @ref Device_snapshot with a single atomic
+ * load, i.e., without taking the write lock and by touching only the reference
+ * count of the snapshot, not those of its devices. Writers are serialized,
+ * copy the current snapshot, modify the copy, and publish it with an atomic
+ * store. A replaced snapshot is reclaimed as soon as the last session holding
+ * it is freed or obtains a newer one.
+ */
+struct Device_registry {
+  /// The snapshot handed out to new readers, never @c nullptr. Only accessed
+  /// through `std::atomic_load` and `std::atomic_store`.
+  std::shared_ptr<const Device_snapshot> current =
+      std::make_shared<const Device_snapshot>();
+  /// Serializes the writers.
+  std::mutex write_mutex;
+};
+
+/**
+ * @brief Static function to maintain the device registry.
+ * @return the device registry.
+ */
+Device_registry &Get_device_registry() {
+  static Device_registry registry;
+  return registry;
+}
+
+/**
+ * @brief Get the current snapshot of the devices managed by the driver.
+ * @details The snapshot stays valid as long as the returned pointer is held.
+ * @return the current snapshot, never @c nullptr.
+ */
+std::shared_ptr<const Device_snapshot> Get_devices() {
+  return std::atomic_load(&Get_device_registry().current);
+}
+
+/**
+ * @brief Publish a modified copy of the current device snapshot.
+ * @details The replaced snapshot is released after the write lock, so that
+ * devices only referenced by it are closed without blocking other writers.
+ * @param update a function modifying the list of devices of the copy.
+ */
+template <class Update> void Update_devices(Update &&update) {
+  auto &registry = Get_device_registry();
+  std::shared_ptr<const Device_snapshot> previous;
+  const std::lock_guard lock(registry.write_mutex);
+  previous = std::atomic_load(&registry.current);
+  auto snapshot = std::make_shared<Device_snapshot>(*previous);
+  std::forward<Update>(update)(snapshot->devices);
+  std::shared_ptr<const Device_snapshot> published = std::move(snapshot);
+  std::atomic_store(&registry.current, std::move(published));
+}
+
+#define LOAD_OPTIONAL_SYMBOL(device, prefix, symbol)                           \
+  {                                                                            \
+    const std::string symbol_name =                                            \
+        std::string(prefix) + "_QDMI_" + #symbol + "_dev";                     \
+    (device).table.symbol =                                                    \
+        reinterpret_cast<decltype((device).table.symbol)>(                     \
+            dlsym((device).lib_handle, symbol_name.c_str()));                  \
+  }
+
+#define LOAD_SYMBOL(device, prefix, symbol)                                    \
+  {                                                                            \
+    const std::string symbol_name =                                            \
+        std::string(prefix) + "_QDMI_" + #symbol + "_dev";                     \
+    (device).table.symbol =                                                    \
+        reinterpret_cast<decltype((device).table.symbol)>(                     \
+            dlsym((device).lib_handle, symbol_name.c_str()));                  \
+    if ((device).table.symbol == nullptr) {                                    \
+      throw std::runtime_error("Failed to load symbol: " + symbol_name);       \
+    }                                                                          \
+  }
+
+/// The names of the entry points in the call statistics.
+constexpr std::array<const char *, QDMI_DRIVER_CALL_MAX> CALL_NAMES = {
+    "query_get_sites",
+    "query_get_operations",
+    "query_device_property",
+    "query_site_property",
+    "query_operation_property",
+    "query_device_properties",
+    "query_operation_properties",
+    "control_create_job",
+    "control_set_parameter",
+    "control_submit_job",
+    "control_cancel",
+    "control_check",
+    "control_wait",
+    "control_wait_for",
+    "control_get_data",
+    "control_free_job"};
+
+/**
+ * @brief The size of the part of @ref QDMI_Device_vtable with the functions
+ * every device must implement.
+ * @details The functions after this part were added later and are optional.
+ */
+constexpr size_t VTABLE_REQUIRED_SIZE =
+    offsetof(QDMI_Device_vtable, control_finalize) +
+    sizeof(QDMI_Device_vtable::control_finalize);
+
+/**
+ * @brief A single device entry of the configuration file.
+ */
+struct Device_config {
+  std::string lib_name;
+  std::string prefix;
+  QDMI_Device_Mode mode = QDMI_DEVICE_MODE_READWRITE;
+  /// Whether the device is only loaded when it is used for the first time.
+  bool lazy = false;
+};
+
+/**
+ * @brief Check that a function table contains all functions a device must
+ * implement.
+ * @param table the function table.
+ * @return true if none of the required functions is @c nullptr.
+ */
+bool Has_required_functions(const QDMI_Device_vtable &table) {
+  return table.query_get_sites != nullptr &&
+         table.query_get_operations != nullptr &&
+         table.query_device_property != nullptr &&
+         table.query_site_property != nullptr &&
+         table.query_operation_property != nullptr &&
+         table.control_create_job != nullptr &&
+         table.control_set_parameter != nullptr &&
+         table.control_submit_job != nullptr &&
+         table.control_cancel != nullptr && table.control_check != nullptr &&
+         table.control_wait != nullptr && table.control_get_data != nullptr &&
+         table.control_free_job != nullptr &&
+         table.control_initialize != nullptr &&
+         table.control_finalize != nullptr;
+}
+
+/**
+ * @brief Load the functions of a device from its exported function table.
+ * @details The table @ref QDMI_device_vtable is looked up under the prefix of
+ * the device. It is only used if its layout version matches the one of the
+ * driver and it contains all functions a device must implement, none of them
+ * @c nullptr. Optional functions that are missing in the table of the device
+ * are set to @c nullptr.
+ * @param device the device whose library is already opened.
+ * @return true if the functions were loaded from the table, false if the
+ * device does not export a compatible table.
+ */
+bool Load_vtable(QDMI_Device_impl_d &device) {
+  const std::string symbol_name = device.prefix + "_QDMI_device_vtable";
+  const auto *vtable = static_cast<const QDMI_Device_vtable *>(
+      dlsym(device.lib_handle, symbol_name.c_str()));
+  if (vtable == nullptr || vtable->version != QDMI_DEVICE_VTABLE_VERSION ||
+      vtable->size < VTABLE_REQUIRED_SIZE) {
+    return false;
+  }
+  device.table = QDMI_Device_vtable{};
+  std::memcpy(&device.table, vtable,
+              std::min(vtable->size, sizeof(QDMI_Device_vtable)));
+  if (!Has_required_functions(device.table)) {
+    device.table = QDMI_Device_vtable{};
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Load the device library, resolve its symbols and initialize it.
+ * @details If the device exports a compatible function table, all functions
+ * are taken from it. Otherwise, every function is looked up separately.
+ * @param device the device to load.
+ * @throws std::runtime_error if the library or one of its symbols could not be
+ * loaded.
+ */
+void QDMI_Device_load(QDMI_Device_impl_d &device) {
+  const auto start = std::chrono::steady_clock::now();
+  const auto &prefix = device.prefix;
+  device.lib_handle = dlopen(device.lib_name.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (device.lib_handle == nullptr) {
+    throw std::runtime_error("Failed to open device library: " +
+                             device.lib_name);
+  }
+
+  try {
+    if (!Load_vtable(device)) {
+      // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+
+      // load the function symbols from the dynamic library
+      LOAD_SYMBOL(device, prefix, control_finalize)
+      LOAD_SYMBOL(device, prefix, query_get_sites)
+      LOAD_SYMBOL(device, prefix, query_get_operations)
+      LOAD_SYMBOL(device, prefix, query_device_property)
+      LOAD_SYMBOL(device, prefix, query_site_property)
+      LOAD_SYMBOL(device, prefix, query_operation_property)
+      LOAD_SYMBOL(device, prefix, control_create_job)
+      LOAD_SYMBOL(device, prefix, control_set_parameter)
+      LOAD_SYMBOL(device, prefix, control_submit_job)
+      LOAD_SYMBOL(device, prefix, control_cancel)
+      LOAD_SYMBOL(device, prefix, control_check)
+      LOAD_SYMBOL(device, prefix, control_wait)
+      LOAD_SYMBOL(device, prefix, control_get_data)
+      LOAD_SYMBOL(device, prefix, control_free_job)
+      LOAD_SYMBOL(device, prefix, control_initialize)
+      LOAD_OPTIONAL_SYMBOL(device, prefix, query_device_properties)
+      LOAD_OPTIONAL_SYMBOL(device, prefix, query_operation_properties)
+      LOAD_OPTIONAL_SYMBOL(device, prefix, control_set_callback)
+      LOAD_OPTIONAL_SYMBOL(device, prefix, control_wait_for)
+
+      // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+    }
+  } catch (const std::exception &e) {
+    dlclose(device.lib_handle);
+    // the destructor must not call into the closed library
+    device.lib_handle = nullptr;
+    device.table = QDMI_Device_vtable{};
+    throw;
+  }
+  // initialize the device
+  device.table.control_initialize();
+
+  device.load_time = std::chrono::steady_clock::now() - start;
+  device.loaded.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Create a device for a configuration entry.
+ * @details Unless the entry is marked as lazy, the device library is loaded
+ * and initialized immediately. Otherwise, the returned device is a stub that
+ * is loaded by @ref Ensure_loaded when it is used for the first time.
+ * @param config the configuration entry of the device.
+ * @return the device.
+ * @throws std::runtime_error if the device could not be loaded.
+ */
+std::shared_ptr<QDMI_Device_impl_d>
+QDMI_Device_open(const Device_config &config) {
+  auto device_handle = std::make_shared<QDMI_Device_impl_d>();
+  auto &device = *device_handle;
+  device.mode = config.mode;
+  device.lib_name = config.lib_name;
+  device.trace_name = Intern_lib_name(config.lib_name);
+  device.prefix = config.prefix;
+  if (Stats_enabled().load(std::memory_order_relaxed)) {
+    device.stats =
+        std::make_unique<std::array<Call_stats_shard, NUM_STATS_SHARDS>>();
+  }
+  if (!config.lazy) {
+    std::call_once(device.load_flag, QDMI_Device_load, std::ref(device));
+  }
+  return device_handle;
+}
+
+/**
+ * @brief Make sure that a (lazily opened) device is loaded and initialized.
+ * @details Concurrent callers block until the first one finished loading the
+ * device. If loading fails, the next call tries again.
+ * @param device the device to load.
+ * @return @ref QDMI_SUCCESS if the device is ready to use.
+ * @return @ref QDMI_ERROR_FATAL if the device could not be loaded.
+ */
+int Ensure_loaded(QDMI_Device_impl_d &device) {
+  if (device.loaded.load(std::memory_order_acquire)) {
+    return QDMI_SUCCESS;
+  }
+  try {
+    std::call_once(device.load_flag, QDMI_Device_load, std::ref(device));
+  } catch (const std::exception &e) {
+    std::cerr << "Failed to load device: " << e.what() << "\n";
+    return QDMI_ERROR_FATAL;
+  }
+  return QDMI_SUCCESS;
+}
+
+/**
+ * @brief Parse the device entries of a configuration file.
+ * @details Every line has the form `<library> <prefix> <mode> [<load>]`,
+ * where `<mode>` is either `read_only` or `read_write` and the optional
+ * `<load>` is either `eager` (default) or `lazy`. Invalid lines are reported
+ * and skipped.
+ * @param file the stream to read the configuration from.
+ * @return the device entries in the order they appear in the file.
+ */
+std::vector<Device_config> Parse_config(std::istream &file) {
+  std::vector<Device_config> configs;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue; // Skip empty lines and comments
+    }
+
+    std::istringstream iss(line);
+    Device_config config;
+    std::string mode_str;
+    if (!(iss >> config.lib_name >> config.prefix >> mode_str)) {
+      std::cerr << "Invalid configuration line: " << line << "\n";
+      continue;
+    }
+    std::string load_str;
+    if (iss >> load_str) {
+      if (load_str == "lazy") {
+        config.lazy = true;
+      } else if (load_str != "eager") {
+        std::cerr << "Invalid load mode: " << load_str << " in line: " << line
+                  << "\n";
+        continue;
+      }
+    }
+
+    if (mode_str == "read_only") {
+      config.mode = QDMI_Device_Mode::QDMI_DEVICE_MODE_READONLY;
+    } else if (mode_str == "read_write") {
+      config.mode = QDMI_Device_Mode::QDMI_DEVICE_MODE_READWRITE;
+    } else {
+      std::cerr << "Invalid mode: " << mode_str << " in line: " << line << "\n";
+      continue;
+    }
+    configs.emplace_back(std::move(config));
+  }
+  return configs;
+}
+
+/**
+ * @brief Read the number of threads used for loading the devices.
+ * @details The number is taken from the environment variable
+ * `QDMI_DRIVER_LOAD_THREADS`. A value of `0` selects the number of hardware
+ * threads. If the variable is not set or invalid, devices are loaded serially.
+ * @return the number of threads, at least one.
+ */
+size_t Get_load_threads() {
+  const char *env = std::getenv("QDMI_DRIVER_LOAD_THREADS");
+  if (env == nullptr) {
+    return 1;
+  }
+  char *end = nullptr;
+  const auto value = std::strtoul(env, &end, 10);
+  if (end == env || *end != '\0') {
+    std::cerr << "Invalid value for QDMI_DRIVER_LOAD_THREADS: " << env << "\n";
+    return 1;
+  }
+  if (value == 0) {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  return value;
+}
+
+/**
+ * @brief Open and initialize the devices of a configuration.
+ * @details With more than one thread, the devices are opened concurrently on a
+ * pool of at most @p num_threads worker threads. In either case, the returned
+ * devices are in the order of @p configs, and the load time of every device
+ * can be obtained with @ref QDMI_Driver_get_load_time.
+ * @param configs the devices to open.
+ * @param num_threads the maximum number of threads to use.
+ * @return the opened devices.
+ * @throws std::runtime_error for the first device, in configuration order,
+ * that could not be opened.
+ */
+std::vector<std::shared_ptr<QDMI_Device_impl_d>>
+Open_devices(const std::vector<Device_config> &configs,
+             const size_t num_threads) {
+  std::vector<std::shared_ptr<QDMI_Device_impl_d>> devices(configs.size());
+  const auto num_workers = std::min(num_threads, configs.size());
+  if (num_workers <= 1) {
+    for (size_t i = 0; i < configs.size(); ++i) {
+      devices[i] = QDMI_Device_open(configs[i]);
+    }
+    return devices;
+  }
+
+  std::vector<std::exception_ptr> errors(configs.size());
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> workers;
+  workers.reserve(num_workers);
+  for (size_t w = 0; w < num_workers; ++w) {
+    workers.emplace_back([&]() {
+      for (auto i = next.fetch_add(1); i < configs.size();
+           i = next.fetch_add(1)) {
+        try {
+          devices[i] = QDMI_Device_open(configs[i]);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  for (const auto &error : errors) {
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+  }
+  return devices;
+}
+
+/**
+ * @brief Finalize a retired device once its last job has been freed.
+ * @details The caller must hold the lifecycle mutex of the device. The library
+ * of the device stays loaded until the device is released by the last session
+ * referring to it, so that these sessions can keep querying it.
+ * @param device the device.
+ */
+void Finalize_if_unused(QDMI_Device_impl_d &device) {
+  if (!device.retired || device.finalized || device.num_jobs > 0 ||
+      !device.loaded.load(std::memory_order_acquire)) {
+    return;
+  }
+  device.table.control_finalize();
+  device.finalized = true;
+}
+
+/**
+ * @brief Register a new job with a device, unless the device was retired.
+ * @param device the device.
+ * @return true if a job may be created on the device.
+ */
+bool Begin_job(QDMI_Device_impl_d &device) {
+  const std::lock_guard lock(device.lifecycle_mutex);
+  if (device.retired) {
+    return false;
+  }
+  // the job keeps the device alive, even if no session refers to it anymore
+  if (device.num_jobs++ == 0) {
+    device.jobs_reference = device.shared_from_this();
+  }
+  return true;
+}
+
+/**
+ * @brief Unregister a job from a device that was freed or never created.
+ * @param device the device.
+ * @return the reference the jobs held to the device if this was its last job,
+ * @c nullptr otherwise. The caller must not access the device anymore after
+ * releasing the reference.
+ */
+std::shared_ptr<QDMI_Device_impl_d> End_job(QDMI_Device_impl_d &device) {
+  const std::lock_guard lock(device.lifecycle_mutex);
+  if (device.num_jobs > 0 && --device.num_jobs > 0) {
+    return nullptr;
+  }
+  Finalize_if_unused(device);
+  return std::move(device.jobs_reference);
+}
+
+/**
+ * @brief Apply a changed configuration to the devices of the driver.
+ * @details Devices whose entry (library, prefix, and mode) is still present
+ * are kept as they are, and devices for new entries are opened before the
+ * devices of the driver are locked for the update. The resulting list is
+ * published at once, so new sessions only see the new configuration. Removed
+ * devices stay usable for the sessions that already obtained them, but no new
+ * jobs can be created on them; they are finalized once their last job has
+ * been freed, and closed once no session or job refers to them anymore.
+ * @param configs the device entries of the new configuration.
+ * @throws std::runtime_error if one of the new devices could not be opened. In
+ * this case, the devices of the driver are left unchanged.
+ */
+void Apply_config(const std::vector<Device_config> &configs) {
+  // the devices of the driver only change here in between
+  static std::mutex reload_mutex;
+  const std::lock_guard reload_lock(reload_mutex);
+  const auto current = Get_devices();
+  const auto &current_devices = current->devices;
+  std::vector<std::shared_ptr<QDMI_Device_impl_d>> devices(configs.size());
+  std::vector<bool> kept(current_devices.size(), false);
+  std::vector<Device_config> added;
+  std::vector<size_t> added_indices;
+  for (size_t i = 0; i < configs.size(); ++i) {
+    const auto &config = configs[i];
+    size_t j = 0;
+    for (; j < current_devices.size(); ++j) {
+      const auto &dev = *current_devices[j];
+      if (!kept[j] && dev.lib_name == config.lib_name &&
+          dev.prefix == config.prefix && dev.mode == config.mode) {
+        break;
+      }
+    }
+    if (j < current_devices.size()) {
+      kept[j] = true;
+      devices[i] = current_devices[j];
+    } else {
+      added.emplace_back(config);
+      added_indices.emplace_back(i);
+    }
+  }
+  auto opened = Open_devices(added, Get_load_threads());
+  for (size_t i = 0; i < opened.size(); ++i) {
+    devices[added_indices[i]] = std::move(opened[i]);
+  }
+  // retire the removed devices before the new list becomes visible
+  for (size_t j = 0; j < current_devices.size(); ++j) {
+    if (!kept[j]) {
+      auto &device = *current_devices[j];
+      const std::lock_guard lock(device.lifecycle_mutex);
+      device.retired = true;
+      Finalize_if_unused(device);
+    }
+  }
+  Update_devices([&devices](auto &device_list) {
+    device_list = std::move(devices);
+  });
+}
+
+/// Determine how long a device property can be cached.
+PROPERTY_LIFETIME Get_lifetime(const QDMI_Device_Property prop) {
+  switch (prop) {
+  case QDMI_DEVICE_PROPERTY_NAME:
+  case QDMI_DEVICE_PROPERTY_VERSION:
+  case QDMI_DEVICE_PROPERTY_LIBRARYVERSION:
+  case QDMI_DEVICE_PROPERTY_QUBITSNUM:
+  case QDMI_DEVICE_PROPERTY_COUPLINGMAP:
+    return PROPERTY_LIFETIME::IMMUTABLE;
+  default:
+    return PROPERTY_LIFETIME::UNCACHED;
+  }
+}
+
+/// Determine how long a site property can be cached.
+PROPERTY_LIFETIME Get_lifetime(const QDMI_Site_Property prop) {
+  switch (prop) {
+  case QDMI_SITE_PROPERTY_TIME_T1:
+  case QDMI_SITE_PROPERTY_TIME_T2:
+    return PROPERTY_LIFETIME::CALIBRATED;
+  default:
+    return PROPERTY_LIFETIME::UNCACHED;
+  }
+}
+
+/// Determine how long an operation property can be cached.
+PROPERTY_LIFETIME Get_lifetime(const QDMI_Operation_Property prop) {
+  switch (prop) {
+  case QDMI_OPERATION_PROPERTY_NAME:
+  case QDMI_OPERATION_PROPERTY_QUBITSNUM:
+    return PROPERTY_LIFETIME::IMMUTABLE;
+  case QDMI_OPERATION_PROPERTY_DURATION:
+  case QDMI_OPERATION_PROPERTY_FIDELITY:
+    return PROPERTY_LIFETIME::CALIBRATED;
+  default:
+    return PROPERTY_LIFETIME::UNCACHED;
+  }
+}
+
+/**
+ * @brief Copy a cached property value to the buffer of a client.
+ * @details The semantics are the same as for the query functions of a device.
+ */
+int Copy_property(const std::vector<unsigned char> &data, const size_t size,
+                  void *value, size_t *size_ret) {
+  if (value != nullptr) {
+    if (size < data.size()) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    std::memcpy(value, data.data(), data.size());
+  }
+  if (size_ret != nullptr) {
+    *size_ret = data.size();
+  }
+  return QDMI_SUCCESS;
+}
+
+/**
+ * @brief Get the calibration epoch of a device.
+ * @details The epoch is queried from the device at most once per
+ * @ref EPOCH_CHECK_INTERVAL by a single thread. In between, the epoch reported
+ * last is used, so that a new calibration is noticed with this delay.
+ * @param device the device.
+ * @param epoch the variable to store the epoch in.
+ * @return false if the device does not report a calibration epoch.
+ */
+bool Get_epoch(QDMI_Device_impl_d &device, size_t &epoch) {
+  auto &cache = device.property_cache;
+  const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count();
+  auto checked = cache.epoch_checked.load(std::memory_order_relaxed);
+  if ((checked == 0 ||
+       now - checked >= std::chrono::nanoseconds(EPOCH_CHECK_INTERVAL)
+                            .count()) &&
+      cache.epoch_checked.compare_exchange_strong(checked, now,
+                                                  std::memory_order_relaxed)) {
+    size_t value = 0;
+    const auto ret = device.table.query_device_property(
+        QDMI_DEVICE_PROPERTY_CALIBRATIONEPOCH, sizeof(size_t), &value,
+        nullptr);
+    cache.device_epoch.store(value, std::memory_order_relaxed);
+    cache.has_epoch.store(ret == QDMI_SUCCESS, std::memory_order_release);
+  }
+  if (!cache.has_epoch.load(std::memory_order_acquire)) {
+    return false;
+  }
+  epoch = cache.device_epoch.load(std::memory_order_relaxed);
+  return true;
+}
+
+/**
+ * @brief Query a property through the property cache of a device.
+ * @details Immutable properties are fetched from the device once. Calibrated
+ * properties are fetched again after the calibration epoch of the device
+ * changed, at which point all calibrated entries are dropped. The epoch is
+ * obtained from @ref Get_epoch. If the device does not report a calibration
+ * epoch, calibrated properties are not cached. Failed queries are never cached
+ * and are always answered by the device.
+ * @param device the device to query.
+ * @param key the key of the property.
+ * @param lifetime how long the property can be cached.
+ * @param size the size of the buffer pointed to by @p value in bytes.
+ * @param value the buffer to write the value to, or @c nullptr.
+ * @param size_ret the pointer to write the size of the value to, or @c nullptr.
+ * @param fetch queries the property from the device with the signature
+ * `int(size_t size, void *value, size_t *size_ret)`.
+ * @return the status of the query.
+ */
+template <class Fetch>
+int Query_cached(QDMI_Device_impl_d &device, const Property_key &key,
+                 const PROPERTY_LIFETIME lifetime, const size_t size,
+                 void *value, size_t *size_ret, const Fetch &fetch) {
+  if (lifetime == PROPERTY_LIFETIME::UNCACHED ||
+      (value == nullptr && size_ret == nullptr)) {
+    return fetch(size, value, size_ret);
+  }
+  auto &cache = device.property_cache;
+  size_t epoch = 0;
+  if (lifetime == PROPERTY_LIFETIME::CALIBRATED && !Get_epoch(device, epoch)) {
+    return fetch(size, value, size_ret);
+  }
+  {
+    const std::lock_guard lock(cache.mutex);
+    if (lifetime == PROPERTY_LIFETIME::CALIBRATED && epoch != cache.epoch) {
+      for (auto it = cache.entries.begin(); it != cache.entries.end();) {
+        if (it->second.lifetime == PROPERTY_LIFETIME::CALIBRATED) {
+          it = cache.entries.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      cache.epoch = epoch;
+    }
+    if (const auto it = cache.entries.find(key); it != cache.entries.end()) {
+      return Copy_property(it->second.data, size, value, size_ret);
+    }
+  }
+
+  size_t data_size = 0;
+  if (fetch(0, nullptr, &data_size) != QDMI_SUCCESS || data_size == 0) {
+    return fetch(size, value, size_ret);
+  }
+  Property_entry entry{std::vector<unsigned char>(data_size), lifetime};
+  if (fetch(data_size, entry.data.data(), nullptr) != QDMI_SUCCESS) {
+    return fetch(size, value, size_ret);
+  }
+  const auto ret = Copy_property(entry.data, size, value, size_ret);
+  const std::lock_guard lock(cache.mutex);
+  // the value is outdated if the epoch changed in the meantime
+  if (lifetime == PROPERTY_LIFETIME::IMMUTABLE || epoch == cache.epoch) {
+    cache.entries.try_emplace(key, std::move(entry));
+  }
+  return ret;
+}
+
+bool Is_path_allowed(const std::filesystem::path &path) {
+  // Define the whitelist of allowed directories
+  const std::vector<std::filesystem::path> whitelist = {
+      std::filesystem::current_path(),
+      std::filesystem::path(std::getenv("HOME"))};
+
+  // Resolve the provided path to its absolute form
+  std::filesystem::path resolved_path = std::filesystem::absolute(path);
+
+  // Check if the resolved path starts with any of the whitelisted directories
+  return std::any_of(
+      whitelist.begin(), whitelist.end(), [&](const auto &allowed_path) {
+        return resolved_path.string().rfind(allowed_path.string(), 0) == 0;
+      });
+}
+
+/**
+ * @brief Create the descriptor pair used to signal the completion of a job.
+ * @details On Linux, a single eventfd is used for both ends. Elsewhere, a pipe
+ * is created. Both descriptors are non-blocking and closed on exec.
+ * @param record the record of the job, whose mutex must be held.
+ * @return true if the descriptors were created, false otherwise.
+ */
+bool Create_completion_fd(Job_record &record) {
+#ifdef __linux__
+  const int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (fd < 0) {
+    return false;
+  }
+  record.read_fd = fd;
+  record.write_fd = fd;
+#else
+  std::array<int, 2> fds{};
+  if (pipe(fds.data()) != 0) {
+    return false;
+  }
+  for (const auto fd : fds) {
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  }
+  record.read_fd = fds[0];
+  record.write_fd = fds[1];
+#endif
+  return true;
+}
+
+/**
+ * @brief Make the completion descriptor of a job readable.
+ * @param record the record of the job, whose mutex must be held.
+ */
+void Signal_completion_fd(const Job_record &record) {
+#ifdef __linux__
+  const uint64_t value = 1;
+#else
+  const char value = 1;
+#endif
+  // a full pipe or a saturated counter is readable already
+  [[maybe_unused]] const auto written =
+      write(record.write_fd, &value, sizeof(value));
+}
+
+/**
+ * @brief The completion callback the driver registers for every job.
+ * @param job the job that has finished or was cancelled.
+ * @param status the final status of the job.
+ * @param user_data the @ref Job_record of the job.
+ */
+void Job_completed(QDMI_Job job, QDMI_Job_Status status, void *user_data) {
+  Trace({TRACE_EVENT::JOB_COMPLETED, nullptr, job, status});
+  auto &record = *static_cast<Job_record *>(user_data);
+  std::vector<std::shared_ptr<Job_waiter>> waiters;
+  {
+    const std::lock_guard lock(record.mutex);
+    record.done = true;
+    record.status = status;
+    if (record.write_fd >= 0) {
+      Signal_completion_fd(record);
+    }
+    waiters = record.waiters;
+  }
+  for (const auto &waiter : waiters) {
+    waiter->signal();
+  }
+}
+
+/**
+ * @brief Start tracking the completion of a newly created job.
+ * @details Does nothing if the device does not support completion callbacks.
+ * @param device the device the job was created on.
+ * @param job the job.
+ */
+void Track_job(QDMI_Device_impl_d &device, QDMI_Job job) {
+  if (device.table.control_set_callback == nullptr) {
+    return;
+  }
+  auto record = std::make_shared<Job_record>();
+  {
+    const std::lock_guard lock(device.jobs_mutex);
+    device.jobs[job] = record;
+  }
+  if (device.table.control_set_callback(job, Job_completed, record.get()) !=
+      QDMI_SUCCESS) {
+    const std::lock_guard lock(device.jobs_mutex);
+    device.jobs.erase(job);
+  }
+}
+
+/**
+ * @brief Look up the completion state of a job.
+ * @param device the device the job was created on.
+ * @param job the job.
+ * @return the record of the job, or @c nullptr if the job is not tracked.
  */
+std::shared_ptr<Job_record> Find_job(QDMI_Device_impl_d &device,
+                                     QDMI_Job job) {
+  const std::lock_guard lock(device.jobs_mutex);
+  const auto it = device.jobs.find(job);
+  return it == device.jobs.end() ? nullptr : it->second;
+}
 
 /**
- * @brief Definition of the QDMI Device.
+ * @brief Compute the point in time at which a timeout expires.
+ * @param timeout the timeout in milliseconds.
+ * @return the deadline, or @c std::chrono::steady_clock::time_point::max() if
+ * the timeout cannot be represented by the clock and never expires.
  */
-struct QDMI_Device_impl_d {
-  void *lib_handle = nullptr;
-  QDMI_Device_Mode mode = QDMI_DEVICE_MODE_READWRITE;
-
-  /// Function pointer to @ref QDMI_query_get_sites_dev.
-  decltype(QDMI_query_get_sites_dev) *query_get_sites{};
-  /// Function pointer to @ref QDMI_query_get_operations_dev.
-  decltype(QDMI_query_get_operations_dev) *query_get_operations{};
-  /// Function pointer to @ref QDMI_query_device_property_dev.
-  decltype(QDMI_query_device_property_dev) *query_device_property{};
-  /// Function pointer to @ref QDMI_query_site_property_dev.
-  decltype(QDMI_query_site_property_dev) *query_site_property{};
-  /// Function pointer to @ref QDMI_query_operation_property_dev.
-  decltype(QDMI_query_operation_property_dev) *query_operation_property{};
-
-  /// Function pointer to @ref QDMI_control_create_job_dev.
-  decltype(QDMI_control_create_job_dev) *control_create_job{};
-  /// Function pointer to @ref QDMI_control_set_parameter_dev.
-  decltype(QDMI_control_set_parameter_dev) *control_set_parameter{};
-  /// Function pointer to @ref QDMI_control_submit_job_dev.
-  decltype(QDMI_control_submit_job_dev) *control_submit_job{};
-  /// Function pointer to @ref QDMI_control_cancel_dev.
-  decltype(QDMI_control_cancel_dev) *control_cancel{};
-  /// Function pointer to @ref QDMI_control_check_dev.
-  decltype(QDMI_control_check_dev) *control_check{};
-  /// Function pointer to @ref QDMI_control_wait_dev.
-  decltype(QDMI_control_wait_dev) *control_wait{};
-  /// Function pointer to @ref QDMI_control_get_data_dev.
-  decltype(QDMI_control_get_data_dev) *control_get_data{};
-  /// Function pointer to @ref QDMI_control_free_job_dev.
-  decltype(QDMI_control_free_job_dev) *control_free_job{};
-  /// Function pointer to @ref QDMI_control_initialize_dev.
-  decltype(QDMI_control_initialize_dev) *control_initialize{};
-  /// Function pointer to @ref QDMI_control_finalize_dev.
-  decltype(QDMI_control_finalize_dev) *control_finalize{};
-
-  // default constructor
-  QDMI_Device_impl_d() = default;
+std::chrono::steady_clock::time_point Deadline_after(const size_t timeout) {
+  using Clock = std::chrono::steady_clock;
+  const auto now = Clock::now();
+  const auto max_timeout =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          Clock::time_point::max() - now)
+          .count();
+  if (timeout >= static_cast<uint64_t>(max_timeout)) {
+    return Clock::time_point::max();
+  }
+  return now + std::chrono::milliseconds(timeout);
+}
 
-  // delete copy constructor, copy assignment, move constructor, move assignment
-  QDMI_Device_impl_d(const QDMI_Device_impl_d &) = delete;
-  QDMI_Device_impl_d &operator=(const QDMI_Device_impl_d &) = delete;
-  QDMI_Device_impl_d(QDMI_Device_impl_d &&) = delete;
-  QDMI_Device_impl_d &operator=(QDMI_Device_impl_d &&) = delete;
+/// The longest pause between two checks of a job by @ref Poll_job.
+constexpr std::chrono::milliseconds MAX_POLL_INTERVAL{10};
 
-  // destructor
-  ~QDMI_Device_impl_d() {
-    // Check if QDMI_control_finalize is not NULL before calling it
-    if (control_finalize != nullptr) {
-      control_finalize();
+/**
+ * @brief Wait for a job by repeatedly checking its status.
+ * @details This is the last resort for devices that neither implement
+ * @ref QDMI_control_wait_for_dev nor completion callbacks. The pause between
+ * two checks starts short, so that short jobs are noticed quickly, and doubles
+ * up to @ref MAX_POLL_INTERVAL.
+ * @param device the device the job was created on.
+ * @param job the job.
+ * @param timeout the maximum time to wait in milliseconds.
+ * @return @ref QDMI_SUCCESS if the job has finished or was cancelled.
+ * @return @ref QDMI_ERROR_TIMEOUT if the timeout expired before.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if the job was not submitted.
+ * @return the error of the device if the status could not be checked.
+ */
+int Poll_job(QDMI_Device_impl_d &device, QDMI_Job job, const size_t timeout) {
+  const auto deadline = Deadline_after(timeout);
+  std::chrono::steady_clock::duration interval = std::chrono::microseconds(50);
+  while (true) {
+    QDMI_Job_Status status{};
+    if (const auto ret = device.table.control_check(job, &status);
+        ret != QDMI_SUCCESS) {
+      return ret;
     }
-    // close the dynamic library
-    if (lib_handle != nullptr) {
-      dlclose(lib_handle);
+    if (status == QDMI_JOB_STATUS_DONE ||
+        status == QDMI_JOB_STATUS_CANCELLED) {
+      return QDMI_SUCCESS;
+    }
+    // a job that was not submitted would never finish
+    if (status == QDMI_JOB_STATUS_CREATED) {
+      return QDMI_ERROR_INVALIDARGUMENT;
     }
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return QDMI_ERROR_TIMEOUT;
+    }
+    std::this_thread::sleep_for(std::min(interval, deadline - now));
+    interval = std::min<std::chrono::steady_clock::duration>(
+        interval * 2, MAX_POLL_INTERVAL);
   }
-};
+}
 
 /**
- * @brief Definition of the QDMI Session.
+ * @brief Read the configuration file again and apply its changes.
+ * @param config_file the path of the configuration file.
  */
-struct QDMI_Session_impl_d {
-  std::vector<std::shared_ptr<QDMI_Device_impl_d>> device_list;
-  std::string owner;
-  std::string token;
-};
+void Reload_config(const std::filesystem::path &config_file) {
+  std::ifstream file(config_file);
+  if (!file.is_open()) {
+    std::cerr << "Failed to open configuration file: " << config_file << "\n";
+    return;
+  }
+  const auto configs = Parse_config(file);
+  file.close();
+  try {
+    Apply_config(configs);
+  } catch (const std::exception &e) {
+    std::cerr << "Failed to reload configuration: " << e.what() << "\n";
+  }
+}
 
-/// @}
+/**
+ * @brief The thread watching the configuration file for changes.
+ */
+struct Config_watcher {
+  std::thread thread;
+  /// The inotify instance watching the directory of the configuration file.
+  int inotify_fd = -1;
+  /// Becomes readable when the thread is requested to stop.
+  int stop_fd = -1;
+};
 
-/** @name Implementation of the QDMI Driver Interface
- * @{
+/**
+ * @brief Static function to maintain the configuration watcher.
+ * @return the configuration watcher.
  */
+Config_watcher &Get_config_watcher() {
+  static Config_watcher watcher;
+  return watcher;
+}
 
-namespace {
 /**
- * @brief Global list of devices managed by the driver.
+ * @brief Check whether the configuration file should be watched for changes.
+ * @details This is enabled by setting the environment variable
+ * `QDMI_DRIVER_RELOAD` to any value other than `0`.
+ * @return true if the configuration should be reloaded on changes.
  */
-// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
-std::vector<std::shared_ptr<QDMI_Device_impl_d>> device_list;
+bool Is_reload_enabled() {
+  const char *env = std::getenv("QDMI_DRIVER_RELOAD");
+  return env != nullptr && std::string(env) != "0";
+}
 
-#define LOAD_SYMBOL(device, prefix, symbol)                                    \
-  {                                                                            \
-    const std::string symbol_name =                                            \
-        std::string(prefix) + "_QDMI_" + #symbol + "_dev";                     \
-    (device).symbol = reinterpret_cast<decltype((device).symbol)>(             \
-        dlsym((device).lib_handle, symbol_name.c_str()));                      \
-    if ((device).symbol == nullptr) {                                          \
-      throw std::runtime_error("Failed to load symbol: " + symbol_name);       \
-    }                                                                          \
+/**
+ * @brief Start watching the configuration file for changes.
+ * @details The directory of the file is watched, such that the file is also
+ * picked up when it is replaced by renaming another file. Every change is
+ * applied with @ref Reload_config on the watcher thread. Watching is only
+ * supported on Linux.
+ * @param config_file the path of the configuration file.
+ */
+void Start_config_watcher(const std::filesystem::path &config_file) {
+#ifdef __linux__
+  auto &watcher = Get_config_watcher();
+  const auto path = std::filesystem::absolute(config_file);
+  watcher.inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+  watcher.stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (watcher.inotify_fd < 0 || watcher.stop_fd < 0 ||
+      inotify_add_watch(watcher.inotify_fd, path.parent_path().c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    std::cerr << "Failed to watch configuration file: " << path << "\n";
+    return;
   }
+  watcher.thread = std::thread([&watcher, path] {
+    std::array<pollfd, 2> fds{pollfd{watcher.inotify_fd, POLLIN, 0},
+                              pollfd{watcher.stop_fd, POLLIN, 0}};
+    while (true) {
+      if (poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (fds[1].revents != 0) {
+        return;
+      }
+      alignas(inotify_event) std::array<char, 4096> buffer{};
+      const auto length =
+          read(watcher.inotify_fd, buffer.data(), buffer.size());
+      bool changed = false;
+      for (ssize_t offset = 0; offset < length;) {
+        const auto *event =
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            reinterpret_cast<const inotify_event *>(&buffer[offset]);
+        changed |= event->len > 0 && path.filename() == event->name;
+        offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+      }
+      if (changed) {
+        Reload_config(path);
+      }
+    }
+  });
+#else
+  std::cerr << "Reloading the configuration is not supported: " << config_file
+            << "\n";
+#endif
+}
 
-std::shared_ptr<QDMI_Device_impl_d>
-QDMI_Device_open(const std::string &lib_name, const std::string &prefix,
-                 const QDMI_Device_Mode mode) {
-  auto device_handle = std::make_shared<QDMI_Device_impl_d>();
-  auto &device = *device_handle;
-  device.mode = mode;
-  device.lib_handle = dlopen(lib_name.c_str(), RTLD_NOW | RTLD_LOCAL);
-  if (device.lib_handle == nullptr) {
-    throw std::runtime_error("Failed to open device library: " + lib_name);
+/**
+ * @brief Stop watching the configuration file, if it is watched.
+ */
+void Stop_config_watcher() {
+  auto &watcher = Get_config_watcher();
+  if (watcher.thread.joinable()) {
+    const uint64_t value = 1;
+    [[maybe_unused]] const auto written =
+        write(watcher.stop_fd, &value, sizeof(value));
+    watcher.thread.join();
   }
-
-  try {
-    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
-
-    // load the function symbols from the dynamic library
-    LOAD_SYMBOL(device, prefix, control_finalize)
-    LOAD_SYMBOL(device, prefix, query_get_sites)
-    LOAD_SYMBOL(device, prefix, query_get_operations)
-    LOAD_SYMBOL(device, prefix, query_device_property)
-    LOAD_SYMBOL(device, prefix, query_site_property)
-    LOAD_SYMBOL(device, prefix, query_operation_property)
-    LOAD_SYMBOL(device, prefix, control_create_job)
-    LOAD_SYMBOL(device, prefix, control_set_parameter)
-    LOAD_SYMBOL(device, prefix, control_submit_job)
-    LOAD_SYMBOL(device, prefix, control_cancel)
-    LOAD_SYMBOL(device, prefix, control_check)
-    LOAD_SYMBOL(device, prefix, control_wait)
-    LOAD_SYMBOL(device, prefix, control_get_data)
-    LOAD_SYMBOL(device, prefix, control_free_job)
-    LOAD_SYMBOL(device, prefix, control_initialize)
-
-    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
-  } catch (const std::exception &e) {
-    dlclose(device.lib_handle);
-    throw;
+  for (auto *fd : {&watcher.inotify_fd, &watcher.stop_fd}) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
   }
-  // initialize the device
-  device.control_initialize();
-
-  return device_handle;
-}
-
-bool Is_path_allowed(const std::filesystem::path &path) {
-  // Define the whitelist of allowed directories
-  const std::vector<std::filesystem::path> whitelist = {
-      std::filesystem::current_path(),
-      std::filesystem::path(std::getenv("HOME"))};
-
-  // Resolve the provided path to its absolute form
-  std::filesystem::path resolved_path = std::filesystem::absolute(path);
-
-  // Check if the resolved path starts with any of the whitelisted directories
-  return std::any_of(
-      whitelist.begin(), whitelist.end(), [&](const auto &allowed_path) {
-        return resolved_path.string().rfind(allowed_path.string(), 0) == 0;
-      });
 }
 } // namespace
 
@@ -213,45 +1976,40 @@ int QDMI_Driver_init() {
     return QDMI_ERROR_FATAL;
   }
 
-  std::string line;
-  while (std::getline(file, line)) {
-    if (line.empty() || line[0] == '#') {
-      continue; // Skip empty lines and comments
-    }
-
-    std::istringstream iss(line);
-    std::string lib_name;
-    std::string prefix;
-    std::string mode_str;
-    if (!(iss >> lib_name >> prefix >> mode_str)) {
-      std::cerr << "Invalid configuration line: " << line << "\n";
-      continue;
-    }
-
-    QDMI_Device_Mode mode{};
-    if (mode_str == "read_only") {
-      mode = QDMI_Device_Mode::QDMI_DEVICE_MODE_READONLY;
-    } else if (mode_str == "read_write") {
-      mode = QDMI_Device_Mode::QDMI_DEVICE_MODE_READWRITE;
-    } else {
-      std::cerr << "Invalid mode: " << mode_str << " in line: " << line << "\n";
-      continue;
-    }
+  const auto configs = Parse_config(file);
+  file.close();
 
-    try {
-      device_list.emplace_back(QDMI_Device_open(lib_name, prefix, mode));
-    } catch (const std::exception &e) {
-      std::cerr << "Failed to open device: " << e.what() << "\n";
-      return QDMI_ERROR_FATAL;
-    }
+  const char *stats = std::getenv("QDMI_DRIVER_STATS");
+  Stats_enabled().store(stats != nullptr && std::string(stats) != "0",
+                        std::memory_order_relaxed);
+  try {
+    auto devices = Open_devices(configs, Get_load_threads());
+    Update_devices([&devices](auto &device_list) {
+      device_list.insert(device_list.end(),
+                         std::make_move_iterator(devices.begin()),
+                         std::make_move_iterator(devices.end()));
+    });
+  } catch (const std::exception &e) {
+    std::cerr << "Failed to open device: " << e.what() << "\n";
+    return QDMI_ERROR_FATAL;
   }
 
-  file.close();
+  if (Is_reload_enabled()) {
+    Start_config_watcher(config_file);
+  }
+  if (const char *trace_file = std::getenv("QDMI_TRACE");
+      trace_file != nullptr &&
+      QDMI_Driver_start_trace(trace_file) != QDMI_SUCCESS) {
+    std::cerr << "Failed to open trace file: " << trace_file << "\n";
+  }
   return QDMI_SUCCESS;
 }
 
 int QDMI_session_alloc(QDMI_Session *session) {
   *session = new QDMI_Session_impl_d();
+  Trace_event event{TRACE_EVENT::SESSION_ALLOC};
+  event.session = (*session)->id;
+  Trace(event);
   return QDMI_SUCCESS;
 }
 
@@ -297,13 +2055,15 @@ int QDMI_session_get_devices(QDMI_Session session, const size_t num_entries,
   // owner or token is provided. If the owner or token is not provided, the
   // session has access to no devices and return QDMI_ERROR_PERMISSIONDENIED
   if (session->owner.empty() && session->token.empty()) {
-    session->device_list.clear();
+    session->device_list = nullptr;
     return QDMI_ERROR_PERMISSIONDENIED;
   }
 
-  session->device_list = device_list;
+  session->device_list = Get_devices();
+  Current_session() = session->id;
 
-  const auto num_devices_in_session = session->device_list.size();
+  const auto &device_list = session->device_list->devices;
+  const auto num_devices_in_session = device_list.size();
   if (devices == nullptr) {
     *num_devices = num_devices_in_session;
     return QDMI_SUCCESS;
@@ -312,7 +2072,11 @@ int QDMI_session_get_devices(QDMI_Session session, const size_t num_entries,
   const auto num_devices_to_copy =
       std::min(num_entries, num_devices_in_session);
   for (size_t i = 0; i < num_devices_to_copy; ++i) {
-    devices[i] = session->device_list[i].get();
+    // lazily opened devices are loaded once they are handed out
+    if (const auto ret = Ensure_loaded(*device_list[i]); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    devices[i] = device_list[i].get();
   }
   if (num_devices != nullptr) {
     *num_devices = num_devices_to_copy;
@@ -320,11 +2084,28 @@ int QDMI_session_get_devices(QDMI_Session session, const size_t num_entries,
   return QDMI_SUCCESS;
 }
 
-void QDMI_session_free(QDMI_Session session) { delete session; }
+void QDMI_session_free(QDMI_Session session) {
+  if (session != nullptr) {
+    Trace_event event{TRACE_EVENT::SESSION_FREE};
+    event.session = session->id;
+    Trace(event);
+    if (Current_session() == session->id) {
+      Current_session() = 0;
+    }
+  }
+  delete session;
+}
 
 int QDMI_Driver_shutdown() {
-  // Close all devices
-  device_list.clear();
+  Stop_config_watcher();
+  QDMI_Driver_stop_trace();
+  if (const char *stats_file = std::getenv("QDMI_DRIVER_STATS_FILE");
+      stats_file != nullptr &&
+      Stats_enabled().load(std::memory_order_relaxed)) {
+    QDMI_Driver_dump_stats(stats_file);
+  }
+  // Close all devices that are not referenced by a session anymore
+  Update_devices([](auto &device_list) { device_list.clear(); });
   return QDMI_SUCCESS;
 }
 
@@ -336,25 +2117,119 @@ int QDMI_Driver_shutdown() {
 
 int QDMI_query_get_sites(QDMI_Device device, const size_t num_entries,
                          QDMI_Site *sites, size_t *num_sites) {
-  return device->query_get_sites(num_entries, sites, num_sites);
+  const Call_timer timer(device, QDMI_DRIVER_CALL_QUERY_GET_SITES);
+  if (const auto ret = Ensure_loaded(*device); ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  return device->table.query_get_sites(num_entries, sites, num_sites);
 }
 
 int QDMI_query_get_operations(QDMI_Device device, const size_t num_entries,
                               QDMI_Operation *operations,
                               size_t *num_operations) {
-  return device->query_get_operations(num_entries, operations, num_operations);
+  const Call_timer timer(device, QDMI_DRIVER_CALL_QUERY_GET_OPERATIONS);
+  if (const auto ret = Ensure_loaded(*device); ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  return device->table.query_get_operations(num_entries, operations,
+                                            num_operations);
+}
+
+namespace {
+/**
+ * @brief Query a property of a loaded device through the property cache.
+ * @details Unlike @ref QDMI_query_device_property, the call is not recorded in
+ * the call statistics, such that the queries of a batch are not counted
+ * separately.
+ * @param device the device.
+ * @param prop the property.
+ * @param size the size of the buffer pointed to by @p value in bytes.
+ * @param value the buffer to write the value to, or @c nullptr.
+ * @param size_ret the pointer to write the size of the value to, or @c nullptr.
+ * @return the status of the query.
+ */
+int Query_device_property(QDMI_Device_impl_d &device,
+                          const QDMI_Device_Property prop, const size_t size,
+                          void *value, size_t *size_ret) {
+  if (prop >= QDMI_DEVICE_PROPERTY_MAX) {
+    return device.table.query_device_property(prop, size, value, size_ret);
+  }
+  return Query_cached(
+      device, {PROPERTY_KIND::DEVICE, prop, nullptr, 0, {}},
+      Get_lifetime(prop), size, value, size_ret,
+      [&device, prop](const size_t s, void *v, size_t *r) {
+        return device.table.query_device_property(prop, s, v, r);
+      });
+}
+
+/**
+ * @brief Query a property of an operation of a loaded device through the
+ * property cache.
+ * @details Unlike @ref QDMI_query_operation_property, the call is not recorded
+ * in the call statistics, such that the queries of a batch are not counted
+ * separately.
+ * @param device the device.
+ * @param operation the operation.
+ * @param num_sites the number of sites the operation acts on.
+ * @param sites the sites the operation acts on.
+ * @param prop the property.
+ * @param size the size of the buffer pointed to by @p value in bytes.
+ * @param value the buffer to write the value to, or @c nullptr.
+ * @param size_ret the pointer to write the size of the value to, or @c nullptr.
+ * @return the status of the query.
+ */
+int Query_operation_property(QDMI_Device_impl_d &device,
+                             QDMI_Operation operation, const size_t num_sites,
+                             const QDMI_Site *sites,
+                             const QDMI_Operation_Property prop,
+                             const size_t size, void *value,
+                             size_t *size_ret) {
+  if (operation == nullptr || prop >= QDMI_OPERATION_PROPERTY_MAX ||
+      (sites == nullptr && num_sites != 0) ||
+      (sites != nullptr && num_sites == 0) ||
+      // properties on many sites do not fit into a key and are not cached
+      num_sites > PROPERTY_KEY_MAX_SITES) {
+    return device.table.query_operation_property(operation, num_sites, sites,
+                                                 prop, size, value, size_ret);
+  }
+  Property_key key{PROPERTY_KIND::OPERATION, prop, operation, num_sites, {}};
+  std::copy_n(sites, num_sites, key.sites.begin());
+  return Query_cached(device, key, Get_lifetime(prop), size, value, size_ret,
+                      [&device, operation, num_sites, sites,
+                       prop](const size_t s, void *v, size_t *r) {
+                        return device.table.query_operation_property(
+                            operation, num_sites, sites, prop, s, v, r);
+                      });
 }
+} // namespace
 
 int QDMI_query_device_property(QDMI_Device device, QDMI_Device_Property prop,
                                const size_t size, void *value,
                                size_t *size_ret) {
-  return device->query_device_property(prop, size, value, size_ret);
+  const Call_timer timer(device, QDMI_DRIVER_CALL_QUERY_DEVICE_PROPERTY);
+  if (const auto ret = Ensure_loaded(*device); ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  return Query_device_property(*device, prop, size, value, size_ret);
 }
 
 int QDMI_query_site_property(QDMI_Device device, QDMI_Site site,
                              QDMI_Site_Property prop, const size_t size,
                              void *value, size_t *size_ret) {
-  return device->query_site_property(site, prop, size, value, size_ret);
+  const Call_timer timer(device, QDMI_DRIVER_CALL_QUERY_SITE_PROPERTY);
+  if (const auto ret = Ensure_loaded(*device); ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  if (site == nullptr || prop >= QDMI_SITE_PROPERTY_MAX) {
+    return device->table.query_site_property(site, prop, size, value,
+                                             size_ret);
+  }
+  return Query_cached(
+      *device, {PROPERTY_KIND::SITE, prop, site, 0, {}}, Get_lifetime(prop),
+      size, value, size_ret,
+      [device, site, prop](const size_t s, void *v, size_t *r) {
+        return device->table.query_site_property(site, prop, s, v, r);
+      });
 }
 
 int QDMI_query_operation_property(QDMI_Device device, QDMI_Operation operation,
@@ -363,15 +2238,92 @@ int QDMI_query_operation_property(QDMI_Device device, QDMI_Operation operation,
                                   QDMI_Operation_Property prop,
                                   const size_t size, void *value,
                                   size_t *size_ret) {
-  return device->query_operation_property(operation, num_sites, sites, prop,
-                                          size, value, size_ret);
+  const Call_timer timer(device, QDMI_DRIVER_CALL_QUERY_OPERATION_PROPERTY);
+  if (const auto ret = Ensure_loaded(*device); ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  return Query_operation_property(*device, operation, num_sites, sites, prop,
+                                  size, value, size_ret);
+}
+
+int QDMI_query_device_properties(QDMI_Device device, const size_t num_queries,
+                                 QDMI_Device_Property_Query *queries) {
+  const Call_timer timer(device, QDMI_DRIVER_CALL_QUERY_DEVICE_PROPERTIES);
+  if (device == nullptr || (queries == nullptr && num_queries > 0)) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  if (const auto ret = Ensure_loaded(*device); ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  if (device->table.query_device_properties != nullptr) {
+    return device->table.query_device_properties(num_queries, queries);
+  }
+  // the device does not support batched queries
+  for (size_t i = 0; i < num_queries; ++i) {
+    auto &query = queries[i];
+    query.size_ret = 0;
+    query.status = Query_device_property(*device, query.prop, query.size,
+                                         query.value, &query.size_ret);
+  }
+  return QDMI_SUCCESS;
+}
+
+int QDMI_query_operation_properties(QDMI_Device device,
+                                    QDMI_Operation operation,
+                                    const size_t num_tuples,
+                                    const size_t tuple_size,
+                                    const QDMI_Site *sites,
+                                    QDMI_Operation_Property prop,
+                                    const size_t size, void *values,
+                                    int *status) {
+  const Call_timer timer(device,
+                         QDMI_DRIVER_CALL_QUERY_OPERATION_PROPERTIES);
+  if (device == nullptr || operation == nullptr ||
+      prop >= QDMI_OPERATION_PROPERTY_MAX ||
+      (num_tuples > 0 && (tuple_size == 0 || sites == nullptr ||
+                          values == nullptr || status == nullptr))) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  if (const auto ret = Ensure_loaded(*device); ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  if (device->table.query_operation_properties != nullptr) {
+    return device->table.query_operation_properties(
+        operation, num_tuples, tuple_size, sites, prop, size, values, status);
+  }
+  // the device does not support batched queries
+  auto *value = static_cast<char *>(values);
+  for (size_t i = 0; i < num_tuples; ++i) {
+    status[i] = Query_operation_property(
+        *device, operation, tuple_size, &sites[i * tuple_size], prop, size,
+        value + (i * size), nullptr);
+  }
+  return QDMI_SUCCESS;
 }
 
 int QDMI_control_create_job(QDMI_Device dev, QDMI_Program_Format format,
                             const size_t size, const void *prog,
                             QDMI_Job *job) {
+  const Call_timer timer(dev, QDMI_DRIVER_CALL_CONTROL_CREATE_JOB);
   if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0) {
-    return dev->control_create_job(format, size, prog, job);
+    if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    // no new jobs on devices removed from the configuration
+    if (!Begin_job(*dev)) {
+      return QDMI_ERROR_NOTFOUND;
+    }
+    const auto ret = dev->table.control_create_job(format, size, prog, job);
+    if (ret == QDMI_SUCCESS) {
+      Track_job(*dev, *job);
+      Trace({TRACE_EVENT::CREATE_JOB, dev, *job, 0, timer.start});
+    } else {
+      // the device is still referred to by the session of the caller
+      End_job(*dev);
+    }
+    QDMI_PROBE4(job__create, dev->lib_name.c_str(),
+                ret == QDMI_SUCCESS ? *job : nullptr, size, ret);
+    return ret;
   }
   return QDMI_ERROR_PERMISSIONDENIED;
 }
@@ -379,52 +2331,350 @@ int QDMI_control_create_job(QDMI_Device dev, QDMI_Program_Format format,
 int QDMI_control_set_parameter(QDMI_Device dev, QDMI_Job job,
                                QDMI_Job_Parameter param, const size_t size,
                                const void *value) {
+  const Call_timer timer(dev, QDMI_DRIVER_CALL_CONTROL_SET_PARAMETER);
   if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0) {
-    return dev->control_set_parameter(job, param, size, value);
+    if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    const auto ret = dev->table.control_set_parameter(job, param, size, value);
+    QDMI_PROBE5(job__set__parameter, dev->lib_name.c_str(), job,
+                static_cast<int>(param), size, ret);
+    return ret;
   }
   return QDMI_ERROR_PERMISSIONDENIED;
 }
 
 int QDMI_control_submit_job(QDMI_Device dev, QDMI_Job job) {
+  const Call_timer timer(dev, QDMI_DRIVER_CALL_CONTROL_SUBMIT_JOB);
   if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0) {
-    return dev->control_submit_job(job);
+    if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    const auto ret = dev->table.control_submit_job(job);
+    QDMI_PROBE3(job__submit, dev->lib_name.c_str(), job, ret);
+    if (ret == QDMI_SUCCESS) {
+      Trace({TRACE_EVENT::SUBMIT_JOB, dev, job, 0, timer.start});
+    }
+    return ret;
   }
   return QDMI_ERROR_PERMISSIONDENIED;
 }
 
 int QDMI_control_cancel(QDMI_Device dev, QDMI_Job job) {
+  const Call_timer timer(dev, QDMI_DRIVER_CALL_CONTROL_CANCEL);
   if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0) {
-    return dev->control_cancel(job);
+    if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    return dev->table.control_cancel(job);
   }
   return QDMI_ERROR_PERMISSIONDENIED;
 }
 
 int QDMI_control_check(QDMI_Device dev, QDMI_Job job, QDMI_Job_Status *status) {
+  const Call_timer timer(dev, QDMI_DRIVER_CALL_CONTROL_CHECK);
   if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0) {
-    return dev->control_check(job, status);
+    if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    const auto ret = dev->table.control_check(job, status);
+    QDMI_PROBE4(job__check, dev->lib_name.c_str(), job,
+                ret == QDMI_SUCCESS ? static_cast<int>(*status) : -1, ret);
+    if (ret == QDMI_SUCCESS) {
+      Trace({TRACE_EVENT::CHECK, dev, job, *status});
+    }
+    return ret;
   }
   return QDMI_ERROR_PERMISSIONDENIED;
 }
 
 int QDMI_control_wait(QDMI_Device dev, QDMI_Job job) {
+  const Call_timer timer(dev, QDMI_DRIVER_CALL_CONTROL_WAIT);
+  if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0) {
+    if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    QDMI_PROBE3(job__wait__begin, dev->lib_name.c_str(), job, int64_t{-1});
+    const auto ret = dev->table.control_wait(job);
+    QDMI_PROBE3(job__wait__end, dev->lib_name.c_str(), job, ret);
+    Trace({TRACE_EVENT::WAIT, dev, job, ret, timer.start});
+    return ret;
+  }
+  return QDMI_ERROR_PERMISSIONDENIED;
+}
+
+int QDMI_control_wait_for(QDMI_Device dev, QDMI_Job job, const size_t timeout) {
+  const Call_timer timer(dev, QDMI_DRIVER_CALL_CONTROL_WAIT_FOR);
   if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0) {
-    return dev->control_wait(job);
+    if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    QDMI_PROBE3(job__wait__begin, dev->lib_name.c_str(), job,
+                static_cast<int64_t>(timeout));
+    int ret = QDMI_SUCCESS;
+    if (dev->table.control_wait_for != nullptr) {
+      ret = dev->table.control_wait_for(job, timeout);
+    } else if (dev->table.control_set_callback != nullptr) {
+      // fall back to the completion callbacks of the device
+      ret = QDMI_Driver_wait_jobs(1, &dev, &job, QDMI_DRIVER_WAIT_ANY, timeout,
+                                  nullptr);
+    } else {
+      ret = Poll_job(*dev, job, timeout);
+    }
+    QDMI_PROBE3(job__wait__end, dev->lib_name.c_str(), job, ret);
+    Trace({TRACE_EVENT::WAIT, dev, job, ret, timer.start});
+    return ret;
   }
   return QDMI_ERROR_PERMISSIONDENIED;
 }
 
 int QDMI_control_get_data(QDMI_Device dev, QDMI_Job job, QDMI_Job_Result result,
                           const size_t size, void *data, size_t *size_ret) {
+  const Call_timer timer(dev, QDMI_DRIVER_CALL_CONTROL_GET_DATA);
   if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0) {
-    return dev->control_get_data(job, result, size, data, size_ret);
+    if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    const auto ret =
+        dev->table.control_get_data(job, result, size, data, size_ret);
+    QDMI_PROBE5(job__get__data, dev->lib_name.c_str(), job,
+                static_cast<int>(result),
+                size_ret != nullptr && ret == QDMI_SUCCESS ? *size_ret : size,
+                ret);
+    if (ret == QDMI_SUCCESS && data != nullptr) {
+      Trace({TRACE_EVENT::GET_DATA, dev, job,
+             static_cast<int64_t>(size_ret != nullptr ? *size_ret : size),
+             timer.start});
+    }
+    return ret;
   }
   return QDMI_ERROR_PERMISSIONDENIED;
 }
 
 void QDMI_control_free_job(QDMI_Device dev, QDMI_Job job) {
-  if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0) {
-    dev->control_free_job(job);
+  // released last, once the call has been recorded, as the device might not be
+  // referred to by any session anymore
+  std::shared_ptr<QDMI_Device_impl_d> jobs_reference;
+  const Call_timer timer(dev, QDMI_DRIVER_CALL_CONTROL_FREE_JOB);
+  // a device that was never loaded cannot have created the job
+  if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) != 0 &&
+      dev->loaded.load(std::memory_order_acquire)) {
+    QDMI_PROBE2(job__free, dev->lib_name.c_str(), job);
+    // recorded before the job is freed, as its handle may be reused
+    Trace({TRACE_EVENT::FREE_JOB, dev, job, 0, timer.start});
+    dev->table.control_free_job(job);
+    {
+      // the device does not invoke the callback anymore
+      const std::lock_guard lock(dev->jobs_mutex);
+      dev->jobs.erase(job);
+    }
+    if (job != nullptr) {
+      jobs_reference = End_job(*dev);
+    }
+  }
+}
+
+int QDMI_Driver_get_call_stats(QDMI_Device dev, QDMI_Driver_Call call,
+                               QDMI_Driver_Call_Stats *stats) {
+  if (dev == nullptr || call >= QDMI_DRIVER_CALL_MAX || stats == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  *stats = QDMI_Driver_Call_Stats{};
+  if (dev->stats == nullptr) {
+    return QDMI_SUCCESS;
+  }
+  for (const auto &shard : *dev->stats) {
+    const auto &counters = shard.calls[call];
+    stats->count += counters.count.load(std::memory_order_relaxed);
+    stats->total_ns += counters.total_ns.load(std::memory_order_relaxed);
+    stats->max_ns = std::max<uint64_t>(
+        stats->max_ns, counters.max_ns.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < QDMI_DRIVER_STATS_BUCKETS; ++i) {
+      stats->buckets[i] +=
+          counters.buckets[i].load(std::memory_order_relaxed);
+    }
+  }
+  return QDMI_SUCCESS;
+}
+
+int QDMI_Driver_get_load_time(QDMI_Device dev, uint64_t *ns) {
+  if (dev == nullptr || ns == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  if (!dev->loaded.load(std::memory_order_acquire)) {
+    return QDMI_ERROR_NOTFOUND;
+  }
+  *ns = static_cast<uint64_t>(dev->load_time.count());
+  return QDMI_SUCCESS;
+}
+
+int QDMI_Driver_dump_stats(const char *path) {
+  if (path == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    std::cerr << "Failed to open statistics file: " << path << "\n";
+    return QDMI_ERROR_FATAL;
+  }
+  // the percentiles are the upper bounds of the histogram buckets
+  file << "device,library,call,count,total_ns,max_ns,p50_ns,p90_ns,p99_ns\n";
+  const auto snapshot = Get_devices();
+  const auto &device_list = snapshot->devices;
+  for (size_t d = 0; d < device_list.size(); ++d) {
+    for (int c = 0; c < QDMI_DRIVER_CALL_MAX; ++c) {
+      QDMI_Driver_Call_Stats stats{};
+      const auto call = static_cast<QDMI_Driver_Call>(c);
+      QDMI_Driver_get_call_stats(device_list[d].get(), call, &stats);
+      if (stats.count == 0) {
+        continue;
+      }
+      file << d << "," << device_list[d]->lib_name << ","
+           << CALL_NAMES[call] << "," << stats.count << "," << stats.total_ns
+           << "," << stats.max_ns;
+      for (const auto quantile : {0.5, 0.9, 0.99}) {
+        const auto rank =
+            static_cast<uint64_t>(std::ceil(quantile * stats.count));
+        uint64_t seen = 0;
+        size_t bucket = 0;
+        while (bucket + 1 < QDMI_DRIVER_STATS_BUCKETS &&
+               (seen += stats.buckets[bucket]) < rank) {
+          ++bucket;
+        }
+        file << "," << (uint64_t{2} << bucket) - 1;
+      }
+      file << "\n";
+    }
+  }
+  return file.good() ? QDMI_SUCCESS : QDMI_ERROR_FATAL;
+}
+
+int QDMI_Driver_start_trace(const char *path) {
+  if (path == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  auto &tracer = Get_tracer();
+  const std::lock_guard lock(tracer.control_mutex);
+  tracer.stop();
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    return QDMI_ERROR_FATAL;
+  }
+  tracer.start(std::move(file));
+  return QDMI_SUCCESS;
+}
+
+int QDMI_Driver_stop_trace() {
+  auto &tracer = Get_tracer();
+  const std::lock_guard lock(tracer.control_mutex);
+  tracer.stop();
+  return QDMI_SUCCESS;
+}
+
+int QDMI_Driver_job_completion_fd(QDMI_Device dev, QDMI_Job job, int *fd) {
+  if (dev == nullptr || job == nullptr || fd == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) == 0) {
+    return QDMI_ERROR_PERMISSIONDENIED;
+  }
+  if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  if (dev->table.control_set_callback == nullptr) {
+    return QDMI_ERROR_NOTSUPPORTED;
+  }
+  const auto record = Find_job(*dev, job);
+  if (record == nullptr) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  const std::lock_guard lock(record->mutex);
+  if (record->read_fd < 0) {
+    if (!Create_completion_fd(*record)) {
+      return QDMI_ERROR_FATAL;
+    }
+    // the job might have finished before the descriptor was requested
+    if (record->done) {
+      Signal_completion_fd(*record);
+    }
+  }
+  *fd = record->read_fd;
+  return QDMI_SUCCESS;
+}
+
+int QDMI_Driver_wait_jobs(const size_t num_jobs, const QDMI_Device *devices,
+                          const QDMI_Job *jobs, QDMI_Driver_Wait_Mode mode,
+                          const size_t timeout, int *completed) {
+  if (num_jobs == 0 || devices == nullptr || jobs == nullptr ||
+      (mode != QDMI_DRIVER_WAIT_ANY && mode != QDMI_DRIVER_WAIT_ALL)) {
+    return QDMI_ERROR_INVALIDARGUMENT;
+  }
+  std::vector<std::shared_ptr<Job_record>> records;
+  records.reserve(num_jobs);
+  for (size_t i = 0; i < num_jobs; ++i) {
+    auto *dev = devices[i];
+    if (dev == nullptr || jobs[i] == nullptr) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    if ((dev->mode & QDMI_DEVICE_MODE_READWRITE) == 0) {
+      return QDMI_ERROR_PERMISSIONDENIED;
+    }
+    if (const auto ret = Ensure_loaded(*dev); ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    if (dev->table.control_set_callback == nullptr) {
+      return QDMI_ERROR_NOTSUPPORTED;
+    }
+    auto record = Find_job(*dev, jobs[i]);
+    if (record == nullptr) {
+      return QDMI_ERROR_INVALIDARGUMENT;
+    }
+    records.emplace_back(std::move(record));
+  }
+
+  // register with every job so that each completion wakes up this thread
+  const auto waiter = std::make_shared<Job_waiter>();
+  for (const auto &record : records) {
+    const std::lock_guard lock(record->mutex);
+    record->waiters.emplace_back(waiter);
+  }
+  const auto deadline = Deadline_after(timeout);
+  auto ret = QDMI_SUCCESS;
+  while (true) {
+    {
+      // completions from now on are caught by the next wait
+      const std::lock_guard lock(waiter->mutex);
+      waiter->signalled = false;
+    }
+    size_t num_done = 0;
+    for (size_t i = 0; i < num_jobs; ++i) {
+      const std::lock_guard lock(records[i]->mutex);
+      if (completed != nullptr) {
+        completed[i] = records[i]->done ? 1 : 0;
+      }
+      num_done += records[i]->done ? 1 : 0;
+    }
+    if (num_done == num_jobs ||
+        (mode == QDMI_DRIVER_WAIT_ANY && num_done > 0)) {
+      break;
+    }
+    std::unique_lock lock(waiter->mutex);
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+      waiter->cv.wait(lock, [&waiter] { return waiter->signalled; });
+    } else if (!waiter->cv.wait_until(lock, deadline, [&waiter] {
+                 return waiter->signalled;
+               })) {
+      ret = QDMI_ERROR_TIMEOUT;
+      break;
+    }
+  }
+  for (const auto &record : records) {
+    const std::lock_guard lock(record->mutex);
+    auto &waiters = record->waiters;
+    waiters.erase(std::remove(waiters.begin(), waiters.end(), waiter),
+                  waiters.end());
   }
+  return ret;
 }
 
 /// @}
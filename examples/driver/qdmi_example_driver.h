@@ -22,15 +22,110 @@ SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #pragma once
 
+#include "qdmi/client.h"
+
 #ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+
 extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
 #endif
 
+// The following disables the clang-tidy warning modernize-use-using.
+// Since this is C code, we cannot use the using keyword.
+// NOLINTBEGIN(modernize-use-using, performance-enum-size)
+
+/// Enum of the modes of @ref QDMI_Driver_wait_jobs.
+enum QDMI_DRIVER_WAIT_MODE_T {
+  /// Return as soon as at least one of the jobs has finished.
+  QDMI_DRIVER_WAIT_ANY,
+  /// Return once all of the jobs have finished.
+  QDMI_DRIVER_WAIT_ALL,
+};
+
+/// Mode of @ref QDMI_Driver_wait_jobs.
+typedef enum QDMI_DRIVER_WAIT_MODE_T QDMI_Driver_Wait_Mode;
+
+/// Enum of the entry points of the driver with call statistics.
+enum QDMI_DRIVER_CALL_T {
+  QDMI_DRIVER_CALL_QUERY_GET_SITES,      ///< @ref QDMI_query_get_sites
+  QDMI_DRIVER_CALL_QUERY_GET_OPERATIONS, ///< @ref QDMI_query_get_operations
+  /// @ref QDMI_query_device_property
+  QDMI_DRIVER_CALL_QUERY_DEVICE_PROPERTY,
+  QDMI_DRIVER_CALL_QUERY_SITE_PROPERTY, ///< @ref QDMI_query_site_property
+  /// @ref QDMI_query_operation_property
+  QDMI_DRIVER_CALL_QUERY_OPERATION_PROPERTY,
+  /// @ref QDMI_query_device_properties
+  QDMI_DRIVER_CALL_QUERY_DEVICE_PROPERTIES,
+  /// @ref QDMI_query_operation_properties
+  QDMI_DRIVER_CALL_QUERY_OPERATION_PROPERTIES,
+  QDMI_DRIVER_CALL_CONTROL_CREATE_JOB,    ///< @ref QDMI_control_create_job
+  QDMI_DRIVER_CALL_CONTROL_SET_PARAMETER, ///< @ref QDMI_control_set_parameter
+  QDMI_DRIVER_CALL_CONTROL_SUBMIT_JOB,    ///< @ref QDMI_control_submit_job
+  QDMI_DRIVER_CALL_CONTROL_CANCEL,        ///< @ref QDMI_control_cancel
+  QDMI_DRIVER_CALL_CONTROL_CHECK,         ///< @ref QDMI_control_check
+  QDMI_DRIVER_CALL_CONTROL_WAIT,          ///< @ref QDMI_control_wait
+  QDMI_DRIVER_CALL_CONTROL_WAIT_FOR,      ///< @ref QDMI_control_wait_for
+  QDMI_DRIVER_CALL_CONTROL_GET_DATA,      ///< @ref QDMI_control_get_data
+  QDMI_DRIVER_CALL_CONTROL_FREE_JOB,      ///< @ref QDMI_control_free_job
+  /// The number of entry points.
+  QDMI_DRIVER_CALL_MAX,
+};
+
+/// Entry point of the driver with call statistics.
+typedef enum QDMI_DRIVER_CALL_T QDMI_Driver_Call;
+
+/// The number of latency buckets of @ref QDMI_Driver_Call_Stats.
+#define QDMI_DRIVER_STATS_BUCKETS 40
+
+/**
+ * @brief The statistics of the calls to one entry point of one device.
+ */
+typedef struct QDMI_Driver_Call_Stats_d {
+  /// The number of calls.
+  uint64_t count;
+  /// The accumulated latency of all calls in nanoseconds.
+  uint64_t total_ns;
+  /// The maximum latency of a single call in nanoseconds.
+  uint64_t max_ns;
+  /**
+   * @brief The latency histogram.
+   * @details Bucket `i` counts the calls with a latency in `[2^i, 2^(i+1))`
+   * nanoseconds. The first bucket also counts calls below one nanosecond, and
+   * the last one all calls above its lower bound.
+   */
+  uint64_t buckets[QDMI_DRIVER_STATS_BUCKETS];
+} QDMI_Driver_Call_Stats;
+
+// NOLINTEND(modernize-use-using, performance-enum-size)
+
+/// Timeout value of @ref QDMI_Driver_wait_jobs to wait without a time limit.
+#define QDMI_DRIVER_WAIT_INFINITE SIZE_MAX
+
 /**
  * @brief Initialize the QDMI driver.
  * @details This function should be called before any other QDMI function. It
  * performs any necessary initialization of the driver so that a client can
  * allocate sessions (@ref QDMI_Session) and access devices (@ref QDMI_Device).
+ *
+ * The devices are read from the configuration file given by the environment
+ * variable `QDMI_CONF` (default: `qdmi.conf`). If `QDMI_DRIVER_LOAD_THREADS`
+ * is set to a number greater than one, the devices are opened and initialized
+ * concurrently on up to that many threads, and `0` uses one thread per
+ * hardware thread. The order of the devices always follows the configuration
+ * file. Devices marked as `lazy` in the configuration file are only loaded and
+ * initialized when they are used for the first time.
+ *
+ * If `QDMI_DRIVER_RELOAD` is set to any value other than `0`, the driver
+ * watches the configuration file (on Linux) and applies its changes while
+ * running: devices of new entries are opened in the background, and devices of
+ * removed entries are no longer handed out to sessions. Sessions that already
+ * obtained a removed device can keep using it, but cannot create new jobs on
+ * it (@ref QDMI_ERROR_NOTFOUND); the device is finalized once its last job has
+ * been freed.
  * @note This function should be called only once.
  * @return @ref QDMI_SUCCESS if the driver was initialized successfully.
  * @return @ref QDMI_ERROR_FATAL if an unexpected error occurred.
@@ -48,6 +143,149 @@ int QDMI_Driver_init();
  */
 int QDMI_Driver_shutdown();
 
+/**
+ * @brief Get a descriptor that becomes readable once a job has finished.
+ * @details The descriptor becomes readable when the job reaches the status
+ * @ref QDMI_JOB_STATUS_DONE or @ref QDMI_JOB_STATUS_CANCELLED and stays
+ * readable until the job is freed. It can be watched with `poll`, `select`, or
+ * `epoll` together with the descriptors of other jobs, so that a single thread
+ * can wait for any number of jobs. On Linux, the descriptor is an eventfd,
+ * otherwise the read end of a pipe. The descriptor is owned by the driver and
+ * closed by @ref QDMI_control_free_job; the client must neither read from nor
+ * close it. Repeated calls for the same job return the same descriptor.
+ * @param dev The device the job was created on.
+ * @param job The job to watch.
+ * @param fd A pointer to store the descriptor in.
+ * @return @ref QDMI_SUCCESS if the descriptor was stored in @p fd.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if any argument is `NULL` or the job
+ * was not created through this driver.
+ * @return @ref QDMI_ERROR_PERMISSIONDENIED if the device does not allow using
+ * the control interface.
+ * @return @ref QDMI_ERROR_NOTSUPPORTED if the device does not implement
+ * @ref QDMI_control_set_callback_dev.
+ * @return @ref QDMI_ERROR_FATAL if the descriptor could not be created.
+ */
+int QDMI_Driver_job_completion_fd(QDMI_Device dev, QDMI_Job job, int *fd);
+
+/**
+ * @brief Get the call statistics of an entry point of a device.
+ * @details If the environment variable `QDMI_DRIVER_STATS` is set to any value
+ * other than `0` when @ref QDMI_Driver_init is called, the driver counts the
+ * calls to each of its query and control functions per device and records
+ * their latencies, including the time spent in the device, in a logarithmic
+ * histogram.
+ * Recording is cheap, as the counters of a device are split into shards that
+ * are merged by this function. Otherwise, all statistics are zero.
+ * @param dev The device to get the statistics for.
+ * @param call The entry point to get the statistics for.
+ * @param stats A pointer to store the statistics in.
+ * @return @ref QDMI_SUCCESS if the statistics were stored in @p stats.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if @p dev or @p stats is `NULL` or
+ * @p call is invalid.
+ */
+int QDMI_Driver_get_call_stats(QDMI_Device dev, QDMI_Driver_Call call,
+                               QDMI_Driver_Call_Stats *stats);
+
+/**
+ * @brief Get the time it took to load a device.
+ * @details The load time covers opening the device library, looking up its
+ * symbols, and initializing the device. Devices marked as `lazy` in the
+ * configuration file only have a load time once they have been used.
+ * @param dev The device to get the load time for.
+ * @param ns A pointer to store the load time in nanoseconds in.
+ * @return @ref QDMI_SUCCESS if the load time was stored in @p ns.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if @p dev or @p ns is `NULL`.
+ * @return @ref QDMI_ERROR_NOTFOUND if the device has not been loaded yet.
+ */
+int QDMI_Driver_get_load_time(QDMI_Device dev, uint64_t *ns);
+
+/**
+ * @brief Write the call statistics of all devices to a file.
+ * @details The file is written in CSV format with one line per device and
+ * entry point that was called at least once. Besides the number of calls and
+ * the total and maximum latency, the 50th, 90th, and 99th percentiles are
+ * given as the upper bounds of the histogram buckets they fall into. If the
+ * statistics are recorded and the environment variable
+ * `QDMI_DRIVER_STATS_FILE` is set, they are also written to the file it names
+ * by @ref QDMI_Driver_shutdown.
+ * @param path The path of the file to write.
+ * @return @ref QDMI_SUCCESS if the file was written.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if @p path is `NULL`.
+ * @return @ref QDMI_ERROR_FATAL if the file could not be written.
+ */
+int QDMI_Driver_dump_stats(const char *path);
+
+/**
+ * @brief Start writing a trace of the job timelines to a file.
+ * @details The trace is written in the Trace Event Format of Chrome and can be
+ * opened with Perfetto or `chrome://tracing`. Every device gets a track with
+ * one lane per concurrently existing job. A job is shown as a slice from its
+ * creation to its release, divided into the phases `created`, `submitted`,
+ * `running`, and `done` (or `cancelled`), with a marker for every retrieval of
+ * its data. The phases are derived from the calls made through the driver and
+ * from the completion callbacks of the device; `running` only shows up if it
+ * was observed by @ref QDMI_control_check. Each session gets a track, too,
+ * with flow arrows to the jobs created by threads that obtained their devices
+ * from that session last, and a track per client thread shows the calls that
+ * create, submit, wait for, read, or free jobs.
+ *
+ * Recording an event only copies it into a lock-free buffer; a background
+ * thread converts the events and writes them to the file. Events are dropped
+ * rather than blocking the caller if the buffer is full; their number is
+ * stored in the `otherData` section of the trace. If the environment variable
+ * `QDMI_TRACE` is set, @ref QDMI_Driver_init starts a trace to the file it
+ * names. A trace that is already being written is finished first.
+ * @param path The path of the file to write.
+ * @return @ref QDMI_SUCCESS if the trace was started.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if @p path is `NULL`.
+ * @return @ref QDMI_ERROR_FATAL if the file could not be opened.
+ */
+int QDMI_Driver_start_trace(const char *path);
+
+/**
+ * @brief Finish the trace started by @ref QDMI_Driver_start_trace.
+ * @details All recorded events are written, jobs and sessions that were not
+ * freed yet are closed at the time of the last event, and the file is closed.
+ * Does nothing if no trace is being written. @ref QDMI_Driver_shutdown
+ * finishes the trace as well.
+ * @return @ref QDMI_SUCCESS.
+ */
+int QDMI_Driver_stop_trace();
+
+/**
+ * @brief Wait for any or all of several jobs, possibly on different devices.
+ * @details The i-th job is given by @p devices[i] and @p jobs[i]. A job counts
+ * as finished once it reaches the status @ref QDMI_JOB_STATUS_DONE or
+ * @ref QDMI_JOB_STATUS_CANCELLED. The calling thread sleeps until it is woken
+ * up by the completion of one of the jobs; the jobs are not polled.
+ * Whether the function returns successfully or times out, @p completed[i] is
+ * set to `1` if the i-th job has finished and to `0` otherwise. A timeout does
+ * not affect the jobs.
+ * @param num_jobs The number of jobs, must be greater than zero.
+ * @param devices The devices the jobs were created on.
+ * @param jobs The jobs to wait for.
+ * @param mode Whether to wait for any or for all of the jobs.
+ * @param timeout The maximum time to wait in milliseconds, as for
+ * @ref QDMI_control_wait_for. @ref QDMI_DRIVER_WAIT_INFINITE, as well as any
+ * timeout too long to be represented by the clock of the driver, waits without
+ * a time limit.
+ * @param completed An array of @p num_jobs entries to store which of the jobs
+ * have finished, or `NULL`.
+ * @return @ref QDMI_SUCCESS if any (respectively all) of the jobs have
+ * finished.
+ * @return @ref QDMI_ERROR_TIMEOUT if the timeout expired before.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if @p num_jobs is zero, @p devices,
+ * @p jobs, or any of their entries is `NULL`, @p mode is invalid, or a job was
+ * not created through this driver.
+ * @return @ref QDMI_ERROR_PERMISSIONDENIED if a device does not allow using
+ * the control interface.
+ * @return @ref QDMI_ERROR_NOTSUPPORTED if a device does not implement
+ * @ref QDMI_control_set_callback_dev.
+ */
+int QDMI_Driver_wait_jobs(size_t num_jobs, const QDMI_Device *devices,
+                          const QDMI_Job *jobs, QDMI_Driver_Wait_Mode mode,
+                          size_t timeout, int *completed);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
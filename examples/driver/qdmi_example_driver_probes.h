@@ -0,0 +1,64 @@
+/*------------------------------------------------------------------------------
+Copyright 2024 Munich Quantum Software Stack Project
+
+Licensed under the Apache License, Version 2.0 with LLVM Exceptions (the
+"License"); you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+https://github.com/Munich-Quantum-Software-Stack/QDMI/blob/develop/LICENSE
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+License for the specific language governing permissions and limitations under
+the License.
+
+SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+------------------------------------------------------------------------------*/
+
+/** @file
+ * @brief Static tracepoints of the example driver.
+ * @details The driver marks the phases of the job lifecycle with USDT probes
+ * of the provider `qdmi`, which tools like `perf`, `bpftrace`, or SystemTap
+ * can attach to at runtime. A probe compiles to a single `nop` instruction, and
+ * its arguments are only materialized in registers or memory, so an inactive
+ * probe costs virtually nothing. If `<sys/sdt.h>` is not available, or if
+ * `QDMI_DISABLE_PROBES` is defined, the probes expand to nothing.
+ *
+ * The following probes are defined; the first two arguments are always the
+ * library name of the device (`const char *`) and the job (`QDMI_Job`):
+ * - `job__create(device, job, program_size, result)`
+ * - `job__set__parameter(device, job, param, value_size, result)`
+ * - `job__submit(device, job, result)`
+ * - `job__check(device, job, status, result)`
+ * - `job__wait__begin(device, job, timeout_ms)`
+ * - `job__wait__end(device, job, result)`
+ * - `job__get__data(device, job, result_kind, data_size, result)`
+ * - `job__free(device, job)`
+ *
+ * The timeout of `job__wait__begin` is `-1` for @ref QDMI_control_wait.
+ */
+
+#pragma once
+
+#if !defined(QDMI_DISABLE_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define QDMI_HAVE_PROBES
+#endif
+#endif
+
+#ifdef QDMI_HAVE_PROBES
+#define QDMI_PROBE2(name, a1, a2) DTRACE_PROBE2(qdmi, name, a1, a2)
+#define QDMI_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(qdmi, name, a1, a2, a3)
+#define QDMI_PROBE4(name, a1, a2, a3, a4)                                      \
+  DTRACE_PROBE4(qdmi, name, a1, a2, a3, a4)
+#define QDMI_PROBE5(name, a1, a2, a3, a4, a5)                                  \
+  DTRACE_PROBE5(qdmi, name, a1, a2, a3, a4, a5)
+#else
+// the arguments are not evaluated if probes are not available
+#define QDMI_PROBE2(name, a1, a2)
+#define QDMI_PROBE3(name, a1, a2, a3)
+#define QDMI_PROBE4(name, a1, a2, a3, a4)
+#define QDMI_PROBE5(name, a1, a2, a3, a4, a5)
+#endif
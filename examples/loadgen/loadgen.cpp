@@ -0,0 +1,595 @@
+/*------------------------------------------------------------------------------
+Copyright 2024 Munich Quantum Software Stack Project
+
+Licensed under the Apache License, Version 2.0 with LLVM Exceptions (the
+"License"); you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+https://github.com/Munich-Quantum-Software-Stack/QDMI/blob/develop/LICENSE
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+License for the specific language governing permissions and limitations under
+the License.
+
+SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+------------------------------------------------------------------------------*/
+
+/** @file
+ * @brief A load generator stressing the example driver and the devices it
+ * loads from many threads at once.
+ * @details The devices are read from the configuration file given by the
+ * environment variable `QDMI_CONF`, see @ref QDMI_Driver_init. The tool opens
+ * a number of sessions and lets a number of threads drive a weighted mix of
+ * property queries and job lifecycles against the devices of these sessions,
+ * optionally paced to a target rate. Afterwards, it reports the throughput,
+ * the latency percentiles, and the number of errors per operation. Finally, it
+ * checks that every device is idle again once all jobs have been freed.
+ *
+ * Run `qdmi_loadgen --help` for the available options. The tool exits with a
+ * non-zero status if any operation failed.
+ */
+
+#include "qdmi/client.h"
+#include "qdmi_example_driver.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+/// The operations for which the latency is recorded.
+enum OPERATION : uint8_t {
+  QUERY,
+  CREATE_JOB,
+  SET_PARAMETER,
+  SUBMIT_JOB,
+  WAIT,
+  GET_DATA,
+  CANCEL,
+  FREE_JOB,
+  JOB,
+  SESSION,
+  NUM_OPERATIONS
+};
+
+/// The names of the operations as printed in the report.
+constexpr std::array<const char *, NUM_OPERATIONS> OPERATION_NAMES = {
+    "query",    "create_job", "set_parameter", "submit_job", "wait",
+    "get_data", "cancel",     "free_job",      "job",        "session"};
+
+/// The actions a thread chooses from in every iteration.
+enum ACTION : uint8_t {
+  /// Query a property of a device.
+  QUERY_DEVICE,
+  /// Create, submit, wait for, read, and free a job.
+  RUN_JOB,
+  /// Create, submit, cancel, and free a job.
+  CANCEL_JOB,
+  /// Create and submit a job, then free it without waiting for it.
+  ABANDON_JOB,
+  /// Allocate a new session, retrieve its devices, and free it again.
+  OPEN_SESSION,
+  NUM_ACTIONS
+};
+
+/// The names of the actions as given in the `--mix` option.
+constexpr std::array<const char *, NUM_ACTIONS> ACTION_NAMES = {
+    "query", "job", "cancel", "abandon", "session"};
+
+/// The token set for every session opened by the tool.
+constexpr const char *TOKEN = "loadgen_token";
+
+/// The program submitted for every job.
+constexpr const char *PROGRAM = "OPENQASM 2.0;\n"
+                                "include \"qelib1.inc\";\n"
+                                "qreg q[2];\n"
+                                "creg c[2];\n"
+                                "h q[0];\n"
+                                "cx q[0], q[1];\n"
+                                "measure q -> c;\n";
+
+/// The configuration of a run.
+struct Options {
+  size_t num_threads = 4;
+  size_t num_sessions = 4;
+  /// The duration of the run in seconds.
+  double duration = 5.0;
+  /// The target number of actions per second over all threads, zero runs the
+  /// threads as fast as possible.
+  double rate = 0.0;
+  size_t num_shots = 100;
+  /// The relative frequency of each action.
+  std::array<size_t, NUM_ACTIONS> weights = {8, 2, 1, 1, 1};
+};
+
+/// The measurements collected by a single thread.
+struct Thread_stats {
+  /// The latencies of all successful calls in nanoseconds.
+  std::array<std::vector<uint64_t>, NUM_OPERATIONS> latencies;
+  std::array<size_t, NUM_OPERATIONS> errors{};
+  size_t num_actions = 0;
+};
+
+/// A session opened before the threads are started.
+struct Session {
+  QDMI_Session session = nullptr;
+  std::vector<QDMI_Device> devices;
+};
+
+void Print_usage(const char *program) {
+  std::printf(
+      "Usage: %s [options]\n"
+      "  --threads=M      number of threads generating load (default 4)\n"
+      "  --sessions=N     number of sessions shared by the threads "
+      "(default 4)\n"
+      "  --duration=S     duration of the run in seconds (default 5)\n"
+      "  --rate=R         target actions per second over all threads,\n"
+      "                   0 for unbounded (default 0)\n"
+      "  --shots=K        number of shots of every job (default 100)\n"
+      "  --mix=LIST       relative frequency of the actions, e.g.\n"
+      "                   query=8,job=2,cancel=1,abandon=1,session=1\n"
+      "The devices are read from the file given by QDMI_CONF.\n",
+      program);
+}
+
+/**
+ * @brief Parse the value of the `--mix` option.
+ * @param value the comma-separated list of `action=weight` pairs.
+ * @param weights the weights to update.
+ * @return `true` if the list is valid, `false` otherwise.
+ */
+bool Parse_mix(const std::string &value,
+               std::array<size_t, NUM_ACTIONS> &weights) {
+  size_t begin = 0;
+  while (begin < value.size()) {
+    auto end = value.find(',', begin);
+    if (end == std::string::npos) {
+      end = value.size();
+    }
+    const auto entry = value.substr(begin, end - begin);
+    const auto eq = entry.find('=');
+    if (eq == std::string::npos) {
+      return false;
+    }
+    const auto *it = std::find(ACTION_NAMES.begin(), ACTION_NAMES.end(),
+                               entry.substr(0, eq));
+    if (it == ACTION_NAMES.end()) {
+      return false;
+    }
+    weights[static_cast<size_t>(it - ACTION_NAMES.begin())] =
+        std::stoul(entry.substr(eq + 1));
+    begin = end + 1;
+  }
+  return std::any_of(weights.begin(), weights.end(),
+                     [](const size_t w) { return w > 0; });
+}
+
+/**
+ * @brief Parse the command line.
+ * @param argc the number of arguments.
+ * @param argv the arguments.
+ * @param options the options to fill.
+ * @return `true` if the command line is valid, `false` otherwise.
+ */
+bool Parse_options(const int argc, char **argv, Options &options) {
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      const auto eq = arg.find('=');
+      if (eq == std::string::npos) {
+        return false;
+      }
+      const auto name = arg.substr(0, eq);
+      const auto value = arg.substr(eq + 1);
+      if (name == "--threads") {
+        options.num_threads = std::stoul(value);
+      } else if (name == "--sessions") {
+        options.num_sessions = std::stoul(value);
+      } else if (name == "--duration") {
+        options.duration = std::stod(value);
+      } else if (name == "--rate") {
+        options.rate = std::stod(value);
+      } else if (name == "--shots") {
+        options.num_shots = std::stoul(value);
+      } else if (name == "--mix") {
+        options.weights.fill(0);
+        if (!Parse_mix(value, options.weights)) {
+          return false;
+        }
+      } else {
+        return false;
+      }
+    }
+  } catch (const std::exception &) {
+    return false;
+  }
+  return options.num_threads > 0 && options.num_sessions > 0 &&
+         options.duration > 0 && options.rate >= 0;
+}
+
+/**
+ * @brief Allocate a session and retrieve all of its devices.
+ * @param session the session to fill.
+ * @return @ref QDMI_SUCCESS on success, an error code otherwise.
+ */
+int Open_session(Session &session) {
+  int ret = QDMI_session_alloc(&session.session);
+  if (ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  const std::string token = TOKEN;
+  ret = QDMI_session_set_parameter(session.session,
+                                   QDMI_SESSION_PARAMETER_TOKEN,
+                                   token.length() + 1, token.c_str());
+  if (ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  size_t num_devices = 0;
+  ret = QDMI_session_get_devices(session.session, 0, nullptr, &num_devices);
+  if (ret != QDMI_SUCCESS) {
+    return ret;
+  }
+  session.devices.resize(num_devices);
+  return QDMI_session_get_devices(session.session, num_devices,
+                                  session.devices.data(), nullptr);
+}
+
+/// Generates load from a single thread and records its measurements.
+class LoadThread {
+public:
+  LoadThread(const Options &opts, const std::vector<Session> &open_sessions,
+             Thread_stats &thread_stats, const size_t index)
+      : options(opts), sessions(open_sessions), stats(thread_stats),
+        gen(std::random_device{}()),
+        action_dis(opts.weights.begin(), opts.weights.end()),
+        next_session(index) {}
+
+  /**
+   * @brief Run actions until the end of the run is reached.
+   * @param end the end of the run.
+   */
+  void run(const std::chrono::steady_clock::time_point end) {
+    auto next = std::chrono::steady_clock::now();
+    const auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.rate > 0
+                                          ? static_cast<double>(
+                                                options.num_threads) /
+                                                options.rate
+                                          : 0.0));
+    while (Clock::now() < end) {
+      if (options.rate > 0) {
+        std::this_thread::sleep_until(next);
+        next += interval;
+      }
+      run_action(static_cast<ACTION>(action_dis(gen)));
+      ++stats.num_actions;
+    }
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  const Options &options;
+  const std::vector<Session> &sessions;
+  Thread_stats &stats;
+  std::mt19937 gen;
+  std::discrete_distribution<size_t> action_dis;
+  size_t next_session;
+
+  /**
+   * @brief Time a call and record its latency or its failure.
+   * @param operation the operation the call belongs to.
+   * @param call the call to time, returning a QDMI status code.
+   * @return the status code returned by the call.
+   */
+  template <class F> int timed(const OPERATION operation, F &&call) {
+    const auto start = Clock::now();
+    const int ret = call();
+    record(operation, ret, Clock::now() - start);
+    return ret;
+  }
+
+  /**
+   * @brief Record the latency of a successful call or the failure of a call.
+   * @param operation the operation the call belongs to.
+   * @param ret the status code returned by the call.
+   * @param latency the time the call took.
+   */
+  void record(const OPERATION operation, const int ret,
+              const Clock::duration latency) {
+    if (ret == QDMI_SUCCESS) {
+      stats.latencies[operation].emplace_back(static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(latency)
+              .count()));
+    } else {
+      ++stats.errors[operation];
+    }
+  }
+
+  /// Pick the next device, cycling through the sessions.
+  QDMI_Device next_device() {
+    const auto &session = sessions[next_session++ % sessions.size()];
+    if (session.devices.empty()) {
+      return nullptr;
+    }
+    std::uniform_int_distribution<size_t> dis(0, session.devices.size() - 1);
+    return session.devices[dis(gen)];
+  }
+
+  void run_action(const ACTION action) {
+    auto *device = next_device();
+    switch (action) {
+    case QUERY_DEVICE:
+      query_device(device);
+      break;
+    case RUN_JOB:
+      timed(JOB, [&] { return run_job(device, action); });
+      break;
+    case CANCEL_JOB:
+    case ABANDON_JOB:
+      run_job(device, action);
+      break;
+    case OPEN_SESSION:
+      timed(SESSION, [] {
+        Session session;
+        const int ret = Open_session(session);
+        QDMI_session_free(session.session);
+        return ret;
+      });
+      break;
+    default:
+      break;
+    }
+  }
+
+  void query_device(QDMI_Device device) {
+    std::uniform_int_distribution<int> dis(0, 2);
+    switch (dis(gen)) {
+    case 0:
+      timed(QUERY, [device] {
+        size_t num_qubits = 0;
+        return QDMI_query_device_property(device,
+                                          QDMI_DEVICE_PROPERTY_QUBITSNUM,
+                                          sizeof(size_t), &num_qubits, nullptr);
+      });
+      break;
+    case 1:
+      timed(QUERY, [device] {
+        QDMI_Device_Status status = QDMI_DEVICE_STATUS_OFFLINE;
+        return QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_STATUS,
+                                          sizeof(QDMI_Device_Status), &status,
+                                          nullptr);
+      });
+      break;
+    default:
+      timed(QUERY, [device] {
+        size_t size = 0;
+        int ret = QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_NAME,
+                                             0, nullptr, &size);
+        if (ret != QDMI_SUCCESS) {
+          return ret;
+        }
+        std::string name(size, '\0');
+        ret = QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_NAME,
+                                         size, name.data(), nullptr);
+        return ret;
+      });
+      break;
+    }
+  }
+
+  /**
+   * @brief Run the lifecycle of a single job.
+   * @param device the device to submit the job to.
+   * @param action the kind of lifecycle to run.
+   * @return @ref QDMI_SUCCESS if all calls succeeded, the first error code
+   * otherwise.
+   */
+  int run_job(QDMI_Device device, const ACTION action) {
+    QDMI_Job job = nullptr;
+    int ret = timed(CREATE_JOB, [&] {
+      return QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                     std::char_traits<char>::length(PROGRAM) +
+                                         1,
+                                     PROGRAM, &job);
+    });
+    if (ret != QDMI_SUCCESS) {
+      return ret;
+    }
+    ret = timed(SET_PARAMETER, [&] {
+      return QDMI_control_set_parameter(device, job,
+                                        QDMI_JOB_PARAMETER_SHOTS_NUM,
+                                        sizeof(size_t), &options.num_shots);
+    });
+    if (ret == QDMI_SUCCESS) {
+      ret = timed(SUBMIT_JOB,
+                  [&] { return QDMI_control_submit_job(device, job); });
+    }
+    if (ret == QDMI_SUCCESS && action == RUN_JOB) {
+      ret = timed(WAIT, [&] { return QDMI_control_wait(device, job); });
+      if (ret == QDMI_SUCCESS) {
+        ret = timed(GET_DATA, [&] {
+          size_t size = 0;
+          int res = QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS,
+                                          0, nullptr, &size);
+          if (res != QDMI_SUCCESS) {
+            return res;
+          }
+          std::string shots(size, '\0');
+          res = QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS,
+                                      size, shots.data(), nullptr);
+          return res;
+        });
+      }
+    } else if (ret == QDMI_SUCCESS && action == CANCEL_JOB) {
+      const auto start = Clock::now();
+      ret = QDMI_control_cancel(device, job);
+      const auto latency = Clock::now() - start;
+      // the job may have finished already, which is not an error
+      QDMI_Job_Status status = QDMI_JOB_STATUS_CREATED;
+      if (ret != QDMI_SUCCESS &&
+          QDMI_control_check(device, job, &status) == QDMI_SUCCESS &&
+          status == QDMI_JOB_STATUS_DONE) {
+        ret = QDMI_SUCCESS;
+      }
+      record(CANCEL, ret, latency);
+    }
+    timed(FREE_JOB, [&] {
+      QDMI_control_free_job(device, job);
+      return QDMI_SUCCESS;
+    });
+    return ret;
+  }
+};
+
+/**
+ * @brief Compute a percentile of sorted latencies.
+ * @param sorted the latencies in ascending order, must not be empty.
+ * @param q the percentile as a fraction in (0, 1].
+ * @return the latency in microseconds.
+ */
+double Percentile(const std::vector<uint64_t> &sorted, const double q) {
+  const auto rank = static_cast<size_t>(
+      std::ceil(q * static_cast<double>(sorted.size())));
+  return static_cast<double>(sorted[std::clamp<size_t>(rank, 1, sorted.size()) -
+                                    1]) /
+         1e3;
+}
+
+/**
+ * @brief Print the merged measurements of all threads.
+ * @param options the configuration of the run.
+ * @param stats the measurements of all threads.
+ * @param elapsed the wall-clock time of the run in seconds.
+ * @return the total number of errors.
+ */
+size_t Print_report(const Options &options,
+                    const std::vector<Thread_stats> &stats,
+                    const double elapsed) {
+  size_t num_actions = 0;
+  for (const auto &s : stats) {
+    num_actions += s.num_actions;
+  }
+  std::printf("threads %zu, sessions %zu, %.2f s, %zu actions (%.1f/s)\n",
+              options.num_threads, options.num_sessions, elapsed, num_actions,
+              static_cast<double>(num_actions) / elapsed);
+  std::printf("%-14s %10s %8s %12s %10s %10s %10s\n", "operation", "count",
+              "errors", "ops/s", "p50[us]", "p99[us]", "p999[us]");
+  size_t total_errors = 0;
+  for (size_t op = 0; op < NUM_OPERATIONS; ++op) {
+    std::vector<uint64_t> latencies;
+    size_t errors = 0;
+    for (const auto &s : stats) {
+      latencies.insert(latencies.end(), s.latencies[op].begin(),
+                       s.latencies[op].end());
+      errors += s.errors[op];
+    }
+    total_errors += errors;
+    if (latencies.empty() && errors == 0) {
+      continue;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%-14s %10zu %8zu %12.1f", OPERATION_NAMES[op],
+                latencies.size(), errors,
+                static_cast<double>(latencies.size()) / elapsed);
+    if (latencies.empty()) {
+      std::printf(" %10s %10s %10s\n", "-", "-", "-");
+    } else {
+      std::printf(" %10.2f %10.2f %10.2f\n", Percentile(latencies, 0.5),
+                  Percentile(latencies, 0.99), Percentile(latencies, 0.999));
+    }
+  }
+  return total_errors;
+}
+
+/**
+ * @brief Check that all devices are idle once no job is active anymore.
+ * @param sessions the sessions whose devices are checked.
+ * @return the number of devices that are not idle.
+ */
+size_t Check_idle(const std::vector<Session> &sessions) {
+  size_t num_busy = 0;
+  for (const auto &session : sessions) {
+    for (auto *device : session.devices) {
+      QDMI_Device_Status status = QDMI_DEVICE_STATUS_OFFLINE;
+      if (QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_STATUS,
+                                     sizeof(QDMI_Device_Status), &status,
+                                     nullptr) != QDMI_SUCCESS ||
+          status != QDMI_DEVICE_STATUS_IDLE) {
+        ++num_busy;
+      }
+    }
+  }
+  if (num_busy > 0) {
+    std::printf("%zu device(s) not idle after all jobs were freed\n",
+                num_busy);
+  }
+  return num_busy;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (argc == 2 && std::string(argv[1]) == "--help") {
+    Print_usage(argv[0]);
+    return EXIT_SUCCESS;
+  }
+  if (!Parse_options(argc, argv, options)) {
+    Print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (QDMI_Driver_init() != QDMI_SUCCESS) {
+    std::fprintf(stderr, "Failed to initialize the driver.\n");
+    return EXIT_FAILURE;
+  }
+  std::vector<Session> sessions(options.num_sessions);
+  for (auto &session : sessions) {
+    if (Open_session(session) != QDMI_SUCCESS || session.devices.empty()) {
+      std::fprintf(stderr, "Failed to open a session with devices.\n");
+      for (const auto &s : sessions) {
+        QDMI_session_free(s.session);
+      }
+      QDMI_Driver_shutdown();
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<Thread_stats> stats(options.num_threads);
+  std::vector<std::thread> threads;
+  threads.reserve(options.num_threads);
+  const auto start = std::chrono::steady_clock::now();
+  const auto end =
+      start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(options.duration));
+  for (size_t i = 0; i < options.num_threads; ++i) {
+    threads.emplace_back([&, i] {
+      LoadThread(options, sessions, stats[i], i).run(end);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const auto elapsed = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+  size_t num_errors = Print_report(options, stats, elapsed);
+  num_errors += Check_idle(sessions);
+  for (const auto &session : sessions) {
+    QDMI_session_free(session.session);
+  }
+  QDMI_Driver_shutdown();
+  return num_errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
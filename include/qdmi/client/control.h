@@ -138,6 +138,22 @@ int QDMI_control_check(QDMI_Device dev, QDMI_Job job, QDMI_Job_Status *status);
  */
 int QDMI_control_wait(QDMI_Device dev, QDMI_Job job);
 
+/**
+ * @brief Wait for a job to finish, but at most for a given time.
+ * @details This function blocks until the job has either finished or has been
+ * cancelled, or until the timeout has expired. An expired timeout does not
+ * affect the job; it keeps running and can be waited for again.
+ * @param[in] dev The device to wait on.
+ * @param[in] job The job to wait for.
+ * @param[in] timeout The maximum time to wait in milliseconds.
+ * @return @ref QDMI_SUCCESS if the job is finished or cancelled.
+ * @return @ref QDMI_ERROR_TIMEOUT if the timeout expired before.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if the job does not exist.
+ * @return @ref QDMI_ERROR_NOTSUPPORTED if the device does not support waiting
+ * with a timeout.
+ */
+int QDMI_control_wait_for(QDMI_Device dev, QDMI_Job job, size_t timeout);
+
 /**
  * @brief Retrieve the results of a job.
  * @details The results of a job can vary
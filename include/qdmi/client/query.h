@@ -208,6 +208,62 @@ int QDMI_query_operation_property(QDMI_Device device, QDMI_Operation operation,
                                   QDMI_Operation_Property prop, size_t size,
                                   void *value, size_t *size_ret);
 
+/**
+ * @brief Query several device properties at once.
+ * @details This function behaves as if @ref QDMI_query_device_property was
+ * called for every entry of @p queries, with the difference that all entries
+ * are answered in a single call. The result of every entry is reported in its
+ * own @ref QDMI_Device_Property_Query_d::status, such that a failing entry
+ * does not affect the others.
+ * @param[in] device refers to the device returned by @ref
+ * QDMI_session_get_devices.
+ * @param[in] num_queries is the number of entries in @p queries.
+ * @param[in,out] queries is the list of properties to query.
+ * @return @ref QDMI_SUCCESS if all entries were processed. The individual
+ * results are reported in the entries.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if @p device is an invalid device or
+ * if @p queries is @c NULL while @p num_queries is not zero.
+ * @return @ref QDMI_ERROR_FATAL if an unexpected error occurred.
+ */
+int QDMI_query_device_properties(QDMI_Device device, size_t num_queries,
+                                 QDMI_Device_Property_Query *queries);
+
+/**
+ * @brief Query an operation property for several tuples of sites at once.
+ * @details This function behaves as if @ref QDMI_query_operation_property
+ * was called for every tuple of sites, with the difference that all tuples are
+ * answered in a single call. The tuples are stored consecutively in @p sites
+ * and the values are stored consecutively in @p values, where every value
+ * occupies @p size bytes. For example, the fidelities of a two-qubit operation
+ * for all edges of the coupling map can be queried with a single call.
+ * @param[in] device refers to the device returned by @ref
+ * QDMI_session_get_devices.
+ * @param[in] operation is the operation for which the property is queried.
+ * @param[in] num_tuples is the number of tuples of sites.
+ * @param[in] tuple_size is the number of sites in every tuple.
+ * @param[in] sites is the list of @p num_tuples times @p tuple_size sites.
+ * @param[in] prop is the property to query.
+ * @param[in] size is the size in bytes reserved for every value in @p values.
+ * @param[out] values is a pointer to @p num_tuples times @p size bytes of
+ * memory where the values are written to.
+ * @param[out] status is a pointer to @p num_tuples status codes, one for every
+ * tuple. A tuple for which the property cannot be provided does not affect the
+ * others.
+ * @return @ref QDMI_SUCCESS if all tuples were processed. The individual
+ * results are reported in @p status.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if @p device is an invalid device, if
+ * @p operation is an invalid operation, if @p prop is not one of the defined
+ * values, or if @p num_tuples is not zero and @p tuple_size is zero or any of
+ * @p sites, @p values, and @p status is @c NULL.
+ * @return @ref QDMI_ERROR_FATAL if an unexpected error occurred.
+ */
+int QDMI_query_operation_properties(QDMI_Device device,
+                                    QDMI_Operation operation,
+                                    size_t num_tuples, size_t tuple_size,
+                                    const QDMI_Site *sites,
+                                    QDMI_Operation_Property prop, size_t size,
+                                    void *values, int *status);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
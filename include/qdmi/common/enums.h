@@ -65,6 +65,17 @@ enum QDMI_DEVICE_PROPERTY_T {
   QDMI_DEVICE_PROPERTY_CUSTOM_4,
   /// @see QDMI_DEVICE_PROPERTY_CUSTOM_1
   QDMI_DEVICE_PROPERTY_CUSTOM_5,
+  /**
+   * @brief `size_t` The calibration epoch of the device.
+   * @details The epoch is increased whenever calibration-dependent properties,
+   * such as @ref QDMI_SITE_PROPERTY_TIME_T1 or @ref
+   * QDMI_OPERATION_PROPERTY_FIDELITY, change. Clients and drivers may cache
+   * such properties as long as the epoch stays the same.
+   * @note This property is placed after the custom properties so that their
+   * values stay unchanged. Devices built before it was added reject it as
+   * being out of range, in which case no calibration epoch is available.
+   */
+  QDMI_DEVICE_PROPERTY_CALIBRATIONEPOCH,
   /**
    * @brief The maximum value of the enum.
    * @details This value can be used for bounds checks by the devices.
@@ -196,6 +207,7 @@ enum QDMI_STATUS {
   QDMI_ERROR_INVALIDARGUMENT = -7,  ///< Invalid argument.
   QDMI_ERROR_PERMISSIONDENIED = -8, ///< Permission denied.
   QDMI_ERROR_NOTSUPPORTED = -9,     ///< Operation is not supported.
+  QDMI_ERROR_TIMEOUT = -10,         ///< The operation timed out.
 };
 
 /**
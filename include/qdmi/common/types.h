@@ -25,7 +25,11 @@ SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 #include "qdmi/common/enums.h"
 
 #ifdef __cplusplus
+#include <cstddef>
+
 extern "C" {
+#else
+#include <stddef.h>
 #endif
 
 // The following disables the clang-tidy warning modernize-use-using.
@@ -62,6 +66,25 @@ typedef enum QDMI_JOB_RESULT_T QDMI_Job_Result;
 /// Type of the session parameter.
 typedef enum QDMI_SESSION_PARAMETER_T QDMI_Session_Parameter;
 
+/**
+ * @brief A single entry of a batched device property query.
+ * @details The fields @ref prop, @ref size, and @ref value have the same
+ * meaning as the corresponding parameters of a single property query. The
+ * results of the entry are returned in @ref size_ret and @ref status.
+ */
+typedef struct QDMI_Device_Property_Query_d {
+  /// [in] The property to query.
+  QDMI_Device_Property prop;
+  /// [in] The size in bytes of the memory pointed to by @ref value.
+  size_t size;
+  /// [out] The memory to write the value to, or @c NULL.
+  void *value;
+  /// [out] The actual size in bytes of the queried value.
+  size_t size_ret;
+  /// [out] The status code of the query of this entry.
+  int status;
+} QDMI_Device_Property_Query;
+
 // NOLINTEND(modernize-use-using)
 
 #ifdef __cplusplus
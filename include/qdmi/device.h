@@ -25,7 +25,8 @@ SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
  * @par
  * An implementation of a device must include this header and implement all
  * entities defined in @ref device/control.h, @ref device/query.h, and @ref
- * device/types.h.
+ * device/types.h. Optionally, it can additionally export all functions in a
+ * single table as described in @ref device/vtable.h.
  */
 
 #pragma once
@@ -36,4 +37,5 @@ SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 #include "qdmi/device/control.h"
 #include "qdmi/device/query.h"
 #include "qdmi/device/types.h"
+#include "qdmi/device/vtable.h"
 // IWYU pragma: end_exports
@@ -123,12 +123,27 @@ int QDMI_control_check_dev(QDMI_Job job, QDMI_Job_Status *status);
  * cancelled.
  * @param[in] job The job to wait for.
  * @return @ref QDMI_SUCCESS if the job is finished or cancelled.
- * @return @ref QDMI_ERROR_INVALIDARGUMENT if the job does not exist.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if the job does not exist or has not
+ * been submitted.
  * @return @ref QDMI_ERROR_FATAL if the job could not be waited for and this
  * function returns before the job has finished or has been cancelled.
  */
 int QDMI_control_wait_dev(QDMI_Job job);
 
+/**
+ * @brief Wait for a job to finish, but at most for a given time.
+ * @details This function blocks until the job has either finished or has been
+ * cancelled, or until the timeout has expired. An expired timeout does not
+ * affect the job; it keeps running and can be waited for again.
+ * @param[in] job The job to wait for.
+ * @param[in] timeout The maximum time to wait in milliseconds.
+ * @return @ref QDMI_SUCCESS if the job is finished or cancelled.
+ * @return @ref QDMI_ERROR_TIMEOUT if the timeout expired before.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if the job does not exist or has not
+ * been submitted.
+ */
+int QDMI_control_wait_for_dev(QDMI_Job job, size_t timeout);
+
 /**
  * @brief Retrieve the results of a job.
  * @details The results of a job can vary
@@ -152,6 +167,26 @@ int QDMI_control_get_data_dev(QDMI_Job job, QDMI_Job_Result result, size_t size,
  */
 void QDMI_control_free_job_dev(QDMI_Job job);
 
+/**
+ * @brief Register a callback for the completion of a job.
+ * @details The callback is invoked once the job has reached the status @ref
+ * QDMI_JOB_STATUS_DONE or @ref QDMI_JOB_STATUS_CANCELLED. If the job already
+ * has one of these states, the callback is invoked before this function
+ * returns. Otherwise, it may be invoked from any thread, including an internal
+ * thread of the device. Registering a callback replaces the previous one, and
+ * passing @c NULL removes it. The callback is not invoked anymore once @ref
+ * QDMI_control_free_job_dev has returned, and it must not free the job itself.
+ * @param[in] job The job to register the callback for.
+ * @param[in] callback The function to invoke, or @c NULL.
+ * @param[in] user_data A pointer that is passed to @p callback.
+ * @return @ref QDMI_SUCCESS if the callback was registered.
+ * @return @ref QDMI_ERROR_INVALIDARGUMENT if the job does not exist.
+ * @return @ref QDMI_ERROR_NOTSUPPORTED if the device cannot notify about the
+ * completion of jobs.
+ */
+int QDMI_control_set_callback_dev(QDMI_Job job, QDMI_Job_Callback callback,
+                                  void *user_data);
+
 /**
  * @brief Initialize a device.
  * @details A device can expect that this function is called once in the
@@ -22,6 +22,8 @@ SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #pragma once
 
+#include "qdmi/common/types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -64,6 +66,19 @@ typedef struct QDMI_Site_impl_d *QDMI_Site;
  */
 typedef struct QDMI_Operation_impl_d *QDMI_Operation;
 
+/**
+ * @brief Callback for the completion of a job.
+ * @details A callback of this type is registered with @ref
+ * QDMI_control_set_callback_dev and invoked by the device once the job has
+ * reached the status @ref QDMI_JOB_STATUS_DONE or @ref
+ * QDMI_JOB_STATUS_CANCELLED.
+ * @param job is the job that completed.
+ * @param status is the final status of the job.
+ * @param user_data is the pointer passed when registering the callback.
+ */
+typedef void (*QDMI_Job_Callback)(QDMI_Job job, QDMI_Job_Status status,
+                                  void *user_data);
+
 // NOLINTEND(modernize-use-using)
 
 #ifdef __cplusplus
@@ -0,0 +1,182 @@
+/*------------------------------------------------------------------------------
+Copyright 2024 Munich Quantum Software Stack Project
+
+Licensed under the Apache License, Version 2.0 with LLVM Exceptions (the
+"License"); you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+https://github.com/Munich-Quantum-Software-Stack/QDMI/blob/develop/LICENSE
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+License for the specific language governing permissions and limitations under
+the License.
+
+SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+------------------------------------------------------------------------------*/
+
+/** @file
+ * @brief Defines the optional function table of a QDMI device.
+ * @details Besides exporting every function of the device interface under its
+ * own symbol, a device can export all of them at once in a single table
+ * @ref QDMI_device_vtable. A driver then needs only one symbol lookup to load
+ * the device. The table is defined by placing @ref QDMI_DEVICE_VTABLE_DEFINE,
+ * or @ref QDMI_DEVICE_VTABLE_DEFINE_WITH if the device implements any of the
+ * optional functions, in the source file of the device after all functions
+ * have been declared.
+ */
+
+#pragma once
+
+#include "qdmi/common/types.h"
+#include "qdmi/device/control.h"
+#include "qdmi/device/query.h"
+#include "qdmi/device/types.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+/**
+ * @brief The version of the layout of @ref QDMI_Device_vtable.
+ * @details The version is only increased for incompatible changes of the
+ * layout. New functions are appended to the end of the table, and a driver
+ * uses @ref QDMI_Device_vtable_d::size to determine which of them are present.
+ */
+#define QDMI_DEVICE_VTABLE_VERSION 1U
+
+// The following disables the clang-tidy warning modernize-use-using.
+// Since this is C code, we cannot use the using keyword.
+// NOLINTBEGIN(modernize-use-using)
+
+/**
+ * @brief The table of all functions implemented by a device.
+ */
+typedef struct QDMI_Device_vtable_d {
+  /// The layout version, must be @ref QDMI_DEVICE_VTABLE_VERSION.
+  unsigned int version;
+  /// The size of the table in bytes as compiled by the device.
+  size_t size;
+
+  /// Function pointer to @ref QDMI_query_get_sites_dev.
+  int (*query_get_sites)(size_t num_entries, QDMI_Site *sites,
+                         size_t *num_sites);
+  /// Function pointer to @ref QDMI_query_get_operations_dev.
+  int (*query_get_operations)(size_t num_entries, QDMI_Operation *operations,
+                              size_t *num_operations);
+  /// Function pointer to @ref QDMI_query_device_property_dev.
+  int (*query_device_property)(QDMI_Device_Property prop, size_t size,
+                               void *value, size_t *size_ret);
+  /// Function pointer to @ref QDMI_query_site_property_dev.
+  int (*query_site_property)(QDMI_Site site, QDMI_Site_Property prop,
+                             size_t size, void *value, size_t *size_ret);
+  /// Function pointer to @ref QDMI_query_operation_property_dev.
+  int (*query_operation_property)(QDMI_Operation operation, size_t num_sites,
+                                  const QDMI_Site *sites,
+                                  QDMI_Operation_Property prop, size_t size,
+                                  void *value, size_t *size_ret);
+
+  /// Function pointer to @ref QDMI_control_create_job_dev.
+  int (*control_create_job)(QDMI_Program_Format format, size_t size,
+                            const void *prog, QDMI_Job *job);
+  /// Function pointer to @ref QDMI_control_set_parameter_dev.
+  int (*control_set_parameter)(QDMI_Job job, QDMI_Job_Parameter param,
+                               size_t size, const void *value);
+  /// Function pointer to @ref QDMI_control_submit_job_dev.
+  int (*control_submit_job)(QDMI_Job job);
+  /// Function pointer to @ref QDMI_control_cancel_dev.
+  int (*control_cancel)(QDMI_Job job);
+  /// Function pointer to @ref QDMI_control_check_dev.
+  int (*control_check)(QDMI_Job job, QDMI_Job_Status *status);
+  /// Function pointer to @ref QDMI_control_wait_dev.
+  int (*control_wait)(QDMI_Job job);
+  /// Function pointer to @ref QDMI_control_get_data_dev.
+  int (*control_get_data)(QDMI_Job job, QDMI_Job_Result result, size_t size,
+                          void *data, size_t *size_ret);
+  /// Function pointer to @ref QDMI_control_free_job_dev.
+  void (*control_free_job)(QDMI_Job job);
+  /// Function pointer to @ref QDMI_control_initialize_dev.
+  int (*control_initialize)(void);
+  /// Function pointer to @ref QDMI_control_finalize_dev.
+  int (*control_finalize)(void);
+
+  /// Function pointer to @ref QDMI_query_device_properties_dev.
+  int (*query_device_properties)(size_t num_queries,
+                                 QDMI_Device_Property_Query *queries);
+  /// Function pointer to @ref QDMI_query_operation_properties_dev.
+  int (*query_operation_properties)(QDMI_Operation operation,
+                                    size_t num_tuples, size_t tuple_size,
+                                    const QDMI_Site *sites,
+                                    QDMI_Operation_Property prop, size_t size,
+                                    void *values, int *status);
+  /// Function pointer to @ref QDMI_control_set_callback_dev.
+  int (*control_set_callback)(QDMI_Job job, QDMI_Job_Callback callback,
+                              void *user_data);
+  /// Function pointer to @ref QDMI_control_wait_for_dev.
+  int (*control_wait_for)(QDMI_Job job, size_t timeout);
+} QDMI_Device_vtable;
+
+// NOLINTEND(modernize-use-using)
+
+/**
+ * @brief The function table exported by a device.
+ * @details Exporting the table is optional. A device that does not define it
+ * is loaded by looking up every function separately.
+ */
+extern const QDMI_Device_vtable QDMI_device_vtable;
+
+/**
+ * @brief Define @ref QDMI_device_vtable with the functions every device must
+ * implement.
+ * @details The optional functions are left `NULL`, so that a driver does not
+ * call them. The macro must be used at file scope, followed by a semicolon.
+ */
+#define QDMI_DEVICE_VTABLE_DEFINE()                                            \
+  QDMI_DEVICE_VTABLE_DEFINE_WITH(NULL, NULL, NULL, NULL)
+
+/**
+ * @brief Define @ref QDMI_device_vtable with the required functions and the
+ * given optional functions of the device.
+ * @details Every argument is either the implementation of the respective
+ * optional function or `NULL` if the device does not implement it. The macro
+ * must be used at file scope, followed by a semicolon.
+ * @param query_device_properties @ref QDMI_query_device_properties_dev.
+ * @param query_operation_properties @ref QDMI_query_operation_properties_dev.
+ * @param control_set_callback @ref QDMI_control_set_callback_dev.
+ * @param control_wait_for @ref QDMI_control_wait_for_dev.
+ */
+#define QDMI_DEVICE_VTABLE_DEFINE_WITH(                                        \
+    query_device_properties, query_operation_properties,                       \
+    control_set_callback, control_wait_for)                                    \
+  const QDMI_Device_vtable QDMI_device_vtable = {                              \
+      QDMI_DEVICE_VTABLE_VERSION,                                              \
+      sizeof(QDMI_Device_vtable),                                              \
+      QDMI_query_get_sites_dev,                                                \
+      QDMI_query_get_operations_dev,                                           \
+      QDMI_query_device_property_dev,                                          \
+      QDMI_query_site_property_dev,                                            \
+      QDMI_query_operation_property_dev,                                       \
+      QDMI_control_create_job_dev,                                             \
+      QDMI_control_set_parameter_dev,                                          \
+      QDMI_control_submit_job_dev,                                             \
+      QDMI_control_cancel_dev,                                                 \
+      QDMI_control_check_dev,                                                  \
+      QDMI_control_wait_dev,                                                   \
+      QDMI_control_get_data_dev,                                               \
+      QDMI_control_free_job_dev,                                               \
+      QDMI_control_initialize_dev,                                             \
+      QDMI_control_finalize_dev,                                               \
+      query_device_properties,                                                 \
+      query_operation_properties,                                              \
+      control_set_callback,                                                    \
+      control_wait_for,                                                        \
+  }
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
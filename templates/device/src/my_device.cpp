@@ -124,6 +124,12 @@ int MY_QDMI_control_initialize_dev() { return QDMI_ERROR_NOTIMPLEMENTED; }
 
 int MY_QDMI_control_finalize_dev() { return QDMI_ERROR_NOTIMPLEMENTED; }
 
+// Export all functions in a single table so that a driver can load the device
+// with one symbol lookup. Once the device implements any of the optional
+// functions, e.g., MY_QDMI_control_wait_for_dev, pass them to
+// MY_QDMI_DEVICE_VTABLE_DEFINE_WITH instead.
+MY_QDMI_DEVICE_VTABLE_DEFINE();
+
 // The following line ignores the unused parameters in the functions.
 // Please remove the following code block after populating the functions.
 // NOLINTEND(misc-unused-parameters,clang-diagnostic-unused-parameter)
@@ -32,6 +32,18 @@ protected:
   void TearDown() override { MY_QDMI_control_finalize_dev(); }
 };
 
+TEST_F(QDMIImplementationTest, VtableExported) {
+  EXPECT_EQ(MY_QDMI_device_vtable.version, QDMI_DEVICE_VTABLE_VERSION);
+  EXPECT_EQ(MY_QDMI_device_vtable.size, sizeof(MY_QDMI_Device_vtable));
+  EXPECT_EQ(MY_QDMI_device_vtable.query_get_sites,
+            &MY_QDMI_query_get_sites_dev);
+  EXPECT_EQ(MY_QDMI_device_vtable.control_finalize,
+            &MY_QDMI_control_finalize_dev);
+  // the optional functions are not implemented by the template
+  EXPECT_EQ(MY_QDMI_device_vtable.control_set_callback, nullptr);
+  EXPECT_EQ(MY_QDMI_device_vtable.control_wait_for, nullptr);
+}
+
 TEST_F(QDMIImplementationTest, QueryGetSitesImplemented) {
   ASSERT_EQ(MY_QDMI_query_get_sites_dev(0, nullptr, nullptr),
             QDMI_ERROR_INVALIDARGUMENT);
@@ -19,14 +19,24 @@ SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 #include "example_fomac.hpp"
 #include "example_tool.hpp"
 #include "qdmi/client.h"
+#include "qdmi_example_driver.h"
 #include "utils/test_impl.hpp"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <complex>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <poll.h>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -134,6 +144,154 @@ TEST_P(QDMIImplementationTest, QueryGatePropertiesForEachGate) {
   }
 }
 
+TEST_P(QDMIImplementationTest, QueryDevicePropertiesBatched) {
+  size_t num_qubits = 0;
+  std::array<QDMI_Device_Property_Query, 3> queries{{
+      {QDMI_DEVICE_PROPERTY_QUBITSNUM, sizeof(size_t), &num_qubits, 0, 0},
+      {QDMI_DEVICE_PROPERTY_NAME, 0, nullptr, 0, 0},
+      {QDMI_DEVICE_PROPERTY_CUSTOM_1, 0, nullptr, 0, 0},
+  }};
+  ASSERT_EQ(
+      QDMI_query_device_properties(device, queries.size(), queries.data()),
+      QDMI_SUCCESS);
+  EXPECT_EQ(queries[0].status, QDMI_SUCCESS);
+  EXPECT_EQ(num_qubits, FoMaC(device).get_qubits_num());
+  EXPECT_EQ(queries[1].status, QDMI_SUCCESS);
+  EXPECT_GT(queries[1].size_ret, 0);
+  EXPECT_EQ(queries[2].status, QDMI_ERROR_NOTSUPPORTED);
+}
+
+TEST_P(QDMIImplementationTest, QueryOperationPropertiesBatched) {
+  const auto fomac = FoMaC(device);
+  const auto ops = fomac.get_operation_map();
+  const auto coupling_map = fomac.get_coupling_map();
+  std::vector<QDMI_Site> sites;
+  for (const auto &[control, target] : coupling_map) {
+    sites.emplace_back(control);
+    sites.emplace_back(target);
+  }
+  for (const auto &[name, op] : ops) {
+    if (fomac.get_operands_num(op) != 2) {
+      continue;
+    }
+    std::vector<double> fidelities(coupling_map.size());
+    std::vector<int> status(coupling_map.size());
+    ASSERT_EQ(QDMI_query_operation_properties(
+                  device, op, coupling_map.size(), 2, sites.data(),
+                  QDMI_OPERATION_PROPERTY_FIDELITY, sizeof(double),
+                  fidelities.data(), status.data()),
+              QDMI_SUCCESS);
+    for (size_t i = 0; i < coupling_map.size(); ++i) {
+      double fidelity = 0;
+      ASSERT_EQ(QDMI_query_operation_property(
+                    device, op, 2, &sites[2 * i],
+                    QDMI_OPERATION_PROPERTY_FIDELITY, sizeof(double),
+                    &fidelity, nullptr),
+                QDMI_SUCCESS);
+      EXPECT_EQ(status[i], QDMI_SUCCESS) << "for gate " << name;
+      EXPECT_EQ(fidelities[i], fidelity) << "for gate " << name;
+    }
+  }
+}
+
+TEST_P(QDMIImplementationTest, QueryPropertiesCached) {
+  size_t epoch = 0;
+  ASSERT_EQ(QDMI_query_device_property(device,
+                                       QDMI_DEVICE_PROPERTY_CALIBRATIONEPOCH,
+                                       sizeof(size_t), &epoch, nullptr),
+            QDMI_SUCCESS);
+  // repeated queries are answered from the cache with the same results
+  const auto fomac = FoMaC(device);
+  std::vector<std::string> names;
+  for (int i = 0; i < 2; ++i) {
+    size_t size = 0;
+    ASSERT_EQ(QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_NAME, 0,
+                                         nullptr, &size),
+              QDMI_SUCCESS);
+    std::string name(size - 1, '\0');
+    EXPECT_EQ(QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_NAME,
+                                         size - 1, name.data(), nullptr),
+              QDMI_ERROR_INVALIDARGUMENT);
+    ASSERT_EQ(QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_NAME,
+                                         size, name.data(), nullptr),
+              QDMI_SUCCESS);
+    names.emplace_back(name);
+    for (const auto &site : fomac.get_sites()) {
+      double t1 = 0;
+      ASSERT_EQ(QDMI_query_site_property(device, site,
+                                         QDMI_SITE_PROPERTY_TIME_T1,
+                                         sizeof(double), &t1, nullptr),
+                QDMI_SUCCESS);
+      EXPECT_GT(t1, 0);
+    }
+  }
+  EXPECT_EQ(names[0], names[1]);
+}
+
+TEST_P(QDMIImplementationTest, QueryPropertiesCacheInvalidated) {
+  if (GetParam().second != "CXX") {
+    GTEST_SKIP() << "Only the C++ device counts its queries and recalibrates";
+  }
+  // the C++ device reports the number of site and operation property queries
+  // it answered as a custom property
+  const auto num_device_queries = [this] {
+    size_t num = 0;
+    EXPECT_EQ(QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_CUSTOM_3,
+                                         sizeof(size_t), &num, nullptr),
+              QDMI_SUCCESS);
+    return num;
+  };
+  const auto site = FoMaC(device).get_sites().front();
+  const auto query_t1 = [this, site] {
+    double t1 = 0;
+    EXPECT_EQ(QDMI_query_site_property(device, site, QDMI_SITE_PROPERTY_TIME_T1,
+                                       sizeof(double), &t1, nullptr),
+              QDMI_SUCCESS);
+    return t1;
+  };
+
+  // only the first query reaches the device
+  const auto num_before = num_device_queries();
+  const auto t1 = query_t1();
+  const auto num_fetched = num_device_queries();
+  EXPECT_GT(num_fetched, num_before);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(query_t1(), t1);
+  }
+  EXPECT_EQ(num_device_queries(), num_fetched);
+
+  // a calibration run (program format custom 1) starts a new epoch
+  size_t epoch = 0;
+  ASSERT_EQ(QDMI_query_device_property(device,
+                                       QDMI_DEVICE_PROPERTY_CALIBRATIONEPOCH,
+                                       sizeof(size_t), &epoch, nullptr),
+            QDMI_SUCCESS);
+  QDMI_Job job = nullptr;
+  const std::string calibration = "calibrate";
+  ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_CUSTOM_1,
+                                    calibration.length() + 1,
+                                    calibration.c_str(), &job),
+            QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_submit_job(device, job), QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_wait(device, job), QDMI_SUCCESS);
+  QDMI_control_free_job(device, job);
+  size_t new_epoch = 0;
+  ASSERT_EQ(QDMI_query_device_property(device,
+                                       QDMI_DEVICE_PROPERTY_CALIBRATIONEPOCH,
+                                       sizeof(size_t), &new_epoch, nullptr),
+            QDMI_SUCCESS);
+  EXPECT_EQ(new_epoch, epoch + 1);
+
+  // the driver checks the epoch at most every 100 ms and then fetches the
+  // calibrated values once more
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_EQ(query_t1(), t1);
+  const auto num_refetched = num_device_queries();
+  EXPECT_GT(num_refetched, num_fetched);
+  EXPECT_EQ(query_t1(), t1);
+  EXPECT_EQ(num_device_queries(), num_refetched);
+}
+
 TEST_P(QDMIImplementationTest, ControlJob) {
   QDMI_Job job{};
   const std::string input = "OPENQASM 2.0;\n"
@@ -176,6 +334,560 @@ TEST_P(QDMIImplementationTest, ControlJob) {
   QDMI_control_free_job(device, job);
 }
 
+TEST_P(QDMIImplementationTest, ControlWaitFor) {
+  const std::string input = "OPENQASM 2.0;\n"
+                            "include \"qelib1.inc\";\n"
+                            "qreg q[2];\n"
+                            "h q[0];\n"
+                            "cx q[0], q[1];\n";
+  QDMI_Job job{};
+  ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(), &job),
+            QDMI_SUCCESS);
+  // enough shots to keep the job running for a while
+  const size_t shots = 1000000;
+  ASSERT_EQ(QDMI_control_set_parameter(device, job,
+                                       QDMI_JOB_PARAMETER_SHOTS_NUM,
+                                       sizeof(size_t), &shots),
+            QDMI_SUCCESS);
+  EXPECT_EQ(QDMI_control_wait_for(device, job, 0), QDMI_ERROR_INVALIDARGUMENT);
+  ASSERT_EQ(QDMI_control_submit_job(device, job), QDMI_SUCCESS);
+  EXPECT_EQ(QDMI_control_wait_for(device, job, 0), QDMI_ERROR_TIMEOUT);
+  // the job is not affected by the timeout
+  QDMI_Job_Status status{};
+  ASSERT_EQ(QDMI_control_check(device, job, &status), QDMI_SUCCESS);
+  EXPECT_NE(status, QDMI_JOB_STATUS_CANCELLED);
+  ASSERT_EQ(QDMI_control_wait_for(device, job, 60000), QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_check(device, job, &status), QDMI_SUCCESS);
+  EXPECT_EQ(status, QDMI_JOB_STATUS_DONE);
+  QDMI_control_free_job(device, job);
+
+  // timeouts beyond the range of the clock do not expire
+  for (const size_t timeout : {size_t{1} << 62U, QDMI_DRIVER_WAIT_INFINITE}) {
+    ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                      input.length() + 1, input.c_str(), &job),
+              QDMI_SUCCESS);
+    ASSERT_EQ(QDMI_control_set_parameter(device, job,
+                                         QDMI_JOB_PARAMETER_SHOTS_NUM,
+                                         sizeof(size_t), &shots),
+              QDMI_SUCCESS);
+    ASSERT_EQ(QDMI_control_submit_job(device, job), QDMI_SUCCESS);
+    EXPECT_EQ(QDMI_control_wait_for(device, job, timeout), QDMI_SUCCESS)
+        << timeout;
+    ASSERT_EQ(QDMI_control_check(device, job, &status), QDMI_SUCCESS);
+    EXPECT_EQ(status, QDMI_JOB_STATUS_DONE);
+    QDMI_control_free_job(device, job);
+  }
+}
+
+TEST_P(QDMIImplementationTest, ControlJobCompletionFd) {
+  const std::string input = "OPENQASM 2.0;\n"
+                            "include \"qelib1.inc\";\n"
+                            "qreg q[2];\n"
+                            "h q[0];\n"
+                            "cx q[0], q[1];\n";
+  std::array<QDMI_Job, 4> jobs{};
+  std::array<pollfd, 4> fds{};
+  const size_t shots = 16;
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                      input.length() + 1, input.c_str(),
+                                      &jobs[i]),
+              QDMI_SUCCESS);
+    ASSERT_EQ(QDMI_control_set_parameter(device, jobs[i],
+                                         QDMI_JOB_PARAMETER_SHOTS_NUM,
+                                         sizeof(size_t), &shots),
+              QDMI_SUCCESS);
+    ASSERT_EQ(QDMI_Driver_job_completion_fd(device, jobs[i], &fds[i].fd),
+              QDMI_SUCCESS);
+    fds[i].events = POLLIN;
+  }
+  EXPECT_EQ(QDMI_Driver_job_completion_fd(device, jobs[0], nullptr),
+            QDMI_ERROR_INVALIDARGUMENT);
+  // not yet submitted jobs are not complete
+  ASSERT_EQ(poll(fds.data(), fds.size(), 0), 0);
+  for (size_t i = 0; i + 1 < jobs.size(); ++i) {
+    ASSERT_EQ(QDMI_control_submit_job(device, jobs[i]), QDMI_SUCCESS);
+  }
+  ASSERT_EQ(QDMI_control_cancel(device, jobs.back()), QDMI_SUCCESS);
+  // wait for all jobs with a single poll loop
+  size_t num_done = 0;
+  while (num_done < jobs.size()) {
+    ASSERT_GT(poll(fds.data(), fds.size(), 10000), 0);
+    num_done = 0;
+    for (const auto &fd : fds) {
+      num_done += (fd.revents & POLLIN) != 0 ? 1 : 0;
+    }
+  }
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    QDMI_Job_Status status{};
+    ASSERT_EQ(QDMI_control_check(device, jobs[i], &status), QDMI_SUCCESS);
+    EXPECT_EQ(status, i + 1 == jobs.size() ? QDMI_JOB_STATUS_CANCELLED
+                                           : QDMI_JOB_STATUS_DONE);
+    QDMI_control_free_job(device, jobs[i]);
+  }
+}
+
+TEST_P(QDMIImplementationTest, DriverWaitJobs) {
+  const std::string input = "OPENQASM 2.0;\n"
+                            "include \"qelib1.inc\";\n"
+                            "qreg q[2];\n"
+                            "h q[0];\n"
+                            "cx q[0], q[1];\n";
+  std::array<QDMI_Job, 3> jobs{};
+  const std::array<QDMI_Device, 3> devices{device, device, device};
+  for (auto &job : jobs) {
+    ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                      input.length() + 1, input.c_str(), &job),
+              QDMI_SUCCESS);
+  }
+  std::array<int, 3> completed{};
+  EXPECT_EQ(QDMI_Driver_wait_jobs(0, devices.data(), jobs.data(),
+                                  QDMI_DRIVER_WAIT_ANY, 0, completed.data()),
+            QDMI_ERROR_INVALIDARGUMENT);
+  // none of the jobs is submitted yet
+  EXPECT_EQ(QDMI_Driver_wait_jobs(jobs.size(), devices.data(), jobs.data(),
+                                  QDMI_DRIVER_WAIT_ANY, 10, completed.data()),
+            QDMI_ERROR_TIMEOUT);
+  EXPECT_EQ(completed, (std::array<int, 3>{0, 0, 0}));
+
+  ASSERT_EQ(QDMI_control_submit_job(device, jobs[1]), QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_Driver_wait_jobs(jobs.size(), devices.data(), jobs.data(),
+                                  QDMI_DRIVER_WAIT_ANY,
+                                  QDMI_DRIVER_WAIT_INFINITE, completed.data()),
+            QDMI_SUCCESS);
+  EXPECT_EQ(completed, (std::array<int, 3>{0, 1, 0}));
+  EXPECT_EQ(QDMI_Driver_wait_jobs(jobs.size(), devices.data(), jobs.data(),
+                                  QDMI_DRIVER_WAIT_ALL, 0, completed.data()),
+            QDMI_ERROR_TIMEOUT);
+
+  ASSERT_EQ(QDMI_control_submit_job(device, jobs[0]), QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_cancel(device, jobs[2]), QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_Driver_wait_jobs(jobs.size(), devices.data(), jobs.data(),
+                                  QDMI_DRIVER_WAIT_ALL,
+                                  QDMI_DRIVER_WAIT_INFINITE, completed.data()),
+            QDMI_SUCCESS);
+  EXPECT_EQ(completed, (std::array<int, 3>{1, 1, 1}));
+  for (auto *job : jobs) {
+    QDMI_control_free_job(device, job);
+  }
+}
+
+TEST_P(QDMIImplementationTest, DriverCallStats) {
+  constexpr size_t NUM_CALLS = 10;
+  const auto query = [this] {
+    for (size_t i = 0; i < NUM_CALLS; ++i) {
+      size_t num_qubits = 0;
+      ASSERT_EQ(QDMI_query_device_property(device,
+                                           QDMI_DEVICE_PROPERTY_QUBITSNUM,
+                                           sizeof(size_t), &num_qubits,
+                                           nullptr),
+                QDMI_SUCCESS);
+    }
+  };
+  // the statistics are only recorded if requested
+  query();
+  QDMI_Driver_Call_Stats stats{};
+  ASSERT_EQ(QDMI_Driver_get_call_stats(
+                device, QDMI_DRIVER_CALL_QUERY_DEVICE_PROPERTY, &stats),
+            QDMI_SUCCESS);
+  EXPECT_EQ(stats.count, 0);
+
+  QDMI_session_free(session);
+  session = nullptr;
+  ASSERT_EQ(QDMI_Driver_shutdown(), QDMI_SUCCESS);
+  // NOLINTNEXTLINE(misc-include-cleaner) already included from `<cstdlib>`
+  setenv("QDMI_DRIVER_STATS", "1", 1);
+  const auto ret = QDMI_Driver_init();
+  // NOLINTNEXTLINE(misc-include-cleaner) already included from `<cstdlib>`
+  unsetenv("QDMI_DRIVER_STATS");
+  ASSERT_EQ(ret, QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_session_alloc(&session), QDMI_SUCCESS);
+  const std::string test_token = "test_token";
+  ASSERT_EQ(QDMI_session_set_parameter(session, QDMI_SESSION_PARAMETER_TOKEN,
+                                       test_token.length() + 1,
+                                       test_token.c_str()),
+            QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_session_get_devices(session, 1, &device, nullptr),
+            QDMI_SUCCESS);
+
+  query();
+  ASSERT_EQ(QDMI_Driver_get_call_stats(
+                device, QDMI_DRIVER_CALL_QUERY_DEVICE_PROPERTY, &stats),
+            QDMI_SUCCESS);
+  EXPECT_EQ(stats.count, NUM_CALLS);
+  EXPECT_GE(stats.total_ns, stats.max_ns);
+  uint64_t num_in_buckets = 0;
+  for (const auto bucket : stats.buckets) {
+    num_in_buckets += bucket;
+  }
+  EXPECT_EQ(num_in_buckets, stats.count);
+  EXPECT_EQ(QDMI_Driver_get_call_stats(device, QDMI_DRIVER_CALL_MAX, &stats),
+            QDMI_ERROR_INVALIDARGUMENT);
+
+  const auto stats_file = config_file_name + ".csv";
+  ASSERT_EQ(QDMI_Driver_dump_stats(stats_file.c_str()), QDMI_SUCCESS);
+  std::ifstream file(stats_file);
+  std::string header;
+  std::getline(file, header);
+  EXPECT_EQ(header.rfind("device,library,call,count", 0), 0);
+  std::string line;
+  bool found = false;
+  while (std::getline(file, line)) {
+    found |= line.find(",query_device_property,") != std::string::npos;
+  }
+  EXPECT_TRUE(found);
+  file.close();
+  std::filesystem::remove(stats_file);
+}
+
+TEST_P(QDMIImplementationTest, DriverTrace) {
+  EXPECT_EQ(QDMI_Driver_start_trace(nullptr), QDMI_ERROR_INVALIDARGUMENT);
+  const auto trace_file = config_file_name + ".json";
+  ASSERT_EQ(QDMI_Driver_start_trace(trace_file.c_str()), QDMI_SUCCESS);
+  const std::string input = "OPENQASM 2.0;\n"
+                            "include \"qelib1.inc\";\n"
+                            "qreg q[2];\n"
+                            "h q[0];\n"
+                            "cx q[0], q[1];\n";
+  QDMI_Job job{};
+  ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(), &job),
+            QDMI_SUCCESS);
+  const size_t shots = 16;
+  ASSERT_EQ(QDMI_control_set_parameter(device, job,
+                                       QDMI_JOB_PARAMETER_SHOTS_NUM,
+                                       sizeof(size_t), &shots),
+            QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_submit_job(device, job), QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_wait(device, job), QDMI_SUCCESS);
+  size_t size = 0;
+  ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS, 0,
+                                  nullptr, &size),
+            QDMI_SUCCESS);
+  std::string shot_data(size, '\0');
+  ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS, size,
+                                  shot_data.data(), nullptr),
+            QDMI_SUCCESS);
+  QDMI_control_free_job(device, job);
+  ASSERT_EQ(QDMI_Driver_stop_trace(), QDMI_SUCCESS);
+
+  std::ifstream file(trace_file);
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  file.close();
+  std::filesystem::remove(trace_file);
+  const auto trace = buffer.str();
+  EXPECT_EQ(trace.rfind(R"({"displayTimeUnit":"ns","traceEvents":[)", 0), 0);
+  EXPECT_NE(trace.find(R"("otherData":{"dropped_events":0}})"),
+            std::string::npos);
+  for (const auto *event :
+       {R"("ph":"X","name":"job")", R"("ph":"X","name":"created")",
+        R"("ph":"X","name":"submitted")", R"("ph":"X","name":"done")",
+        R"("ph":"i","name":"get_data")", R"("ph":"X","name":"wait")",
+        R"("ph":"s","name":"job")", R"("ph":"f","name":"job")"}) {
+    EXPECT_NE(trace.find(event), std::string::npos) << event;
+  }
+  // the slices of the calls span the time spent in the driver
+  const auto wait = trace.find(R"("ph":"X","name":"wait")");
+  ASSERT_NE(wait, std::string::npos);
+  const auto dur = trace.find(R"("dur":)", wait);
+  ASSERT_NE(dur, std::string::npos);
+  EXPECT_GT(std::stod(trace.substr(dur + 6, trace.find_first_of(",}", dur) -
+                                                (dur + 6))),
+            0.0);
+}
+
+TEST_P(QDMIImplementationTest, DriverParallelInit) {
+  QDMI_session_free(session);
+  ASSERT_EQ(QDMI_Driver_shutdown(), QDMI_SUCCESS);
+  // NOLINTNEXTLINE(misc-include-cleaner) already included from `<cstdlib>`
+  setenv("QDMI_DRIVER_LOAD_THREADS", "2", 1);
+  const auto ret = QDMI_Driver_init();
+  // NOLINTNEXTLINE(misc-include-cleaner) already included from `<cstdlib>`
+  unsetenv("QDMI_DRIVER_LOAD_THREADS");
+  ASSERT_EQ(ret, QDMI_SUCCESS);
+
+  ASSERT_EQ(QDMI_session_alloc(&session), QDMI_SUCCESS);
+  const std::string test_token = "test_token";
+  ASSERT_EQ(QDMI_session_set_parameter(session, QDMI_SESSION_PARAMETER_TOKEN,
+                                       test_token.length() + 1,
+                                       test_token.c_str()),
+            QDMI_SUCCESS);
+  // the devices must be in the order of the configuration file, i.e., the
+  // second device is the read-only one
+  std::array<QDMI_Device, 2> devices{};
+  ASSERT_EQ(QDMI_session_get_devices(session, 2, devices.data(), nullptr),
+            QDMI_SUCCESS);
+  for (auto *const dev : devices) {
+    uint64_t load_time = 0;
+    ASSERT_EQ(QDMI_Driver_get_load_time(dev, &load_time), QDMI_SUCCESS);
+    EXPECT_GT(load_time, 0);
+  }
+  EXPECT_EQ(QDMI_Driver_get_load_time(devices[0], nullptr),
+            QDMI_ERROR_INVALIDARGUMENT);
+  QDMI_Job job = nullptr;
+  const std::string input = "OPENQASM 2.0;\n"
+                            "include \"qelib1.inc\";\n"
+                            "qreg q[2];\n"
+                            "cx q[0], q[1];\n";
+  EXPECT_EQ(QDMI_control_create_job(devices[1], QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(), &job),
+            QDMI_ERROR_PERMISSIONDENIED);
+  ASSERT_EQ(QDMI_control_create_job(devices[0], QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(), &job),
+            QDMI_SUCCESS);
+  QDMI_control_free_job(devices[0], job);
+}
+
+TEST_P(QDMIImplementationTest, DriverLazyInit) {
+  QDMI_session_free(session);
+  ASSERT_EQ(QDMI_Driver_shutdown(), QDMI_SUCCESS);
+  // both entries refer to the same library, so the eager device can report
+  // how often the library was initialized
+  std::ofstream conf_file(config_file_name);
+  conf_file << library_name << Shared_library_file_extension() << " " << prefix
+            << " read_only eager\n";
+  conf_file << library_name << Shared_library_file_extension() << " " << prefix
+            << " read_write lazy\n";
+  conf_file.close();
+  ASSERT_EQ(QDMI_Driver_init(), QDMI_SUCCESS);
+
+  ASSERT_EQ(QDMI_session_alloc(&session), QDMI_SUCCESS);
+  const std::string test_token = "test_token";
+  ASSERT_EQ(QDMI_session_set_parameter(session, QDMI_SESSION_PARAMETER_TOKEN,
+                                       test_token.length() + 1,
+                                       test_token.c_str()),
+            QDMI_SUCCESS);
+  // handing out only the eager device does not load the lazy one
+  QDMI_Device eager = nullptr;
+  ASSERT_EQ(QDMI_session_get_devices(session, 1, &eager, nullptr),
+            QDMI_SUCCESS);
+  // the C++ device reports its number of initializations as a custom property
+  const bool counts_initializations = GetParam().second == "CXX";
+  const auto num_initialized = [eager] {
+    size_t num = 0;
+    EXPECT_EQ(QDMI_query_device_property(eager, QDMI_DEVICE_PROPERTY_CUSTOM_2,
+                                         sizeof(size_t), &num, nullptr),
+              QDMI_SUCCESS);
+    return num;
+  };
+  if (counts_initializations) {
+    EXPECT_EQ(num_initialized(), 1);
+  }
+
+  // the lazy device is loaded exactly once when it is first handed out, even
+  // if several sessions ask for it at the same time
+  constexpr size_t num_threads = 8;
+  std::array<QDMI_Device, num_threads> lazy_devices{};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&lazy_devices, &test_token, t] {
+      QDMI_Session thread_session = nullptr;
+      std::array<QDMI_Device, 2> devices{};
+      if (QDMI_session_alloc(&thread_session) == QDMI_SUCCESS &&
+          QDMI_session_set_parameter(thread_session,
+                                     QDMI_SESSION_PARAMETER_TOKEN,
+                                     test_token.length() + 1,
+                                     test_token.c_str()) == QDMI_SUCCESS &&
+          QDMI_session_get_devices(thread_session, devices.size(),
+                                   devices.data(), nullptr) == QDMI_SUCCESS) {
+        lazy_devices[t] = devices[1];
+      }
+      QDMI_session_free(thread_session);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  device = lazy_devices[0];
+  ASSERT_NE(device, nullptr);
+  for (auto *const lazy : lazy_devices) {
+    EXPECT_EQ(lazy, device);
+  }
+  if (counts_initializations) {
+    EXPECT_EQ(num_initialized(), 2);
+  }
+  uint64_t load_time = 0;
+  EXPECT_EQ(QDMI_Driver_get_load_time(device, &load_time), QDMI_SUCCESS);
+
+  size_t size = 0;
+  ASSERT_EQ(QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_NAME, 0,
+                                       nullptr, &size),
+            QDMI_SUCCESS);
+  EXPECT_GT(size, 0);
+  QDMI_Job job = nullptr;
+  const std::string input = "OPENQASM 2.0;\n"
+                            "include \"qelib1.inc\";\n"
+                            "qreg q[2];\n"
+                            "cx q[0], q[1];\n";
+  ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(), &job),
+            QDMI_SUCCESS);
+  QDMI_control_free_job(device, job);
+}
+
+TEST_P(QDMIImplementationTest, DriverReloadConfig) {
+  QDMI_session_free(session);
+  ASSERT_EQ(QDMI_Driver_shutdown(), QDMI_SUCCESS);
+  const auto library = library_name + Shared_library_file_extension();
+  std::ofstream conf_file(config_file_name);
+  conf_file << library << " " << prefix << " read_write\n";
+  conf_file.close();
+  // NOLINTNEXTLINE(misc-include-cleaner) already included from `<cstdlib>`
+  setenv("QDMI_DRIVER_RELOAD", "1", 1);
+  const auto ret = QDMI_Driver_init();
+  // NOLINTNEXTLINE(misc-include-cleaner) already included from `<cstdlib>`
+  unsetenv("QDMI_DRIVER_RELOAD");
+  ASSERT_EQ(ret, QDMI_SUCCESS);
+
+  const std::string test_token = "test_token";
+  const auto get_device = [&test_token](QDMI_Session &s, QDMI_Device &dev) {
+    ASSERT_EQ(QDMI_session_alloc(&s), QDMI_SUCCESS);
+    ASSERT_EQ(QDMI_session_set_parameter(s, QDMI_SESSION_PARAMETER_TOKEN,
+                                         test_token.length() + 1,
+                                         test_token.c_str()),
+              QDMI_SUCCESS);
+    ASSERT_EQ(QDMI_session_get_devices(s, 1, &dev, nullptr), QDMI_SUCCESS);
+  };
+  get_device(session, device);
+  QDMI_Job job = nullptr;
+  const std::string input = "OPENQASM 2.0;\n"
+                            "include \"qelib1.inc\";\n"
+                            "qreg q[2];\n"
+                            "cx q[0], q[1];\n";
+  ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(), &job),
+            QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_submit_job(device, job), QDMI_SUCCESS);
+
+  // replace the device by a read-only one
+  conf_file.open(config_file_name);
+  conf_file << library << " " << prefix << " read_only\n";
+  conf_file.close();
+  QDMI_Session new_session = nullptr;
+  QDMI_Device new_device = nullptr;
+  for (size_t i = 0; i < 500 && new_device == nullptr; ++i) {
+    QDMI_session_free(new_session);
+    get_device(new_session, new_device);
+    if (new_device == device) {
+      new_device = nullptr;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  ASSERT_NE(new_device, nullptr) << "Configuration was not reloaded";
+  QDMI_Job new_job = nullptr;
+  EXPECT_EQ(QDMI_control_create_job(new_device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(),
+                                    &new_job),
+            QDMI_ERROR_PERMISSIONDENIED);
+  QDMI_session_free(new_session);
+
+  // the removed device keeps working for the existing session
+  EXPECT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(),
+                                    &new_job),
+            QDMI_ERROR_NOTFOUND);
+  ASSERT_EQ(QDMI_control_wait(device, job), QDMI_SUCCESS);
+  QDMI_Job_Status status{};
+  ASSERT_EQ(QDMI_control_check(device, job, &status), QDMI_SUCCESS);
+  EXPECT_EQ(status, QDMI_JOB_STATUS_DONE);
+  size_t size = 0;
+  EXPECT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS, 0,
+                                  nullptr, &size),
+            QDMI_SUCCESS);
+  QDMI_control_free_job(device, job);
+
+  // the removed device is finalized once its last job has been freed
+  if (GetParam().second == "CXX") {
+    get_device(new_session, new_device);
+    size_t num_initialized = 0;
+    EXPECT_EQ(QDMI_query_device_property(new_device,
+                                         QDMI_DEVICE_PROPERTY_CUSTOM_2,
+                                         sizeof(size_t), &num_initialized,
+                                         nullptr),
+              QDMI_SUCCESS);
+    EXPECT_EQ(num_initialized, 1);
+    // and released together with the last session referring to it
+    QDMI_session_free(session);
+    session = new_session;
+  }
+}
+
+TEST_P(QDMIImplementationTest, DriverSessionOwnsDevices) {
+  // the C++ device reports its number of initializations as a custom property
+  const bool counts_initializations = GetParam().second == "CXX";
+  const auto num_initialized = [this] {
+    size_t num = 0;
+    EXPECT_EQ(QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_CUSTOM_2,
+                                         sizeof(size_t), &num, nullptr),
+              QDMI_SUCCESS);
+    return num;
+  };
+  if (counts_initializations) {
+    EXPECT_EQ(num_initialized(), 2);
+  }
+  // the session keeps the devices it obtained alive
+  ASSERT_EQ(QDMI_Driver_shutdown(), QDMI_SUCCESS);
+  size_t size = 0;
+  EXPECT_EQ(QDMI_query_device_property(device, QDMI_DEVICE_PROPERTY_NAME, 0,
+                                       nullptr, &size),
+            QDMI_SUCCESS);
+  if (counts_initializations) {
+    EXPECT_EQ(num_initialized(), 2);
+  }
+  // and releases them once it is freed
+  QDMI_session_free(session);
+  session = nullptr;
+  ASSERT_EQ(QDMI_Driver_init(), QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_session_alloc(&session), QDMI_SUCCESS);
+  const std::string test_token = "test_token";
+  ASSERT_EQ(QDMI_session_set_parameter(session, QDMI_SESSION_PARAMETER_TOKEN,
+                                       test_token.length() + 1,
+                                       test_token.c_str()),
+            QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_session_get_devices(session, 1, &device, nullptr),
+            QDMI_SUCCESS);
+  if (counts_initializations) {
+    EXPECT_EQ(num_initialized(), 2);
+  }
+}
+
+TEST_P(QDMIImplementationTest, DriverConcurrentSessions) {
+  size_t num_expected = 0;
+  ASSERT_EQ(QDMI_session_get_devices(session, 0, nullptr, &num_expected),
+            QDMI_SUCCESS);
+  std::atomic<size_t> num_failures{0};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 16; ++t) {
+    threads.emplace_back([&num_failures, num_expected] {
+      const std::string token = "test_token";
+      for (size_t i = 0; i < 50; ++i) {
+        QDMI_Session thread_session = nullptr;
+        std::array<QDMI_Device, 2> devices{};
+        size_t num_devices = 0;
+        if (QDMI_session_alloc(&thread_session) != QDMI_SUCCESS ||
+            QDMI_session_set_parameter(thread_session,
+                                       QDMI_SESSION_PARAMETER_TOKEN,
+                                       token.length() + 1,
+                                       token.c_str()) != QDMI_SUCCESS ||
+            QDMI_session_get_devices(thread_session, devices.size(),
+                                     devices.data(),
+                                     &num_devices) != QDMI_SUCCESS ||
+            num_devices != std::min(num_expected, devices.size()) ||
+            devices[0] == nullptr) {
+          ++num_failures;
+        }
+        QDMI_session_free(thread_session);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_failures.load(), 0);
+}
+
 TEST_P(QDMIImplementationTest, ToolCompile) {
   Tool tool(device);
   const auto fomac = FoMaC(device);
@@ -222,12 +934,26 @@ measure q -> c;
   EXPECT_EQ(QDMI_control_wait(dev, job), QDMI_SUCCESS);
   return job;
 }
+
+/**
+ * The number of qubits the results of a job comprise. The C++ device reports
+ * it as a custom result, while the results of the C device always comprise all
+ * of its qubits.
+ */
+size_t Get_job_qubits_num(QDMI_Device dev, QDMI_Job job) {
+  size_t num_qubits = 0;
+  if (QDMI_control_get_data(dev, job, QDMI_JOB_RESULT_CUSTOM_1, sizeof(size_t),
+                            &num_qubits, nullptr) == QDMI_SUCCESS) {
+    return num_qubits;
+  }
+  return FoMaC(dev).get_qubits_num();
+}
 } // namespace
 
 TEST_P(QDMIImplementationTest, ControlGetShots) {
-  const auto fomac = FoMaC(device);
   const size_t shots_num = 64;
   QDMI_Job job = Submit_test_job(device, shots_num);
+  const auto num_qubits = Get_job_qubits_num(device, job);
   size_t size = 0;
   ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS, 0,
                                   nullptr, &size),
@@ -241,16 +967,16 @@ TEST_P(QDMIImplementationTest, ControlGetShots) {
   std::stringstream ss(shots);
   while (std::getline(ss, token, ',')) {
     shots_vec.emplace_back(token);
-    ASSERT_EQ(token.size(), fomac.get_qubits_num());
+    ASSERT_EQ(token.size(), num_qubits);
   }
   ASSERT_EQ(shots_vec.size(), shots_num);
   QDMI_control_free_job(device, job);
 }
 
 TEST_P(QDMIImplementationTest, ControlGetHistogram) {
-  const auto fomac = FoMaC(device);
   const size_t shots_num = 64;
   QDMI_Job job = Submit_test_job(device, shots_num);
+  const auto num_qubits = Get_job_qubits_num(device, job);
 
   size_t size = 0;
   ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_HIST_KEYS, 0,
@@ -264,7 +990,7 @@ TEST_P(QDMIImplementationTest, ControlGetHistogram) {
   std::string token;
   std::stringstream ss(key_list);
   while (std::getline(ss, token, ',')) {
-    ASSERT_EQ(token.size(), fomac.get_qubits_num());
+    ASSERT_EQ(token.size(), num_qubits);
     key_vec.emplace_back(token);
   }
 
@@ -296,6 +1022,22 @@ TEST_P(QDMIImplementationTest, ControlGetHistogram) {
   }
   ASSERT_EQ(results.size(), key_vec.size());
 
+  // the counts must match the individual shots
+  size_t shots_size = 0;
+  ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS, 0,
+                                  nullptr, &shots_size),
+            QDMI_SUCCESS);
+  std::string shot_list(shots_size - 1, '\0');
+  ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS,
+                                  shots_size, shot_list.data(), nullptr),
+            QDMI_SUCCESS);
+  std::unordered_map<std::string, size_t> counts;
+  std::stringstream shots_ss(shot_list);
+  while (std::getline(shots_ss, token, ',')) {
+    ++counts[token];
+  }
+  EXPECT_EQ(counts, results);
+
   QDMI_control_free_job(device, job);
 }
 
@@ -333,8 +1075,8 @@ TEST_P(QDMIImplementationTest, ControlGetStateDense) {
 }
 
 TEST_P(QDMIImplementationTest, ControlGetStateSparse) {
-  const auto fomac = FoMaC(device);
   QDMI_Job job = Submit_test_job(device);
+  const auto num_qubits = Get_job_qubits_num(device, job);
   size_t size = 0;
   ASSERT_EQ(QDMI_control_get_data(device, job,
                                   QDMI_JOB_RESULT_STATEVECTOR_SPARSE_KEYS, 0,
@@ -349,7 +1091,7 @@ TEST_P(QDMIImplementationTest, ControlGetStateSparse) {
   std::string token;
   std::stringstream ss(key_list);
   while (std::getline(ss, token, ',')) {
-    ASSERT_EQ(token.size(), fomac.get_qubits_num());
+    ASSERT_EQ(token.size(), num_qubits);
     key_vec.emplace_back(token);
   }
 
@@ -381,15 +1123,16 @@ TEST_P(QDMIImplementationTest, ControlGetStateSparse) {
 }
 
 TEST_P(QDMIImplementationTest, ControlGetProbsDense) {
-  const auto fomac = FoMaC(device);
   QDMI_Job job = Submit_test_job(device);
 
-  std::vector<double> prob_vector(1ULL << fomac.get_qubits_num());
+  std::vector<double> prob_vector(1ULL << Get_job_qubits_num(device, job));
+  size_t size = 0;
   ASSERT_EQ(QDMI_control_get_data(device, job,
                                   QDMI_JOB_RESULT_PROBABILITIES_DENSE,
                                   sizeof(double) * prob_vector.size(),
-                                  prob_vector.data(), nullptr),
+                                  prob_vector.data(), &size),
             QDMI_SUCCESS);
+  ASSERT_EQ(size, sizeof(double) * prob_vector.size());
 
   double sum = 0;
   for (const auto &prob : prob_vector) {
@@ -401,8 +1144,8 @@ TEST_P(QDMIImplementationTest, ControlGetProbsDense) {
 }
 
 TEST_P(QDMIImplementationTest, ControlGetProbsSparse) {
-  const auto fomac = FoMaC(device);
   QDMI_Job job = Submit_test_job(device);
+  const auto num_qubits = Get_job_qubits_num(device, job);
 
   size_t size = 0;
   ASSERT_EQ(QDMI_control_get_data(device, job,
@@ -418,7 +1161,7 @@ TEST_P(QDMIImplementationTest, ControlGetProbsSparse) {
   std::string token;
   std::stringstream ss(key_list);
   while (std::getline(ss, token, ',')) {
-    ASSERT_EQ(token.size(), fomac.get_qubits_num());
+    ASSERT_EQ(token.size(), num_qubits);
     key_vec.emplace_back(token);
   }
 
@@ -449,6 +1192,262 @@ TEST_P(QDMIImplementationTest, ControlGetProbsSparse) {
   QDMI_control_free_job(device, job);
 }
 
+TEST_P(QDMIImplementationTest, ControlSimulateBellState) {
+  if (GetParam().second != "CXX") {
+    GTEST_SKIP() << "Only the C++ device simulates its programs";
+  }
+  const size_t shots_num = 256;
+  QDMI_Job job = Submit_test_job(device, shots_num);
+  // the results only comprise the qubits of the program
+  const auto num_qubits = Get_job_qubits_num(device, job);
+  ASSERT_EQ(num_qubits, 2);
+
+  std::vector<std::complex<double>> state(1ULL << num_qubits);
+  size_t size = 0;
+  ASSERT_EQ(QDMI_control_get_data(device, job,
+                                  QDMI_JOB_RESULT_STATEVECTOR_DENSE,
+                                  sizeof(std::complex<double>) * state.size(),
+                                  state.data(), &size),
+            QDMI_SUCCESS);
+  ASSERT_EQ(size, sizeof(std::complex<double>) * state.size());
+  for (size_t i = 0; i < state.size(); ++i) {
+    const double expected = i == 0 || i == 3 ? 1 / std::sqrt(2.0) : 0.0;
+    EXPECT_NEAR(state[i].real(), expected, 1e-12) << "index " << i;
+    EXPECT_NEAR(state[i].imag(), 0.0, 1e-12) << "index " << i;
+  }
+
+  ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS, 0,
+                                  nullptr, &size),
+            QDMI_SUCCESS);
+  std::string shots(size - 1, '\0');
+  ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS, size,
+                                  shots.data(), nullptr),
+            QDMI_SUCCESS);
+  const std::string zeros = "00";
+  const std::string ones = "11";
+  std::stringstream ss(shots);
+  std::string token;
+  size_t num_ones = 0;
+  while (std::getline(ss, token, ',')) {
+    ASSERT_TRUE(token == zeros || token == ones) << token;
+    if (token == ones) {
+      ++num_ones;
+    }
+  }
+  // both outcomes occur with overwhelming probability
+  EXPECT_GT(num_ones, 0);
+  EXPECT_LT(num_ones, shots_num);
+  QDMI_control_free_job(device, job);
+
+  const std::string unsupported = "OPENQASM 2.0;\n"
+                                  "include \"qelib1.inc\";\n"
+                                  "qreg q[3];\n"
+                                  "ccx q[0], q[1], q[2];\n";
+  EXPECT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    unsupported.length() + 1,
+                                    unsupported.c_str(), &job),
+            QDMI_ERROR_NOTSUPPORTED);
+  const std::string malformed = "OPENQASM 2.0;\n"
+                                "qreg q[2];\n"
+                                "rx(pi/) q[0];\n";
+  EXPECT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    malformed.length() + 1, malformed.c_str(),
+                                    &job),
+            QDMI_ERROR_INVALIDARGUMENT);
+}
+
+TEST_P(QDMIImplementationTest, ControlSimulateFusedGates) {
+  if (GetParam().second != "CXX") {
+    GTEST_SKIP() << "Only the C++ device simulates its programs";
+  }
+  // consecutive gates on the same qubits are fused before the simulation
+  const std::string input = "OPENQASM 2.0;\n"
+                            "include \"qelib1.inc\";\n"
+                            "qreg q[4];\n"
+                            "h q[0];\n"
+                            "h q[0];\n"
+                            "x q[1];\n"
+                            "cx q[1], q[2];\n"
+                            "rx(pi/2) q[0];\n"
+                            "rx(pi/2) q[0];\n"
+                            "swap q[0], q[3];\n"
+                            "rz(pi) q[2];\n"
+                            "rz(-pi) q[2];\n";
+  QDMI_Job job{};
+  ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(), &job),
+            QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_submit_job(device, job), QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_wait(device, job), QDMI_SUCCESS);
+  std::vector<std::complex<double>> state(1ULL << 4U);
+  size_t size = 0;
+  ASSERT_EQ(QDMI_control_get_data(device, job,
+                                  QDMI_JOB_RESULT_STATEVECTOR_DENSE,
+                                  sizeof(std::complex<double>) * state.size(),
+                                  state.data(), &size),
+            QDMI_SUCCESS);
+  ASSERT_EQ(size, sizeof(std::complex<double>) * state.size());
+  // qubits 1, 2, and 3 are set, and rx(pi) contributes a phase of -i
+  for (size_t i = 0; i < state.size(); ++i) {
+    const std::complex<double> expected =
+        i == 14 ? std::complex<double>(0, -1) : 0.0;
+    EXPECT_NEAR(std::abs(state[i] - expected), 0.0, 1e-12) << "index " << i;
+  }
+  QDMI_control_free_job(device, job);
+}
+
+TEST_P(QDMIImplementationTest, ControlSetNumThreads) {
+  if (GetParam().second != "CXX") {
+    GTEST_SKIP() << "Only the C++ device supports a number of threads";
+  }
+  const std::string input = "OPENQASM 2.0;\n"
+                            "include \"qelib1.inc\";\n"
+                            "qreg q[2];\n"
+                            "h q[0];\n"
+                            "cx q[0], q[1];\n";
+  QDMI_Job job{};
+  ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    input.length() + 1, input.c_str(), &job),
+            QDMI_SUCCESS);
+  const size_t num_threads = 2;
+  EXPECT_EQ(QDMI_control_set_parameter(device, job, QDMI_JOB_PARAMETER_CUSTOM_1,
+                                       sizeof(int), &num_threads),
+            QDMI_ERROR_INVALIDARGUMENT);
+  ASSERT_EQ(QDMI_control_set_parameter(device, job, QDMI_JOB_PARAMETER_CUSTOM_1,
+                                       sizeof(size_t), &num_threads),
+            QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_submit_job(device, job), QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_control_wait(device, job), QDMI_SUCCESS);
+  std::vector<double> probs(1ULL << 2U);
+  size_t size = 0;
+  ASSERT_EQ(QDMI_control_get_data(device, job,
+                                  QDMI_JOB_RESULT_PROBABILITIES_DENSE,
+                                  sizeof(double) * probs.size(), probs.data(),
+                                  &size),
+            QDMI_SUCCESS);
+  ASSERT_EQ(size, sizeof(double) * probs.size());
+  EXPECT_NEAR(probs[0], 0.5, 1e-12);
+  EXPECT_NEAR(probs[3], 0.5, 1e-12);
+  QDMI_control_free_job(device, job);
+}
+
+TEST_P(QDMIImplementationTest, ControlLoadDeviceDescription) {
+  if (GetParam().second != "CXX") {
+    GTEST_SKIP() << "Only the C++ device reads a device description";
+  }
+  // more sites than are stored in a dense matrix by the device
+  const size_t num_qubits = 200;
+  const std::string description_file_name = "qdmi_test_device.txt";
+  {
+    std::ofstream description(description_file_name);
+    description << "# a ring of qubits\nqubits " << num_qubits << "\n"
+                << "coherence 500 50000\nsite 7 400 40000\n"
+                << "duration rx 0.02\nfidelity rx 0.995\n";
+    for (size_t i = 0; i < num_qubits; ++i) {
+      description << "edge " << i << " " << ((i + 1) % num_qubits) << " 0.9";
+      if (i == 1) {
+        description << " 0.25";
+      }
+      description << "\n";
+    }
+    // a repeated coupling replaces the earlier one
+    description << "edge 4 3 0.8\n";
+  }
+  // the description is read when the device is initialized
+  QDMI_session_free(session);
+  QDMI_Driver_shutdown();
+#ifdef _WIN32
+  _putenv_s("CXX_QDMI_DEVICE_FILE", description_file_name.c_str());
+#else
+  setenv("CXX_QDMI_DEVICE_FILE", description_file_name.c_str(), 1);
+#endif
+  ASSERT_EQ(QDMI_Driver_init(), QDMI_SUCCESS);
+#ifdef _WIN32
+  _putenv_s("CXX_QDMI_DEVICE_FILE", "");
+#else
+  unsetenv("CXX_QDMI_DEVICE_FILE");
+#endif
+  std::filesystem::remove(description_file_name);
+  ASSERT_EQ(QDMI_session_alloc(&session), QDMI_SUCCESS);
+  const std::string test_token = "test_token";
+  ASSERT_EQ(QDMI_session_set_parameter(session, QDMI_SESSION_PARAMETER_TOKEN,
+                                       test_token.length() + 1,
+                                       test_token.c_str()),
+            QDMI_SUCCESS);
+  ASSERT_EQ(QDMI_session_get_devices(session, 1, &device, nullptr),
+            QDMI_SUCCESS);
+
+  const FoMaC fomac(device);
+  ASSERT_EQ(fomac.get_qubits_num(), num_qubits);
+  const auto sites = fomac.get_sites();
+  ASSERT_EQ(sites.size(), num_qubits);
+  EXPECT_EQ(fomac.get_coupling_map().size(), 2 * num_qubits);
+  double t1 = 0;
+  EXPECT_EQ(QDMI_query_site_property(device, sites[7],
+                                     QDMI_SITE_PROPERTY_TIME_T1, sizeof(double),
+                                     &t1, nullptr),
+            QDMI_SUCCESS);
+  EXPECT_DOUBLE_EQ(t1, 400);
+  EXPECT_EQ(QDMI_query_site_property(device, sites[8],
+                                     QDMI_SITE_PROPERTY_TIME_T1, sizeof(double),
+                                     &t1, nullptr),
+            QDMI_SUCCESS);
+  EXPECT_DOUBLE_EQ(t1, 500);
+  const auto operations = fomac.get_operation_map();
+  // the names in the map include their null terminator
+  const auto operation = [&operations](const std::string &name) {
+    return operations.at(name + '\0');
+  };
+  double duration = 0;
+  EXPECT_EQ(QDMI_query_operation_property(
+                device, operation("rx"), 0, nullptr,
+                QDMI_OPERATION_PROPERTY_DURATION, sizeof(double), &duration,
+                nullptr),
+            QDMI_SUCCESS);
+  EXPECT_DOUBLE_EQ(duration, 0.02);
+  const std::array edge = {sites[2], sites[1]};
+  EXPECT_EQ(QDMI_query_operation_property(
+                device, operation("cx"), 2, edge.data(),
+                QDMI_OPERATION_PROPERTY_DURATION, sizeof(double), &duration,
+                nullptr),
+            QDMI_SUCCESS);
+  EXPECT_DOUBLE_EQ(duration, 0.25);
+  const std::array repeated_edge = {sites[3], sites[4]};
+  double fidelity = 0;
+  EXPECT_EQ(QDMI_query_operation_property(
+                device, operation("cx"), 2, repeated_edge.data(),
+                QDMI_OPERATION_PROPERTY_FIDELITY, sizeof(double), &fidelity,
+                nullptr),
+            QDMI_SUCCESS);
+  EXPECT_DOUBLE_EQ(fidelity, 0.8);
+  const std::array no_edge = {sites[0], sites[50]};
+  EXPECT_EQ(QDMI_query_operation_property(
+                device, operation("cx"), 2, no_edge.data(),
+                QDMI_OPERATION_PROPERTY_FIDELITY, sizeof(double), &fidelity,
+                nullptr),
+            QDMI_ERROR_INVALIDARGUMENT);
+
+  // the shots only comprise the qubits of the program
+  QDMI_Job job = Submit_test_job(device, 16);
+  size_t size = 0;
+  ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS, 0,
+                                  nullptr, &size),
+            QDMI_SUCCESS);
+  std::string shots(size - 1, '\0');
+  ASSERT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_SHOTS, size,
+                                  shots.data(), nullptr),
+            QDMI_SUCCESS);
+  std::istringstream shots_stream(shots);
+  std::string shot;
+  size_t num_shots = 0;
+  while (std::getline(shots_stream, shot, ',')) {
+    ASSERT_TRUE(shot == "00" || shot == "11") << shot;
+    ++num_shots;
+  }
+  EXPECT_EQ(num_shots, 16);
+  QDMI_control_free_job(device, job);
+}
+
 TEST_P(QDMIImplementationTest, ControlGetShotsBufferTooSmall) {
   QDMI_Job job = Submit_test_job(device, 64);
   size_t size = 0;
@@ -111,6 +111,18 @@ TEST_P(QDMIImplementationTest, QueryOperationPropertyImplemented) {
             QDMI_ERROR_INVALIDARGUMENT);
 }
 
+TEST_P(QDMIImplementationTest, QueryDevicePropertiesImplemented) {
+  ASSERT_EQ(QDMI_query_device_properties(device, 1, nullptr),
+            QDMI_ERROR_INVALIDARGUMENT);
+}
+
+TEST_P(QDMIImplementationTest, QueryOperationPropertiesImplemented) {
+  ASSERT_EQ(QDMI_query_operation_properties(device, nullptr, 0, 0, nullptr,
+                                            QDMI_OPERATION_PROPERTY_MAX, 0,
+                                            nullptr, nullptr),
+            QDMI_ERROR_INVALIDARGUMENT);
+}
+
 namespace {
 std::string Get_test_circuit() {
   return "OPENQASM 2.0;\n"
@@ -186,6 +198,16 @@ TEST_P(QDMIImplementationTest, ControlWaitImplemented) {
   QDMI_control_free_job(device, job);
 }
 
+TEST_P(QDMIImplementationTest, ControlWaitForImplemented) {
+  QDMI_Job job = nullptr;
+  ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
+                                    Get_test_circuit().length() + 1,
+                                    Get_test_circuit().c_str(), &job),
+            QDMI_SUCCESS);
+  ASSERT_NE(QDMI_control_wait_for(device, job, 0), QDMI_ERROR_NOTIMPLEMENTED);
+  QDMI_control_free_job(device, job);
+}
+
 TEST_P(QDMIImplementationTest, ControlGetHistImplemented) {
   QDMI_Job job = nullptr;
   ASSERT_EQ(QDMI_control_create_job(device, QDMI_PROGRAM_FORMAT_QASM2,
@@ -262,6 +284,8 @@ TEST_P(QDMIImplementationTest, ControlDeviceModeReadOnly) {
   EXPECT_EQ(QDMI_control_check(device, job, nullptr),
             QDMI_ERROR_PERMISSIONDENIED);
   EXPECT_EQ(QDMI_control_wait(device, job), QDMI_ERROR_PERMISSIONDENIED);
+  EXPECT_EQ(QDMI_control_wait_for(device, job, 0),
+            QDMI_ERROR_PERMISSIONDENIED);
   EXPECT_EQ(QDMI_control_get_data(device, job, QDMI_JOB_RESULT_MAX, 0, nullptr,
                                   nullptr),
             QDMI_ERROR_PERMISSIONDENIED);